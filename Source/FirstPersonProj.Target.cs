@@ -10,6 +10,6 @@ public class FirstPersonProjTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
-		ExtraModuleNames.Add("FirstPersonProj");
+		ExtraModuleNames.AddRange(new string[] { "FirstPersonProj", "FirstPersonProjMovementCore" });
 	}
 }
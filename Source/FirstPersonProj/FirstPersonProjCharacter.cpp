@@ -9,8 +9,28 @@
 #include "EnhancedInputSubsystems.h"
 #include "Components/ArrowComponent.h"
 #include "FPMovementComponent.h"
+#include "FPLagCompensationSubsystem.h"
+#include "FPInputTape.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "GameFramework/PawnMovementComponent.h"
+#include "UObject/UObjectIterator.h"
+
+static void OnAnimTickPolicyChanged(IConsoleVariable* Variable)
+{
+	for (AFirstPersonProjCharacter* Character : TObjectRange<AFirstPersonProjCharacter>())
+	{
+		if (Character->HasActorBegunPlay())
+		{
+			Character->UpdateAnimTickPolicy();
+		}
+	}
+}
+
+static TAutoConsoleVariable<bool> CVarFPCharacterAnimTickPolicy(
+	TEXT("FPCharacter.AnimTickPolicy"),
+	true,
+	TEXT("Animate character meshes only as much as their net role and visibility need. When off, every mesh of every character is animated every frame."),
+	FConsoleVariableDelegate::CreateStatic(&OnAnimTickPolicyChanged));
 
 //////////////////////////////////////////////////////////////////////////
 // AFirstPersonProjCharacter
@@ -88,6 +108,9 @@ AFirstPersonProjCharacter::AFirstPersonProjCharacter(const FObjectInitializer& O
 
 	bUseControllerRotationPitch = false;
 	bUseControllerRotationYaw = true;
+
+	// Simulated proxies follow the server's capsule. The owning client predicts its own movement through UFPMovementComponent.
+	SetReplicatingMovement(true);
 }
 
 void AFirstPersonProjCharacter::PostInitializeComponents()
@@ -97,6 +120,10 @@ void AFirstPersonProjCharacter::PostInitializeComponents()
 	CachedBaseEyeHeight = BaseEyeHeight;
 	BaseTranslationOffset = Mesh1P->GetRelativeLocation();
 	BaseRotationOffset = Mesh1P->GetRelativeRotation().Quaternion();
+	if (Mesh3P)
+	{
+		BaseMesh3PTranslation = Mesh3P->GetRelativeLocation();
+	}
 	//MeshTranslationOffset = BaseTranslationOffset;
 }
 
@@ -113,19 +140,67 @@ void AFirstPersonProjCharacter::BeginPlay()
 			Subsystem->AddMappingContext(DefaultMappingContext, 0);
 		}
 	}
+
+	UpdateAnimTickPolicy();
+
+	// The server keeps a history of every capsule to validate shots against.
+	if (HasAuthority())
+	{
+		if (UFPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UFPLagCompensationSubsystem>())
+		{
+			LagCompensation->RegisterPawn(this);
+		}
+	}
 }
 
-void AFirstPersonProjCharacter::Tick(float DeltaTime)
+void AFirstPersonProjCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UFPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UFPLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterPawn(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AFirstPersonProjCharacter::NotifyControllerChanged()
+{
+	Super::NotifyControllerChanged();
 
-	if (Controller)
+	if (HasActorBegunPlay())
 	{
-		FRotator MeshRelativeRotation = Mesh1P->GetRelativeRotation();
-		MeshRelativeRotation.Pitch = GetControlRotation().Pitch;
-		Mesh1P->SetRelativeRotation(MeshRelativeRotation);
+		UpdateAnimTickPolicy();
 	}
+}
 
+void AFirstPersonProjCharacter::UpdateAnimTickPolicy()
+{
+	const bool bPolicyEnabled = CVarFPCharacterAnimTickPolicy.GetValueOnGameThread();
+	const bool bLocalPlayer = IsLocallyControlled() && IsPlayerControlled();
+	const bool bDedicatedServer = GetNetMode() == NM_DedicatedServer;
+
+	if (Mesh3P)
+	{
+		if (!bPolicyEnabled || (bLocalPlayer && !bDedicatedServer))
+		{
+			Mesh3P->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPose;
+			Mesh3P->bEnableUpdateRateOptimizations = false;
+		}
+		else
+		{
+			Mesh3P->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+			Mesh3P->bEnableUpdateRateOptimizations = !bDedicatedServer;
+		}
+	}
+
+	const bool bAnimateMesh1P = !bPolicyEnabled || (bLocalPlayer && !bDedicatedServer);
+	Mesh1P->bNoSkeletonUpdate = !bAnimateMesh1P;
+	Mesh1P->SetComponentTickEnabled(bAnimateMesh1P);
+}
+
+void AFirstPersonProjCharacter::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
 
 	const UFPMovementComponent* FPComp = Cast<UFPMovementComponent>(MovementComponent);
 	/*
@@ -175,27 +250,21 @@ void AFirstPersonProjCharacter::SetupPlayerInputComponent(class UInputComponent*
 
 void AFirstPersonProjCharacter::OnCameraUpdate(const FVector& CameraLocation, const FRotator& CameraRotation)
 {
-	const FMatrix DefaultMeshLS = FRotationTranslationMatrix(BaseRotationOffset.Rotator(), GetMeshTranslationOffset());
-	const FMatrix LocalToWorld = ActorToWorld().ToMatrixNoScale();
-
-	const FRotator RotCameraPitch(CameraRotation.Pitch, 0.0f, 0.0f);
-	const FRotator RotCameraYaw(0.0f, CameraRotation.Yaw, 0.0f);
-
-	// Camera transform in local space relative to the pawn. Camera position and rotation relative to the actor.
-	const FMatrix LeveledCameraLS = FRotationTranslationMatrix(RotCameraYaw, CameraLocation) * LocalToWorld.Inverse();
-	// Local camera transform with pitch added back into it.
-	const FMatrix PitchedCameraLS = FRotationMatrix(RotCameraPitch) * LeveledCameraLS;
+	// The camera pose relative to the pawn, the crouch offset and the pitch decide the arms' pose. Most frames, none of them change.
+	const FFPViewmodelInputs Inputs = FFPViewmodelInputs::Make(ActorToWorld(), CameraLocation, CameraRotation, GetMeshTranslationOffset(), BaseRotationOffset);
 
-	const FMatrix MeshRelativeToCamera = DefaultMeshLS * LeveledCameraLS.Inverse();
-	const FMatrix PitchedMesh = MeshRelativeToCamera * PitchedCameraLS;
-
-	Mesh1P->SetRelativeLocationAndRotation(PitchedMesh.GetOrigin(), PitchedMesh.Rotator());
+	FTransform MeshRelativeTransform;
+	if (ViewmodelSolver.Update(Inputs, MeshRelativeTransform))
+	{
+		Mesh1P->SetRelativeLocationAndRotation(MeshRelativeTransform.GetLocation(), MeshRelativeTransform.GetRotation());
+	}
 }
 
 void AFirstPersonProjCharacter::Move(const FInputActionValue& Value)
 {
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::Move, MovementVector);
 
 	if (Controller != nullptr)
 	{
@@ -209,6 +278,7 @@ void AFirstPersonProjCharacter::Look(const FInputActionValue& Value)
 {
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::Look, LookAxisVector);
 
 	if (Controller != nullptr)
 	{
@@ -220,11 +290,14 @@ void AFirstPersonProjCharacter::Look(const FInputActionValue& Value)
 
 void AFirstPersonProjCharacter::Jump(const FInputActionValue& Value)
 {
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::Jump);
 	bWasJumpPressed = true;
 }
 
 void AFirstPersonProjCharacter::CrouchPressed(const FInputActionValue& Value)
 {
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::CrouchPressed);
+
 	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
 	check(MoveComp);
 	MoveComp->SetWantsToCrouch(true);
@@ -232,6 +305,8 @@ void AFirstPersonProjCharacter::CrouchPressed(const FInputActionValue& Value)
 
 void AFirstPersonProjCharacter::CrouchReleased(const FInputActionValue& Value)
 {
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::CrouchReleased);
+
 	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
 	check(MoveComp);
 	MoveComp->SetWantsToCrouch(false);
@@ -239,6 +314,8 @@ void AFirstPersonProjCharacter::CrouchReleased(const FInputActionValue& Value)
 
 void AFirstPersonProjCharacter::SprintPressed(const FInputActionValue& Value)
 {
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::SprintPressed);
+
 	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
 	check(MoveComp);
 	MoveComp->SetWantsToSprint(true);
@@ -246,11 +323,44 @@ void AFirstPersonProjCharacter::SprintPressed(const FInputActionValue& Value)
 
 void AFirstPersonProjCharacter::SprintReleased(const FInputActionValue& Value)
 {
+	UFPInputTapeSubsystem::RecordInput(this, EFPInputTapeEvent::SprintReleased);
+
 	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
 	check(MoveComp);
 	MoveComp->SetWantsToSprint(false);
 }
 
+void AFirstPersonProjCharacter::ApplyTapeInput(EFPInputTapeEvent Event, const FVector2D& Value)
+{
+	const FInputActionValue ActionValue(Value);
+	switch (Event)
+	{
+		case EFPInputTapeEvent::Move:
+			Move(ActionValue);
+			break;
+		case EFPInputTapeEvent::Look:
+			Look(ActionValue);
+			break;
+		case EFPInputTapeEvent::Jump:
+			Jump(ActionValue);
+			break;
+		case EFPInputTapeEvent::CrouchPressed:
+			CrouchPressed(ActionValue);
+			break;
+		case EFPInputTapeEvent::CrouchReleased:
+			CrouchReleased(ActionValue);
+			break;
+		case EFPInputTapeEvent::SprintPressed:
+			SprintPressed(ActionValue);
+			break;
+		case EFPInputTapeEvent::SprintReleased:
+			SprintReleased(ActionValue);
+			break;
+		default:
+			break;
+	}
+}
+
 void AFirstPersonProjCharacter::OnJumped()
 {
 	--JumpsRemaining;
@@ -289,18 +399,44 @@ void AFirstPersonProjCharacter::RecalculateBaseEyeHeight()
 	BaseEyeHeight = FMath::Lerp(CachedBaseEyeHeight, CrouchEyeHeight, MoveComp->GetCrouchFrac());
 }
 
+void AFirstPersonProjCharacter::FaceRotation(FRotator NewControlRotation, float DeltaTime)
+{
+	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
+	if (MoveComp && MoveComp->IsActive())
+	{
+		MoveComp->DeferFaceRotation(NewControlRotation);
+		return;
+	}
+
+	Super::FaceRotation(NewControlRotation, DeltaTime);
+}
+
 FVector AFirstPersonProjCharacter::GetPawnViewLocation() const
 {
 	UFPMovementComponent* MoveComp = Cast<UFPMovementComponent>(MovementComponent);
 	check(MoveComp);
 	if (MoveComp->IsFalling())
 	{
-		return GetActorLocation() + FVector(0.0f, 0.0f, BaseEyeHeight);
+		return GetActorLocation() + VisualInterpolationOffset + FVector(0.0f, 0.0f, BaseEyeHeight);
 	}
 
 	const float StandingHeight = CachedBaseEyeHeight + MoveComp->GetDefaultCapsuelHalfHeight();
 	const float CrouchHeight = CrouchEyeHeight + MoveComp->GetCrouchedHalfHeight();
-	return (FVector::UpVector * FMath::Lerp(StandingHeight, CrouchHeight, MoveComp->GetCrouchFrac())) + GetPawnFootLocation();
+	return (FVector::UpVector * FMath::Lerp(StandingHeight, CrouchHeight, MoveComp->GetCrouchFrac())) + GetPawnFootLocation() + VisualInterpolationOffset;
+}
+
+void AFirstPersonProjCharacter::OnVisualInterpolationOffsetChanged(const FVector& NewOffset)
+{
+	if (VisualInterpolationOffset.Equals(NewOffset))
+	{
+		return;
+	}
+
+	VisualInterpolationOffset = NewOffset;
+	if (Mesh3P)
+	{
+		Mesh3P->SetRelativeLocation(BaseMesh3PTranslation + GetActorQuat().UnrotateVector(VisualInterpolationOffset));
+	}
 }
 
 FVector AFirstPersonProjCharacter::GetPawnFootLocation() const
@@ -342,4 +478,13 @@ void AFirstPersonProjCharacter::SetHasRifle(bool bNewHasRifle)
 bool AFirstPersonProjCharacter::GetHasRifle()
 {
 	return bHasRifle;
+}
+
+void AFirstPersonProjCharacter::ServerFire_Implementation(const FVector_NetQuantizeNormal& AimDirection)
+{
+	// The shot starts where the server has the pawn's view, not where the client says it fired from.
+	if (UFPLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UFPLagCompensationSubsystem>())
+	{
+		LagCompensation->ValidateFire(this, GetPawnViewLocation(), AimDirection);
+	}
 }
\ No newline at end of file
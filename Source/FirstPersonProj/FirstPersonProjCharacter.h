@@ -5,8 +5,12 @@
 #include "CoreMinimal.h"
 #include "InputActionValue.h"
 #include "Engine/EngineTypes.h"
+#include "Engine/NetSerialization.h"
+#include "FPViewmodel.h"
 #include "FirstPersonProjCharacter.generated.h"
 
+enum class EFPInputTapeEvent : uint8;
+
 class UInputComponent;
 class USkeletalMeshComponent;
 class UCapsuleComponent;
@@ -73,9 +77,24 @@ public:
 protected:
 	virtual void BeginPlay();
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void Tick(float DeltaTime) override;
 
+	/** Possession changes who the meshes are animated for. */
+	virtual void NotifyControllerChanged() override;
+
 public:
+
+	/**
+	 * Choose how Mesh3P and Mesh1P animate, from the net mode and who controls the pawn.
+	 *    - Local players: Mesh3P always ticks its pose and Mesh1P animates.
+	 *    - Everyone else: Mesh3P only ticks montages while not rendered, and uses update rate optimizations when far away. Mesh1P, which only its owner sees, doesn't animate.
+	 *    - Dedicated servers: nothing is rendered, so only montages tick, for their notifies.
+	 * With FPCharacter.AnimTickPolicy off, every pawn animates every mesh every frame, for comparison.
+	 */
+	void UpdateAnimTickPolicy();
+
 		
 	/** Look Input Action */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
@@ -93,6 +112,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Weapon)
 	bool GetHasRifle();
 
+	/** Sent by the weapon when it fires. The server validates a shot from the pawn's view along AimDirection, against the other pawns where the shooter saw them. */
+	UFUNCTION(Server, Reliable)
+	void ServerFire(const FVector_NetQuantizeNormal& AimDirection);
+
 	/** Returns Mesh subobject **/
 	FORCEINLINE class USkeletalMeshComponent* GetMesh() const { return Mesh3P; }
 
@@ -163,12 +186,24 @@ protected:
 
 	FVector GetMeshTranslationOffset() const;
 
+	/** Poses Mesh1P from the camera in OnCameraUpdate. */
+	FFPViewmodelSolver ViewmodelSolver;
+
 public:
 
 	bool CanCharacterJump() const;
 
 	bool ConsumeJumpInput();
 
+	/** Returns true if jump was pressed and not consumed by movement yet. */
+	bool IsJumpInputPending() const { return bWasJumpPressed; }
+
+	/** Set the pending jump press, e.g. when the server or a replay simulates a move where jump was pressed. */
+	void SetJumpInputPending(bool bPending) { bWasJumpPressed = bPending; }
+
+	/** Call the input handler for a recorded input tape event, as if the input action had fired. */
+	void ApplyTapeInput(EFPInputTapeEvent Event, const FVector2D& Value);
+
 	void OnJumped();
 
 	void OnLanded(const FHitResult& HitResult);
@@ -179,10 +214,25 @@ public:
 
 	virtual void RecalculateBaseEyeHeight() override;
 
+	/** Left to the movement component while it is active, so the rotation is applied in the same scoped update as the movement. */
+	virtual void FaceRotation(FRotator NewControlRotation, float DeltaTime = 0.f) override;
+
 	virtual FVector GetPawnViewLocation() const override;
 
 	FVector GetPawnFootLocation() const;
 
+	/** Called by the movement component when the capsule's interpolated visual position moves away from its simulated one. */
+	void OnVisualInterpolationOffsetChanged(const FVector& NewOffset);
+
+protected:
+
+	/** World space offset from the capsule to where the pawn is drawn. Applied to the view and to Mesh3P. Mesh1P follows the view. */
+	FVector VisualInterpolationOffset = FVector::ZeroVector;
+
+	/** Saved translation of Mesh3P relative to the capsule. */
+	UPROPERTY(Transient)
+	FVector BaseMesh3PTranslation;
+
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(UInputComponent* InputComponent) override;
@@ -3,6 +3,7 @@
 #include "FirstPersonProjProjectile.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "FPProjectilePool.h"
 
 AFirstPersonProjProjectile::AFirstPersonProjProjectile() 
 {
@@ -38,6 +39,50 @@ void AFirstPersonProjProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* Oth
 	{
 		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
 
+		Expire();
+	}
+}
+
+void AFirstPersonProjProjectile::LifeSpanExpired()
+{
+	Expire();
+}
+
+void AFirstPersonProjProjectile::Expire()
+{
+	if (Pool)
+	{
+		Pool->Release(this);
+	}
+	else
+	{
 		Destroy();
 	}
+}
+
+void AFirstPersonProjProjectile::FireFromPool(const FVector& Location, const FRotator& Rotation)
+{
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// ReturnToPool only zeroed the velocity, and Deactivate stopped the tick. But a projectile that came to rest after bouncing was stopped by
+	// the movement component itself, which clears its updated component, so set it again. It has to be set before the velocity, which is
+	// rotated into world space by the updated component. Then start over at InitialSpeed along the new facing, as InitializeComponent does on spawn.
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->SetVelocityInLocalSpace(FVector(ProjectileMovement->InitialSpeed, 0.0f, 0.0f));
+	ProjectileMovement->Activate(true);
+
+	SetLifeSpan(InitialLifeSpan);
+}
+
+void AFirstPersonProjProjectile::ReturnToPool()
+{
+	SetLifeSpan(0.0f);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 class USphereComponent;
 class UProjectileMovementComponent;
+class UFPProjectilePoolSubsystem;
 
 UCLASS(config=Game)
 class AFirstPersonProjProjectile : public AActor
@@ -29,9 +30,28 @@ public:
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/** Belong to Pool, which this projectile goes back to instead of being destroyed. */
+	void SetPool(UFPProjectilePoolSubsystem* InPool) { Pool = InPool; }
+
+	/** Fire again from Location, as a freshly spawned projectile would. */
+	void FireFromPool(const FVector& Location, const FRotator& Rotation);
+
+	/** Hide and stop the projectile while it waits in the pool. */
+	void ReturnToPool();
+
+	virtual void LifeSpanExpired() override;
+
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+protected:
+
+	/** Go back to the pool if pooled, or be destroyed. */
+	void Expire();
+
+	UPROPERTY(Transient)
+	UFPProjectilePoolSubsystem* Pool = nullptr;
 };
 
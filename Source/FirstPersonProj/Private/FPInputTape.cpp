@@ -0,0 +1,411 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPInputTape.h"
+#include "FPMovementComponent.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace FPInputTapeFormat
+{
+	static constexpr uint32 Magic = 0x54495046; // "FPIT"
+	static constexpr uint32 Version = 1;
+}
+
+FArchive& operator<<(FArchive& Ar, FFPInputTapeFrame& Frame)
+{
+	Ar << Frame.Timestamp;
+	Ar << Frame.DeltaTime;
+	Ar << Frame.EventMask;
+
+	if (Frame.HasEvent(EFPInputTapeEvent::Move))
+	{
+		Ar << Frame.MoveValue;
+	}
+
+	if (Frame.HasEvent(EFPInputTapeEvent::Look))
+	{
+		Ar << Frame.LookValue;
+	}
+
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FFPInputTape& Tape)
+{
+	uint32 Magic = FPInputTapeFormat::Magic;
+	uint32 Version = FPInputTapeFormat::Version;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != FPInputTapeFormat::Magic || Version != FPInputTapeFormat::Version)
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Tape.MapName;
+	Ar << Tape.StartLocation;
+	Ar << Tape.StartRotation;
+	Ar << Tape.StartControlRotation;
+	Ar << Tape.StartVelocity;
+
+	uint8 StartFlags = (Tape.bStartWantsToCrouch ? 1 : 0) | (Tape.bStartWantsToSprint ? 2 : 0);
+	Ar << StartFlags;
+	Tape.bStartWantsToCrouch = (StartFlags & 1) != 0;
+	Tape.bStartWantsToSprint = (StartFlags & 2) != 0;
+
+	Ar << Tape.Frames;
+	Ar << Tape.EndLocation;
+	return Ar;
+}
+
+bool FFPInputTape::SaveToFile(const FString& Path) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Writer << const_cast<FFPInputTape&>(*this);
+	return !Writer.IsError() && FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool FFPInputTape::LoadFromFile(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Reader << *this;
+	return !Reader.IsError();
+}
+
+FString FFPInputTape::GetTapePath(const FString& Name)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputTapes"), Name + TEXT(".fptape"));
+}
+
+bool UFPInputTapeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFPInputTapeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UFPInputTapeSubsystem::OnWorldTickStart);
+
+	if (GetWorld()->WorldType == EWorldType::Game)
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("FPInputTape="), PendingReplayName);
+	}
+}
+
+void UFPInputTapeSubsystem::Deinitialize()
+{
+	StopReplay();
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+
+	Super::Deinitialize();
+}
+
+bool UFPInputTapeSubsystem::StartRecording(AFirstPersonProjCharacter* Pawn)
+{
+	if (Mode != EMode::Idle || !Pawn)
+	{
+		return false;
+	}
+
+	Tape = FFPInputTape();
+	Tape.MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	Tape.StartLocation = Pawn->GetActorLocation();
+	Tape.StartRotation = Pawn->GetActorRotation();
+	Tape.StartControlRotation = Pawn->GetControlRotation();
+	Tape.StartVelocity = Pawn->GetVelocity();
+	if (const UFPMovementComponent* MoveComp = Pawn->GetCharacterMovement<UFPMovementComponent>())
+	{
+		Tape.bStartWantsToCrouch = MoveComp->GetWantsToCrouch();
+		Tape.bStartWantsToSprint = MoveComp->GetWantsToSprint();
+	}
+
+	TapePawn = Pawn;
+	Mode = EMode::Recording;
+	UE_LOG(LogFPMovement, Display, TEXT("Recording input tape on %s"), *Tape.MapName);
+	return true;
+}
+
+bool UFPInputTapeSubsystem::StopRecording(const FString& Path)
+{
+	if (Mode != EMode::Recording)
+	{
+		return false;
+	}
+
+	Mode = EMode::Idle;
+	Tape.EndLocation = TapePawn.IsValid() ? TapePawn->GetActorLocation() : FVector::ZeroVector;
+	TapePawn.Reset();
+
+	if (!Tape.SaveToFile(Path))
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("Couldn't write input tape to %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogFPMovement, Display, TEXT("Saved input tape with %d frames (%.2fs, %lld bytes) to %s"),
+		Tape.Frames.Num(), Tape.GetDuration(), IFileManager::Get().FileSize(*Path), *Path);
+	return true;
+}
+
+bool UFPInputTapeSubsystem::StartReplay(const FFPInputTape& InTape, AFirstPersonProjCharacter* Pawn, bool bInQuitWhenDone)
+{
+	if (Mode != EMode::Idle || !Pawn || InTape.Frames.IsEmpty())
+	{
+		return false;
+	}
+
+	const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	if (InTape.MapName != MapName)
+	{
+		UE_LOG(LogFPMovement, Warning, TEXT("Replaying an input tape recorded on %s in %s. It won't follow the same path."), *InTape.MapName, *MapName);
+	}
+
+	Tape = InTape;
+	TapePawn = Pawn;
+
+	Pawn->SetActorLocationAndRotation(Tape.StartLocation, Tape.StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (AController* Controller = Pawn->GetController())
+	{
+		Controller->SetControlRotation(Tape.StartControlRotation);
+	}
+	if (UFPMovementComponent* MoveComp = Pawn->GetCharacterMovement<UFPMovementComponent>())
+	{
+		MoveComp->Velocity = Tape.StartVelocity;
+		MoveComp->SetWantsToCrouch(Tape.bStartWantsToCrouch);
+		MoveComp->SetWantsToSprint(Tape.bStartWantsToSprint);
+	}
+
+	// Every engine frame from here runs with the delta of the tape frame it replays.
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(Tape.Frames[0].DeltaTime);
+
+	ReplayFrame = 0;
+	ReplayStartFrameCounter = GFrameCounter;
+	ReplayStartWallTime = FPlatformTime::Seconds();
+	bQuitWhenDone = bInQuitWhenDone;
+	Mode = EMode::Replaying;
+
+	UE_LOG(LogFPMovement, Display, TEXT("Replaying input tape: %d frames, %.2fs"), Tape.Frames.Num(), Tape.GetDuration());
+	return true;
+}
+
+void UFPInputTapeSubsystem::StopReplay()
+{
+	if (Mode != EMode::Replaying)
+	{
+		return;
+	}
+
+	Mode = EMode::Idle;
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	const double WallTime = FPlatformTime::Seconds() - ReplayStartWallTime;
+	const float EndError = TapePawn.IsValid() ? FVector::Dist(TapePawn->GetActorLocation(), Tape.EndLocation) : -1.0f;
+	UE_LOG(LogFPMovement, Display, TEXT("Input tape replay: %d of %d frames, %.2fs simulated in %.2fs (%.3f ms/frame). Ended %.2f cm from the recorded end location."),
+		ReplayFrame, Tape.Frames.Num(), Tape.GetDuration(), WallTime, ReplayFrame > 0 ? WallTime * 1000.0 / ReplayFrame : 0.0, EndError);
+
+	TapePawn.Reset();
+
+	if (bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UFPInputTapeSubsystem::RecordInput(const AFirstPersonProjCharacter* Pawn, EFPInputTapeEvent Event, const FVector2D& Value)
+{
+	UWorld* World = Pawn ? Pawn->GetWorld() : nullptr;
+	UFPInputTapeSubsystem* Subsystem = World ? World->GetSubsystem<UFPInputTapeSubsystem>() : nullptr;
+	if (!Subsystem || !Subsystem->IsRecording() || Subsystem->TapePawn.Get() != Pawn || Subsystem->Tape.Frames.IsEmpty())
+	{
+		return;
+	}
+
+	FFPInputTapeFrame& Frame = Subsystem->Tape.Frames.Last();
+	Frame.AddEvent(Event);
+	if (Event == EFPInputTapeEvent::Move)
+	{
+		Frame.MoveValue = FVector2f(Value);
+	}
+	else if (Event == EFPInputTapeEvent::Look)
+	{
+		Frame.LookValue = FVector2f(Value);
+	}
+}
+
+void UFPInputTapeSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	if (!PendingReplayName.IsEmpty())
+	{
+		AFirstPersonProjCharacter* Pawn = Cast<AFirstPersonProjCharacter>(UGameplayStatics::GetPlayerPawn(World, 0));
+		if (!Pawn)
+		{
+			return;
+		}
+
+		const FString Path = FFPInputTape::GetTapePath(PendingReplayName);
+		PendingReplayName.Reset();
+
+		FFPInputTape LoadedTape;
+		if (!LoadedTape.LoadFromFile(Path) || !StartReplay(LoadedTape, Pawn, true))
+		{
+			UE_LOG(LogFPMovement, Error, TEXT("Couldn't replay input tape %s"), *Path);
+			FPlatformMisc::RequestExit(false);
+		}
+		return;
+	}
+
+	switch (Mode)
+	{
+		case EMode::Recording:
+		{
+			if (!TapePawn.IsValid())
+			{
+				UE_LOG(LogFPMovement, Warning, TEXT("Input tape recording stopped, the recorded pawn is gone."));
+				Mode = EMode::Idle;
+				return;
+			}
+
+			// Input handlers run during this tick and add to this frame.
+			const float Timestamp = Tape.GetDuration();
+			FFPInputTapeFrame& Frame = Tape.Frames.AddDefaulted_GetRef();
+			Frame.Timestamp = Timestamp;
+			Frame.DeltaTime = DeltaSeconds;
+			break;
+		}
+		case EMode::Replaying:
+		{
+			if (GFrameCounter <= ReplayStartFrameCounter)
+			{
+				return;
+			}
+
+			if (!TapePawn.IsValid() || ReplayFrame >= Tape.Frames.Num())
+			{
+				StopReplay();
+				return;
+			}
+
+			FeedReplayFrame(Tape.Frames[ReplayFrame]);
+			++ReplayFrame;
+
+			if (ReplayFrame < Tape.Frames.Num())
+			{
+				FApp::SetFixedDeltaTime(Tape.Frames[ReplayFrame].DeltaTime);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void UFPInputTapeSubsystem::FeedReplayFrame(const FFPInputTapeFrame& Frame)
+{
+	AFirstPersonProjCharacter* Pawn = TapePawn.Get();
+	for (uint8 EventIndex = 0; EventIndex < static_cast<uint8>(EFPInputTapeEvent::Num); ++EventIndex)
+	{
+		const EFPInputTapeEvent Event = static_cast<EFPInputTapeEvent>(EventIndex);
+		if (Frame.HasEvent(Event))
+		{
+			const FVector2f Value = Event == EFPInputTapeEvent::Move ? Frame.MoveValue : Event == EFPInputTapeEvent::Look ? Frame.LookValue : FVector2f::ZeroVector;
+			Pawn->ApplyTapeInput(Event, FVector2D(Value));
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPInputTapeCommands
+{
+	static UFPInputTapeSubsystem* GetSubsystem(UWorld* World)
+	{
+		return World ? World->GetSubsystem<UFPInputTapeSubsystem>() : nullptr;
+	}
+
+	static FString GetTapeName(const TArray<FString>& Args)
+	{
+		return Args.Num() > 0 ? Args[0] : FString(TEXT("Tape"));
+	}
+
+	static void Record(const TArray<FString>& Args, UWorld* World)
+	{
+		UFPInputTapeSubsystem* Subsystem = GetSubsystem(World);
+		AFirstPersonProjCharacter* Pawn = World ? Cast<AFirstPersonProjCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)) : nullptr;
+		if (!Subsystem || !Subsystem->StartRecording(Pawn))
+		{
+			UE_LOG(LogFPMovement, Warning, TEXT("FPMovement.InputTape.Record needs a game world with a player pawn and no recording or replay running."));
+		}
+	}
+
+	static void Stop(const TArray<FString>& Args, UWorld* World)
+	{
+		UFPInputTapeSubsystem* Subsystem = GetSubsystem(World);
+		if (!Subsystem)
+		{
+			return;
+		}
+
+		if (Subsystem->IsReplaying())
+		{
+			Subsystem->StopReplay();
+		}
+		else
+		{
+			Subsystem->StopRecording(FFPInputTape::GetTapePath(GetTapeName(Args)));
+		}
+	}
+
+	static void Replay(const TArray<FString>& Args, UWorld* World)
+	{
+		UFPInputTapeSubsystem* Subsystem = GetSubsystem(World);
+		AFirstPersonProjCharacter* Pawn = World ? Cast<AFirstPersonProjCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)) : nullptr;
+		const FString Path = FFPInputTape::GetTapePath(GetTapeName(Args));
+
+		FFPInputTape Tape;
+		if (!Subsystem || !Tape.LoadFromFile(Path) || !Subsystem->StartReplay(Tape, Pawn, false))
+		{
+			UE_LOG(LogFPMovement, Warning, TEXT("Couldn't replay input tape %s"), *Path);
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs RecordCommand(
+		TEXT("FPMovement.InputTape.Record"),
+		TEXT("Starts recording the player's input to an input tape."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Record));
+
+	static FAutoConsoleCommandWithWorldAndArgs StopCommand(
+		TEXT("FPMovement.InputTape.Stop"),
+		TEXT("Stops a replay, or stops recording and saves the tape to Saved/InputTapes. Usage: FPMovement.InputTape.Stop [Name=Tape]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Stop));
+
+	static FAutoConsoleCommandWithWorldAndArgs ReplayCommand(
+		TEXT("FPMovement.InputTape.Replay"),
+		TEXT("Replays an input tape from Saved/InputTapes on the player pawn. Usage: FPMovement.InputTape.Replay [Name=Tape]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Replay));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,388 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPLagCompensationSubsystem.h"
+#include "FPMovementComponent.h"
+#include "FPMovementStats.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerState.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_FPLagCompensationRecord, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_FPLagCompensationRewind, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensation Pawns"), STAT_FPLagCompensationPawns, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensation Shots"), STAT_FPLagCompensationShots, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Lag Compensation Hits"), STAT_FPLagCompensationHits, STATGROUP_FPMovement);
+
+static TAutoConsoleVariable<int32> CVarFPMovementLagCompensation(
+	TEXT("FPMovement.LagCompensation"),
+	1,
+	TEXT("If non-zero, the server records every pawn's capsule each tick so shots can be validated where the shooter saw their target."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLagCompensationMaxRewindTime(
+	TEXT("FPMovement.LagCompensation.MaxRewindTime"),
+	0.25f,
+	TEXT("Longest time in seconds a shot may be rewound. Clients with a higher ping are validated against older positions than they saw."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLagCompensationInterpDelay(
+	TEXT("FPMovement.LagCompensation.InterpDelay"),
+	0.0f,
+	TEXT("Seconds clients draw remote pawns behind the latest position replicated to them, added to half the shooter's round trip time when rewinding.\n")
+	TEXT("Simulated proxies snap to replicated movement, so this is 0 unless they are interpolated."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLagCompensationMaxShotRange(
+	TEXT("FPMovement.LagCompensation.MaxShotRange"),
+	10000.0f,
+	TEXT("Distance in cm a shot is validated up to."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLagCompensationBudgetMs(
+	TEXT("FPMovement.LagCompensation.BudgetMs"),
+	0.05f,
+	TEXT("Time in milliseconds a rewind of every pawn should fit in. FPMovement.LagCompensation.Benchmark reports against it."));
+
+int32 FFPCapsuleHistory::AddSlot()
+{
+	if (!FreeSlots.IsEmpty())
+	{
+		const int32 Slot = FreeSlots.Pop(false);
+		Slots[Slot] = FSlot();
+		return Slot;
+	}
+
+	const int32 Slot = Slots.AddDefaulted();
+	Times.AddZeroed(Capacity);
+	Samples.AddDefaulted(Capacity);
+	return Slot;
+}
+
+void FFPCapsuleHistory::RemoveSlot(int32 Slot)
+{
+	Slots[Slot] = FSlot();
+	FreeSlots.Add(Slot);
+}
+
+void FFPCapsuleHistory::Push(int32 Slot, double Time, const FFPCapsuleSample& Sample)
+{
+	FSlot& SlotData = Slots[Slot];
+	if (SlotData.Count > 0 && Time <= Times[GetSampleOffset(Slot, SlotData.Count - 1)])
+	{
+		return;
+	}
+
+	if (SlotData.Count == Capacity)
+	{
+		SlotData.First = (SlotData.First + 1) % Capacity;
+		--SlotData.Count;
+	}
+
+	const int32 Offset = GetSampleOffset(Slot, SlotData.Count);
+	Times[Offset] = Time;
+	Samples[Offset] = Sample;
+	++SlotData.Count;
+}
+
+int32 FFPCapsuleHistory::FindSample(int32 Slot, double Time) const
+{
+	// First sample newer than Time. The one before it is the answer.
+	int32 Low = 0;
+	int32 High = Slots[Slot].Count;
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (Times[GetSampleOffset(Slot, Mid)] <= Time)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	return Low - 1;
+}
+
+bool FFPCapsuleHistory::Sample(int32 Slot, double Time, FFPCapsuleSample& OutSample) const
+{
+	const int32 Count = Slots[Slot].Count;
+	if (Count == 0)
+	{
+		return false;
+	}
+
+	const int32 Index = FindSample(Slot, Time);
+	if (Index < 0 || Index == Count - 1)
+	{
+		OutSample = Samples[GetSampleOffset(Slot, Index < 0 ? 0 : Index)];
+		return true;
+	}
+
+	const int32 FromOffset = GetSampleOffset(Slot, Index);
+	const int32 ToOffset = GetSampleOffset(Slot, Index + 1);
+	const FFPCapsuleSample& From = Samples[FromOffset];
+	const FFPCapsuleSample& To = Samples[ToOffset];
+	const float Alpha = static_cast<float>((Time - Times[FromOffset]) / (Times[ToOffset] - Times[FromOffset]));
+
+	OutSample.Location = FMath::Lerp(From.Location, To.Location, Alpha);
+	OutSample.Rotation = FQuat4f::FastLerp(From.Rotation, To.Rotation, Alpha).GetNormalized();
+	OutSample.HalfHeight = FMath::Lerp(From.HalfHeight, To.HalfHeight, Alpha);
+	OutSample.Radius = FMath::Lerp(From.Radius, To.Radius, Alpha);
+	return true;
+}
+
+TStatId UFPLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+bool UFPLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFPLagCompensationSubsystem::RegisterPawn(AFirstPersonProjCharacter* Pawn)
+{
+	if (!Pawn || Pawns.ContainsByPredicate([Pawn](const FPawnEntry& Entry) { return Entry.Pawn == Pawn; }))
+	{
+		return;
+	}
+
+	FPawnEntry& Entry = Pawns.AddDefaulted_GetRef();
+	Entry.Pawn = Pawn;
+	Entry.Slot = History.AddSlot();
+}
+
+void UFPLagCompensationSubsystem::UnregisterPawn(AFirstPersonProjCharacter* Pawn)
+{
+	const int32 Index = Pawns.IndexOfByPredicate([Pawn](const FPawnEntry& Entry) { return Entry.Pawn == Pawn; });
+	if (Index != INDEX_NONE)
+	{
+		History.RemoveSlot(Pawns[Index].Slot);
+		Pawns.RemoveAtSwap(Index);
+	}
+}
+
+double UFPLagCompensationSubsystem::GetServerTime() const
+{
+	return GetWorld()->GetTimeSeconds();
+}
+
+double UFPLagCompensationSubsystem::GetRewindTime(const AController* Shooter) const
+{
+	const APlayerState* PlayerState = Shooter ? Shooter->GetPlayerState<APlayerState>() : nullptr;
+	const double RoundTripTime = PlayerState ? PlayerState->GetPingInMilliseconds() / 1000.0 : 0.0;
+
+	// The shooter saw positions that took half a round trip to reach them, drawn InterpDelay behind those.
+	const double RewindTime = RoundTripTime * 0.5 + CVarFPMovementLagCompensationInterpDelay.GetValueOnGameThread();
+	return GetServerTime() - FMath::Min(RewindTime, static_cast<double>(CVarFPMovementLagCompensationMaxRewindTime.GetValueOnGameThread()));
+}
+
+void UFPLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only the server validates shots. Ticking after the actor tick groups means every pawn has moved this frame.
+	if (GetWorld()->GetNetMode() == NM_Client || CVarFPMovementLagCompensation.GetValueOnGameThread() == 0)
+	{
+		return;
+	}
+
+	RecordSamples(GetServerTime());
+}
+
+void UFPLagCompensationSubsystem::RecordSamples(double Time)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPLagCompensationRecord);
+
+	for (int32 Index = Pawns.Num() - 1; Index >= 0; --Index)
+	{
+		const AFirstPersonProjCharacter* Pawn = Pawns[Index].Pawn.Get();
+		if (!Pawn)
+		{
+			History.RemoveSlot(Pawns[Index].Slot);
+			Pawns.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Pawn->GetCapsuleComponent();
+		FFPCapsuleSample Sample;
+		Sample.Location = FVector3f(Capsule->GetComponentLocation());
+		Sample.Rotation = FQuat4f(Capsule->GetComponentQuat());
+		Sample.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		Sample.Radius = Capsule->GetScaledCapsuleRadius();
+		History.Push(Pawns[Index].Slot, Time, Sample);
+	}
+
+	SET_DWORD_STAT(STAT_FPLagCompensationPawns, Pawns.Num());
+}
+
+bool UFPLagCompensationSubsystem::GetCapsuleAtTime(const AFirstPersonProjCharacter* Pawn, double Time, FFPRewoundCapsule& OutCapsule) const
+{
+	const FPawnEntry* Entry = Pawns.FindByPredicate([Pawn](const FPawnEntry& Other) { return Other.Pawn == Pawn; });
+	if (!Entry || !History.Sample(Entry->Slot, Time, OutCapsule.Capsule))
+	{
+		return false;
+	}
+
+	OutCapsule.Pawn = Entry->Pawn.Get();
+	return true;
+}
+
+void UFPLagCompensationSubsystem::RewindAll(double Time, TArray<FFPRewoundCapsule>& OutCapsules) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPLagCompensationRewind);
+
+	OutCapsules.Reset(Pawns.Num());
+	for (const FPawnEntry& Entry : Pawns)
+	{
+		FFPRewoundCapsule Rewound;
+		Rewound.Pawn = Entry.Pawn.Get();
+		if (Rewound.Pawn && History.Sample(Entry.Slot, Time, Rewound.Capsule))
+		{
+			OutCapsules.Add(Rewound);
+		}
+	}
+}
+
+AFirstPersonProjCharacter* UFPLagCompensationSubsystem::ValidateShot(double Time, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FVector& OutHitLocation) const
+{
+	// The world as it is now. Pawns are left out, since only their rewound capsules count.
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FPLagCompensationShot), true, IgnoredActor);
+	FCollisionObjectQueryParams ObjectQueryParams;
+	ObjectQueryParams.AddObjectTypesToQuery(ECC_WorldStatic);
+	ObjectQueryParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	FHitResult WorldHit;
+	const FVector ShotEnd = GetWorld()->LineTraceSingleByObjectType(WorldHit, Start, End, ObjectQueryParams, QueryParams) ? WorldHit.Location : End;
+
+	TArray<FFPRewoundCapsule> Capsules;
+	RewindAll(Time, Capsules);
+
+	AFirstPersonProjCharacter* HitPawn = nullptr;
+	double HitDistanceSquared = TNumericLimits<double>::Max();
+	for (const FFPRewoundCapsule& Rewound : Capsules)
+	{
+		if (Rewound.Pawn == IgnoredActor)
+		{
+			continue;
+		}
+
+		// A capsule is every point within Radius of the segment between its hemisphere centers.
+		const FFPCapsuleSample& Capsule = Rewound.Capsule;
+		const FVector Location(Capsule.Location);
+		const FVector AxisExtent = FVector(Capsule.Rotation.GetUpVector()) * FMath::Max(Capsule.HalfHeight - Capsule.Radius, 0.0f);
+		FVector ShotPoint;
+		FVector AxisPoint;
+		FMath::SegmentDistToSegmentSafe(Start, ShotEnd, Location - AxisExtent, Location + AxisExtent, ShotPoint, AxisPoint);
+
+		const double DistanceSquared = FVector::DistSquared(Start, ShotPoint);
+		if (FVector::DistSquared(ShotPoint, AxisPoint) <= FMath::Square(Capsule.Radius) && DistanceSquared < HitDistanceSquared)
+		{
+			HitPawn = Rewound.Pawn;
+			HitDistanceSquared = DistanceSquared;
+			OutHitLocation = ShotPoint;
+		}
+	}
+
+	return HitPawn;
+}
+
+AFirstPersonProjCharacter* UFPLagCompensationSubsystem::ValidateFire(AFirstPersonProjCharacter* Shooter, const FVector& Start, const FVector& Direction)
+{
+	if (CVarFPMovementLagCompensation.GetValueOnGameThread() == 0)
+	{
+		return nullptr;
+	}
+
+	INC_DWORD_STAT(STAT_FPLagCompensationShots);
+
+	const FVector End = Start + Direction.GetSafeNormal() * CVarFPMovementLagCompensationMaxShotRange.GetValueOnGameThread();
+	FVector HitLocation;
+	AFirstPersonProjCharacter* HitPawn = ValidateShot(GetRewindTime(Shooter->GetController()), Start, End, Shooter, HitLocation);
+	if (HitPawn)
+	{
+		INC_DWORD_STAT(STAT_FPLagCompensationHits);
+		UE_LOG(LogFPMovement, Verbose, TEXT("%s hit %s at %s"), *Shooter->GetName(), *HitPawn->GetName(), *HitLocation.ToString());
+		OnShotHit.Broadcast(Shooter, HitPawn, HitLocation);
+	}
+	return HitPawn;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPLagCompensationBenchmark
+{
+	static void Report(const TArray<FString>& Args, UWorld* World)
+	{
+		const UFPLagCompensationSubsystem* Subsystem = World ? World->GetSubsystem<UFPLagCompensationSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			return;
+		}
+
+		UE_LOG(LogFPMovement, Display, TEXT("Lag compensation: %s, %d pawns recorded, %d samples of history each (%d bytes per pawn)"),
+			CVarFPMovementLagCompensation.GetValueOnGameThread() != 0 ? TEXT("enabled") : TEXT("disabled"), Subsystem->GetNumRegisteredPawns(),
+			FFPCapsuleHistory::Capacity, FFPCapsuleHistory::Capacity * static_cast<int32>(sizeof(double) + sizeof(FFPCapsuleSample)));
+	}
+
+	/** Fills synthetic histories for N pawns at 60 Hz and times full rewind passes at random times within them. */
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 NumPawns = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 64;
+		const int32 NumPasses = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+		constexpr double SampleInterval = 1.0 / 60.0;
+
+		FRandomStream RandomStream(0x4C43);
+		FFPCapsuleHistory History;
+		TArray<int32> Slots;
+		for (int32 PawnIndex = 0; PawnIndex < NumPawns; ++PawnIndex)
+		{
+			const int32 Slot = History.AddSlot();
+			Slots.Add(Slot);
+
+			FFPCapsuleSample Sample;
+			Sample.Location = FVector3f(RandomStream.GetUnitVector() * 5000.0f);
+			Sample.Radius = 34.0f;
+			for (int32 SampleIndex = 0; SampleIndex < FFPCapsuleHistory::Capacity; ++SampleIndex)
+			{
+				Sample.Location += FVector3f(RandomStream.FRandRange(-10.0f, 10.0f), RandomStream.FRandRange(-10.0f, 10.0f), 0.0f);
+				Sample.Rotation = FRotator3f(0.0f, RandomStream.FRandRange(-180.0f, 180.0f), 0.0f).Quaternion();
+				Sample.HalfHeight = RandomStream.FRand() < 0.2f ? 44.0f : 88.0f;
+				History.Push(Slot, SampleIndex * SampleInterval, Sample);
+			}
+		}
+
+		const double HistoryDuration = (FFPCapsuleHistory::Capacity - 1) * SampleInterval;
+		TArray<FFPCapsuleSample> Rewound;
+		Rewound.SetNumUninitialized(NumPawns);
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			const double Time = RandomStream.FRand() * HistoryDuration;
+			for (int32 PawnIndex = 0; PawnIndex < NumPawns; ++PawnIndex)
+			{
+				History.Sample(Slots[PawnIndex], Time, Rewound[PawnIndex]);
+			}
+		}
+		const double PassMs = ((FPlatformTime::Seconds() - StartTime) * 1000.0) / NumPasses;
+		const float BudgetMs = CVarFPMovementLagCompensationBudgetMs.GetValueOnGameThread();
+
+		UE_LOG(LogFPMovement, Display, TEXT("FPMovement.LagCompensation.Benchmark: %d pawns, %d samples each, %d passes: %.4f ms per rewind pass, %.1f ns per pawn. %s the %.3f ms budget."),
+			NumPawns, FFPCapsuleHistory::Capacity, NumPasses, PassMs, PassMs * 1000000.0 / NumPawns,
+			PassMs <= BudgetMs ? TEXT("Within") : TEXT("Over"), BudgetMs);
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ReportCommand(
+		TEXT("FPMovement.LagCompensation.Report"),
+		TEXT("Logs the number of pawns with recorded capsule history and the memory each one uses."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Report));
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("FPMovement.LagCompensation.Benchmark"),
+		TEXT("Times rewinding every pawn's capsule against FPMovement.LagCompensation.BudgetMs. Usage: FPMovement.LagCompensation.Benchmark [PawnCount=64] [Passes=1000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
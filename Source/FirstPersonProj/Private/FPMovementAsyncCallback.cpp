@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementAsyncCallback.h"
+
+void FFPMovementAsyncCallback::OnPreSimulate_Internal()
+{
+	const FFPMovementAsyncInput* Input = GetConsumerInput_Internal();
+	if (!Input)
+	{
+		return;
+	}
+
+	const float DeltaTime = GetDeltaTime_Internal();
+	FFPMovementAsyncOutput& Output = GetProducerOutputData_Internal();
+	Output.Pawns.Reset(Input->Pawns.Num());
+
+	// Steps after the first one for the same input carry on from the previous step, instead of integrating the same state again.
+	const bool bChainSteps = Input->Frame == ChainedFrame && ChainedStates.Num() == Input->Pawns.Num();
+	ChainedFrame = Input->Frame;
+	ChainedStates.SetNum(Input->Pawns.Num());
+
+	for (int32 Index = 0; Index < Input->Pawns.Num(); ++Index)
+	{
+		const FFPMovementAsyncInput::FPawnInput& PawnInput = Input->Pawns[Index];
+		FFPMovementAsyncOutput::FPawnOutput& PawnOutput = Output.Pawns.AddDefaulted_GetRef();
+		PawnOutput.Component = PawnInput.Component;
+		PawnOutput.Job = PawnInput.Job;
+		PawnOutput.Job.DeltaTime = DeltaTime;
+		if (bChainSteps)
+		{
+			PawnOutput.Job.State = ChainedStates[Index];
+		}
+		FPMovementCore::RunKernel(PawnOutput.Job, PawnInput.Tunables);
+		ChainedStates[Index] = PawnOutput.Job.Result;
+	}
+}
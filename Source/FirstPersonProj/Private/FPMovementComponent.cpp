@@ -6,6 +6,210 @@
 #include "FirstPersonProj/FirstPersonProjCharacter.h"
 #include "GameFramework/PhysicsVolume.h"
 #include "GameFramework/Character.h"
+#include "FPMovementStats.h"
+#include "FPMovementProfile.h"
+#include "FPMovementSubsystem.h"
+#include "FPTraversability.h"
+#include "Net/UnrealNetwork.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DEFINE_LOG_CATEGORY(LogFPMovement);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Precomputed Kernel Hits"), STAT_FPMovementPrecomputedHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Precomputed Kernel Misses"), STAT_FPMovementPrecomputedMisses, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Kernel Hits"), STAT_FPMovementAsyncKernelHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Kernel Misses"), STAT_FPMovementAsyncKernelMisses, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Substeps"), STAT_FPMovementFixedSubsteps, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fixed Substep Time Dropped"), STAT_FPMovementFixedSubstepsDropped, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Saved Moves"), STAT_FPMovementNetSavedMoves, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Moves Sent"), STAT_FPMovementNetMovesSent, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Moves Resent"), STAT_FPMovementNetMovesResent, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Moves Combined"), STAT_FPMovementNetMovesCombined, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Corrections Sent"), STAT_FPMovementNetCorrections, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Replayed Moves"), STAT_FPMovementNetReplayedMoves, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Skipped Ticks"), STAT_FPMovementLODSkippedTicks, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Cache Hits"), STAT_FPMovementFloorCacheHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Cache Misses"), STAT_FPMovementFloorCacheMisses, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Sweeps"), STAT_FPMovementFloorSweeps, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Floor Sweeps Avoided"), STAT_FPMovementFloorSweepsAvoided, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Floor Results Used"), STAT_FPMovementAsyncFloorHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Floor Fallbacks"), STAT_FPMovementAsyncFloorFallbacks, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Headroom Results Used"), STAT_FPMovementAsyncHeadroomHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Headroom Fallbacks"), STAT_FPMovementAsyncHeadroomFallbacks, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Updates"), STAT_FPMovementUpdates, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sweeps"), STAT_FPMovementSweeps, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Line Traces"), STAT_FPMovementLineTraces, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overlap Tests"), STAT_FPMovementOverlaps, STATGROUP_FPMovement);
+// Every SafeMoveUpdatedComponent/MoveUpdatedComponent, including the ones made by the engine's SlideAlongSurface and StepUp.
+DECLARE_DWORD_COUNTER_STAT(TEXT("Capsule Moves"), STAT_FPMovementCapsuleMoves, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Based Moves"), STAT_FPMovementBasedMoves, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred Component Updates"), STAT_FPMovementDeferredUpdates, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scoped Update Commits"), STAT_FPMovementScopedUpdateCommits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mode Iterations"), STAT_FPMovementModeIterations, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Mode Iteration Cap Hits"), STAT_FPMovementModeIterationCapHits, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Slide Iterations"), STAT_FPMovementSlideIterations, STATGROUP_FPMovement);
+
+DECLARE_CYCLE_STAT(TEXT("PerformMovement"), STAT_FPMovementPerformMovement, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Walk Movement"), STAT_FPMovementWalk, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Slide Movement"), STAT_FPMovementSlide, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Fall Movement"), STAT_FPMovementFall, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("NavWalk Movement"), STAT_FPMovementNavWalk, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("FindFloor"), STAT_FPMovementFindFloor, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("StepUp"), STAT_FPMovementStepUp, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("SlideAlongSurface"), STAT_FPMovementSlideAlongSurface, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("TickCrouch"), STAT_FPMovementTickCrouch, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("CanCharacterUncrouch"), STAT_FPMovementCanUncrouch, STATGROUP_FPMovement);
+
+static TAutoConsoleVariable<float> CVarFPMovementMaxInterpolationOffset(
+	TEXT("FPMovement.FixedTimestep.MaxInterpolationOffset"),
+	100.0f,
+	TEXT("Largest distance in cm the capsule is drawn away from its simulated location when interpolating between fixed substeps. Larger jumps snap."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLODReducedInterval(
+	TEXT("FPMovement.LOD.ReducedInterval"),
+	1.0f / 20.0f,
+	TEXT("Seconds between movement updates for pawns in the reduced movement LOD."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLODMinimalInterval(
+	TEXT("FPMovement.LOD.MinimalInterval"),
+	1.0f / 5.0f,
+	TEXT("Seconds between movement updates for pawns in the minimal movement LOD."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLODPromotionHoldTime(
+	TEXT("FPMovement.LOD.PromotionHoldTime"),
+	1.0f,
+	TEXT("Seconds a pawn stays at full movement rate after input or a movement mode change promoted it."));
+
+static TAutoConsoleVariable<float> CVarFPMovementNetMaxLocationError(
+	TEXT("FPMovement.Net.MaxLocationError"),
+	3.0f,
+	TEXT("Distance in cm between the client's and the server's result of a move beyond which the server sends a correction."));
+
+static TAutoConsoleVariable<float> CVarFPMovementNetMaxMoveDeltaTime(
+	TEXT("FPMovement.Net.MaxMoveDeltaTime"),
+	0.125f,
+	TEXT("Longest delta time in seconds the server accepts for a single client move."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementFloorCache(
+	TEXT("FPMovement.FloorCache"),
+	1,
+	TEXT("If non-zero, FindFloor reuses the last swept floor while the pawn stays close to it on a static primitive."));
+
+static TAutoConsoleVariable<float> CVarFPMovementFloorCacheMaxDisplacement(
+	TEXT("FPMovement.FloorCache.MaxDisplacement"),
+	5.0f,
+	TEXT("Distance in cm the capsule may move away from the last floor sweep before the cached floor is swept again."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementAsyncQueries(
+	TEXT("FPMovement.AsyncQueries"),
+	0,
+	TEXT("If non-zero, the end of move floor check and the uncrouch headroom check are queued as async sweeps and consumed on the next tick.\n")
+	TEXT("A synchronous query is used whenever the pending result is missing or no longer valid."));
+
+static TAutoConsoleVariable<float> CVarFPMovementAsyncQueriesMaxDisplacement(
+	TEXT("FPMovement.AsyncQueries.MaxDisplacement"),
+	10.0f,
+	TEXT("Distance in cm the capsule may move between queuing an async query and consuming it before the result is discarded."));
+
+#if ENABLE_DRAW_DEBUG
+static TAutoConsoleVariable<bool> CVarFPMovementDebugUncrouch(
+	TEXT("FPMovement.Debug.Uncrouch"),
+	false,
+	TEXT("Draw where the headroom sweep was blocked whenever a synchronous uncrouch check fails."));
+#endif // ENABLE_DRAW_DEBUG
+
+/** One call per scene query, capsule move or slide iteration, counting it in the stat group and in the benchmark profile together. */
+namespace QueryStats
+{
+	static void RecordSweep()
+	{
+		INC_DWORD_STAT(STAT_FPMovementSweeps);
+		FPMovementProfile::CountSweep();
+	}
+
+	static void RecordLineTrace()
+	{
+		INC_DWORD_STAT(STAT_FPMovementLineTraces);
+		FPMovementProfile::CountQuery();
+	}
+
+	static void RecordOverlap()
+	{
+		INC_DWORD_STAT(STAT_FPMovementOverlaps);
+		FPMovementProfile::CountQuery();
+	}
+
+	static void RecordMove(bool bDeferred)
+	{
+		INC_DWORD_STAT(STAT_FPMovementCapsuleMoves);
+		INC_DWORD_STAT_BY(STAT_FPMovementDeferredUpdates, bDeferred ? 1 : 0);
+		FPMovementProfile::CountMove();
+	}
+
+	static void RecordSlideIteration()
+	{
+		INC_DWORD_STAT(STAT_FPMovementSlideIterations);
+		FPMovementProfile::CountSlideIteration();
+	}
+}
+
+/** Floor cache counters. The totals kept here are only read back by FPMovement.FloorCache.Report, which the stat system can't do. */
+namespace FloorCacheStats
+{
+	static uint64 NumHits = 0;
+	static uint64 NumMisses = 0;
+	static uint64 NumSweepsAvoided = 0;
+	static uint64 NumSweeps = 0;
+	static double LastReportTime = 0.0;
+
+	static void RecordSweepAvoided()
+	{
+		++NumSweepsAvoided;
+		INC_DWORD_STAT(STAT_FPMovementFloorSweepsAvoided);
+	}
+
+	static void RecordHit()
+	{
+		++NumHits;
+		INC_DWORD_STAT(STAT_FPMovementFloorCacheHits);
+		RecordSweepAvoided();
+	}
+
+	static void RecordMiss()
+	{
+		++NumMisses;
+		INC_DWORD_STAT(STAT_FPMovementFloorCacheMisses);
+	}
+
+	/** The floor sweep is a sweep like any other, so this counts it in QueryStats as well. */
+	static void RecordSweep()
+	{
+		++NumSweeps;
+		INC_DWORD_STAT(STAT_FPMovementFloorSweeps);
+		QueryStats::RecordSweep();
+	}
+
+#if !UE_BUILD_SHIPPING
+	static FAutoConsoleCommand ReportCommand(
+		TEXT("FPMovement.FloorCache.Report"),
+		TEXT("Print the floor cache hit rate and the floor sweeps avoided per second since the last report."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const double Now = FPlatformTime::Seconds();
+			const double Elapsed = LastReportTime > 0.0 ? Now - LastReportTime : 0.0;
+			const uint64 NumLookups = NumHits + NumMisses;
+
+			UE_LOG(LogFPMovement, Display, TEXT("Floor cache: %llu hits, %llu misses (%.1f%% hit rate), %llu floor sweeps run, %llu avoided (%.1f/s over %.1fs)"),
+				NumHits, NumMisses, NumLookups > 0 ? 100.0 * NumHits / NumLookups : 0.0,
+				NumSweeps, NumSweepsAvoided, Elapsed > 0.0 ? NumSweepsAvoided / Elapsed : 0.0, Elapsed);
+
+			NumHits = NumMisses = NumSweepsAvoided = NumSweeps = 0;
+			LastReportTime = Now;
+		}));
+#endif // !UE_BUILD_SHIPPING
+}
 
 const float UFPMovementComponent::MIN_FLOOR_DIST = 1.9f;
 const float UFPMovementComponent::MAX_FLOOR_DIST = 2.4f;
@@ -14,6 +218,7 @@ const float UFPMovementComponent::SWEEP_EDGE_REJECT_DISTANCE = 0.15f;
 
 UFPMovementComponent::UFPMovementComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
+	SetIsReplicatedByDefault(true);
 
 	GravityScale = 1.f;
 	GroundFriction = 8.0f;
@@ -39,138 +244,929 @@ void UFPMovementComponent::PostLoad()
 {
 	Super::PostLoad();
 
-	PawnOwner = Cast<AFirstPersonProjCharacter>(GetOwner());
+	PawnOwner = Cast<AFirstPersonProjCharacter>(GetOwner());
+}
+
+void UFPMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	PreviousSubstepLocation = UpdatedComponent->GetComponentLocation();
+
+	FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+
+	if (CurrentFloor.IsWalkableFloor())
+	{
+		StartGroundMovement();
+	}
+
+	if (UFPMovementSubsystem* MovementSubsystem = GetWorld()->GetSubsystem<UFPMovementSubsystem>())
+	{
+		MovementSubsystem->RegisterComponent(this);
+	}
+
+	TraversabilitySubsystem = GetWorld()->GetSubsystem<UFPTraversabilitySubsystem>();
+}
+
+void UFPMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetMovementBase(nullptr);
+
+	if (UFPMovementSubsystem* MovementSubsystem = GetWorld()->GetSubsystem<UFPMovementSubsystem>())
+	{
+		MovementSubsystem->UnregisterComponent(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFPMovementComponent::InitializeComponent()
+{
+	SetMovementMode(EFPMovementMode::Falling);
+
+	if (PawnOwner)
+	{
+		AFirstPersonProjCharacter* FPPCharacter = Cast<AFirstPersonProjCharacter>(PawnOwner);
+		check(FPPCharacter);
+		const UCapsuleComponent* CharacterCapsule = FPPCharacter->GetCapsuleComponent();
+		CachedDefaultCapsuleHalfHeight = CharacterCapsule->GetUnscaledCapsuleHalfHeight();
+		CachedOwnerChar = FPPCharacter;
+
+		CachedMinimumSlideSpeedSquared = StartSlideSpeedMinimum * StartSlideSpeedMinimum;
+		CachedSlideSpeedThresholdSquared = SlideSpeedThreshold * SlideSpeedThreshold;
+	}
+}
+
+void UFPMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	TickMovement(DeltaTime, ConsumeInputVector());
+}
+
+#if WITH_EDITOR
+void UFPMovementComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	const FProperty* PropertyThatChanged = PropertyChangedEvent.MemberProperty;
+	if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(UFPMovementComponent, WalkableFloorAngle))
+	{
+		// Compute WalkableFloorZ from the Angle.
+		SetWalkableFloorAngle(WalkableFloorAngle);
+	}
+	else if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(UFPMovementComponent, SlideFloorAngle))
+	{
+		// Compute WalkableFloorZ from the Angle.
+		SetSlidableFloorAngle(SlideFloorAngle);
+	}
+}
+#endif // WITH_EDITOR
+
+bool UFPMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	QueryStats::RecordMove(UpdatedComponent->IsDeferringMovementUpdates());
+	const bool bMoved = Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+	if (OutHit && OutHit->bBlockingHit)
+	{
+		PendingTelemetryFlags |= EFPMovementTelemetryFlags::BlockingHit;
+		++NumBlockingHits;
+	}
+	return bMoved;
+}
+
+AFirstPersonProjCharacter* UFPMovementComponent::GetFPPOwner() const
+{
+	return Cast<AFirstPersonProjCharacter>(GetPawnOwner());
+}
+
+float UFPMovementComponent::GetWalkableFloorAngle() const
+{
+	return WalkableFloorAngle;
+}
+
+void UFPMovementComponent::SetWalkableFloorAngle(float InWalkableFloorAngle)
+{
+	WalkableFloorAngle = InWalkableFloorAngle;
+	WalkableFloorZ = FMath::Cos(FMath::DegreesToRadians(InWalkableFloorAngle));
+
+	// The cached floor's walkability was decided with the old angle.
+	InvalidateFloorCache();
+}
+
+float UFPMovementComponent::GetWalkableFloorZ() const
+{
+	return WalkableFloorZ;
+}
+
+void UFPMovementComponent::SetWalkableFloorZ(float InWalkableFloorZ)
+{
+	WalkableFloorZ = InWalkableFloorZ;
+	WalkableFloorAngle = FMath::RadiansToDegrees(FMath::Acos(InWalkableFloorZ));
+
+	InvalidateFloorCache();
+}
+
+void UFPMovementComponent::TickMovement(const float DeltaTime, const FVector& InputVector)
+{
+	LastInputVector = InputVector;
+
+	switch (PawnOwner ? PawnOwner->GetLocalRole() : ROLE_Authority)
+	{
+		case ROLE_AutonomousProxy:
+			ReplicateMoveToServer(DeltaTime, InputVector);
+			break;
+		case ROLE_SimulatedProxy:
+			// Follows the replicated movement from the server.
+			break;
+		default:
+			// A pawn controlled by a remote client only moves when its ServerMove arrives.
+			if (!PawnOwner || PawnOwner->GetRemoteRole() != ROLE_AutonomousProxy)
+			{
+				SimulateMovement(DeltaTime, InputVector);
+				UpdateReplicatedState();
+			}
+			break;
+	}
+
+	// Async results were integrated for this update only.
+	AsyncKernelResults.Reset();
+}
+
+void UFPMovementComponent::SimulateMovement(const float FrameDeltaTime, const FVector& InputVector)
+{
+	// Children (meshes, weapon) follow the capsule and overlaps are updated once, when the scope ends, instead of after every move of the tick.
+	// Nested in a replay's scope, this one commits nothing.
+	INC_DWORD_STAT_BY(STAT_FPMovementScopedUpdateCommits, UpdatedComponent->IsDeferringMovementUpdates() ? 0 : 1);
+	FScopedMovementUpdate ScopedUpdate(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+
+	ApplyPendingFaceRotation();
+
+	float DeltaTime;
+	if (!ConsumeLODTime(FrameDeltaTime, InputVector, DeltaTime))
+	{
+		return;
+	}
+
+	SimulateMovementSteps(DeltaTime, InputVector);
+}
+
+void UFPMovementComponent::SimulateMovementSteps(const float DeltaTime, const FVector& InputVector)
+{
+	if (!bUseFixedTimestep)
+	{
+		PerformMovement(DeltaTime, InputVector);
+		return;
+	}
+
+	// Input is consumed once per frame and applies to every substep run for it.
+	const float Timestep = GetFixedTimestep();
+	TimestepAccumulator += DeltaTime;
+
+	int32 NumSubsteps = 0;
+	while (TimestepAccumulator >= Timestep && NumSubsteps < MaxSubsteps)
+	{
+		PreviousSubstepLocation = UpdatedComponent->GetComponentLocation();
+		PerformMovement(Timestep, InputVector);
+		TimestepAccumulator -= Timestep;
+		++NumSubsteps;
+	}
+
+	INC_DWORD_STAT_BY(STAT_FPMovementFixedSubsteps, NumSubsteps);
+
+	if (TimestepAccumulator >= Timestep)
+	{
+		// Out of substeps. Drop the rest instead of catching up over the next frames.
+		INC_DWORD_STAT(STAT_FPMovementFixedSubstepsDropped);
+		TimestepAccumulator = FMath::Fmod(TimestepAccumulator, Timestep);
+	}
+
+	UpdateVisualInterpolation(TimestepAccumulator / Timestep);
+}
+
+void UFPMovementComponent::ApplyPendingFaceRotation()
+{
+	if (!PendingFaceRotation.IsSet())
+	{
+		return;
+	}
+
+	const FRotator ControlRotation = PendingFaceRotation.GetValue();
+	PendingFaceRotation.Reset();
+	ApplyFaceRotation(ControlRotation);
+}
+
+void UFPMovementComponent::ApplyFaceRotation(const FRotator& ControlRotation)
+{
+	const FRotator CurrentRotation = UpdatedComponent->GetComponentRotation();
+	const FRotator NewRotation(
+		PawnOwner->bUseControllerRotationPitch ? ControlRotation.Pitch : CurrentRotation.Pitch,
+		PawnOwner->bUseControllerRotationYaw ? ControlRotation.Yaw : CurrentRotation.Yaw,
+		PawnOwner->bUseControllerRotationRoll ? ControlRotation.Roll : CurrentRotation.Roll);
+	if (!NewRotation.Equals(CurrentRotation))
+	{
+		MoveUpdatedComponent(FVector::ZeroVector, NewRotation.Quaternion(), false);
+	}
+}
+
+bool UFPMovementComponent::ConsumeLODTime(float DeltaTime, const FVector& InputVector, float& OutDeltaTime)
+{
+	LODPromotionTimeRemaining = FMath::Max(LODPromotionTimeRemaining - DeltaTime, 0.0f);
+
+	if (MovementLOD != EFPMovementLOD::Full && (!InputVector.IsNearlyZero() || (CachedOwnerChar && CachedOwnerChar->IsJumpInputPending())))
+	{
+		PromoteMovementLOD();
+	}
+
+	LODAccumulatedTime += DeltaTime;
+
+	const float Interval = MovementLOD == EFPMovementLOD::Reduced ? CVarFPMovementLODReducedInterval.GetValueOnGameThread()
+		: MovementLOD == EFPMovementLOD::Minimal ? CVarFPMovementLODMinimalInterval.GetValueOnGameThread()
+		: 0.0f;
+	if (LODAccumulatedTime < Interval)
+	{
+		INC_DWORD_STAT(STAT_FPMovementLODSkippedTicks);
+		return false;
+	}
+
+	// Simulate everything skipped since the last update as one larger step.
+	OutDeltaTime = LODAccumulatedTime;
+	LODAccumulatedTime = 0.0f;
+	return true;
+}
+
+void UFPMovementComponent::SetMovementLOD(EFPMovementLOD NewLOD)
+{
+	if (NewLOD > MovementLOD && LODPromotionTimeRemaining > 0.0f)
+	{
+		return;
+	}
+
+	MovementLOD = NewLOD;
+}
+
+void UFPMovementComponent::PromoteMovementLOD()
+{
+	MovementLOD = EFPMovementLOD::Full;
+	LODPromotionTimeRemaining = CVarFPMovementLODPromotionHoldTime.GetValueOnGameThread();
+}
+
+void UFPMovementComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UFPMovementComponent, ReplicatedState, COND_SimulatedOnly);
+}
+
+void UFPMovementComponent::ReplicateMoveToServer(const float DeltaTime, const FVector& InputVector)
+{
+	// Predict with the input rounded the way it is sent, so the server simulates exactly the same move.
+	const FVector QuantizedInputVector = FFPNetMove::QuantizeInputVector(InputVector);
+	LastInputVector = QuantizedInputVector;
+
+	FFPSavedMove NewMove;
+	NewMove.MoveId = ++ClientMoveId;
+	NewMove.DeltaTime = DeltaTime;
+	NewMove.InputVector = QuantizedInputVector;
+	NewMove.ControlRotation = FFPNetMove::QuantizeControlRotation(PawnOwner->GetControlRotation());
+	NewMove.Flags = GetMoveFlags();
+	NewMove.StartTimestepAccumulator = TimestepAccumulator;
+	NewMove.Timestamp = GetWorld()->GetTimeSeconds();
+
+	const EFPMovementMode StartMode = MovementMode;
+	const FVector StartVelocity = Velocity;
+	const uint32 StartNumBlockingHits = NumBlockingHits;
+
+	SimulateMovement(DeltaTime, QuantizedInputVector);
+
+	NewMove.EndLocation = UpdatedComponent->GetComponentLocation();
+	NewMove.EndVelocity = Velocity;
+	// The server runs a combined move as one step. Only walking at a constant velocity, without hitting anything, gives the same result as the steps run here.
+	NewMove.bLinearInDeltaTime = StartMode == EFPMovementMode::Walking && MovementMode == EFPMovementMode::Walking
+		&& NumBlockingHits == StartNumBlockingHits && Velocity.Equals(StartVelocity, FFPSavedMove::CombineVelocityTolerance);
+
+	const float MaxCombinedDeltaTime = FFPSavedMove::GetMaxCombinedDeltaTime();
+	if (!SavedMoves.IsEmpty() && SavedMoves.Last().CanCombineWith(NewMove, MaxCombinedDeltaTime))
+	{
+		SavedMoves.Last().CombineWith(NewMove);
+		INC_DWORD_STAT(STAT_FPMovementNetMovesCombined);
+	}
+	else
+	{
+		SendPendingMove();
+		SavedMoves.Push() = NewMove;
+	}
+
+	if (!SavedMoves.Last().ShouldWaitForCombine(DeltaTime, MaxCombinedDeltaTime))
+	{
+		SendPendingMove();
+	}
+
+	SET_DWORD_STAT(STAT_FPMovementNetSavedMoves, SavedMoves.Num());
+}
+
+void UFPMovementComponent::SendPendingMove()
+{
+	if (SavedMoves.IsEmpty() || SavedMoves.Last().bSent)
+	{
+		return;
+	}
+
+	FFPSavedMove& Move = SavedMoves.Last();
+	Move.bSent = true;
+	INC_DWORD_STAT(STAT_FPMovementNetMovesSent);
+
+	// ServerMove is unreliable, so the oldest move the server hasn't acknowledged goes out again with the new one, in case it was lost.
+	if (SavedMoves.Num() > 1)
+	{
+		ServerMoveWithOld(SavedMoves[0].ToNetMove(), Move.ToNetMove());
+		INC_DWORD_STAT(STAT_FPMovementNetMovesResent);
+	}
+	else
+	{
+		ServerMove(Move.ToNetMove());
+	}
+}
+
+void UFPMovementComponent::ServerMove_Implementation(const FFPNetMove& Move)
+{
+	ServerSimulateMove(Move, true);
+}
+
+void UFPMovementComponent::ServerMoveWithOld_Implementation(const FFPNetMove& OldMove, const FFPNetMove& NewMove)
+{
+	// Usually the old move arrived the first time and is dropped as late. If it was lost, it is simulated now, without a reply of its own.
+	ServerSimulateMove(OldMove, false);
+	ServerSimulateMove(NewMove, true);
+}
+
+void UFPMovementComponent::ServerSimulateMove(const FFPNetMove& Move, bool bRespond)
+{
+	// Unreliable RPCs can arrive out of order. A late move is already covered by the ones after it.
+	if (Move.MoveId <= ServerLastMoveId)
+	{
+		return;
+	}
+	ServerLastMoveId = Move.MoveId;
+
+	const float DeltaTime = FMath::Clamp(Move.DeltaTime, 0.0f, CVarFPMovementNetMaxMoveDeltaTime.GetValueOnGameThread());
+	if (AController* Controller = PawnOwner->GetController())
+	{
+		Controller->SetControlRotation(Move.ControlRotation);
+		PawnOwner->FaceRotation(Move.ControlRotation, DeltaTime);
+	}
+
+	ApplyMoveFlags(Move.Flags);
+	LastInputVector = Move.InputVector.GetClampedToMaxSize(1.0f);
+	SimulateMovement(DeltaTime, LastInputVector);
+	UpdateReplicatedState();
+
+	if (!bRespond)
+	{
+		return;
+	}
+
+	const FVector ServerLocation = UpdatedComponent->GetComponentLocation();
+	if (FVector::DistSquared(ServerLocation, Move.ClientLocation) > FMath::Square(CVarFPMovementNetMaxLocationError.GetValueOnGameThread()))
+	{
+		INC_DWORD_STAT(STAT_FPMovementNetCorrections);
+
+		FFPMoveAdjustment Adjustment;
+		Adjustment.MoveId = Move.MoveId;
+		Adjustment.Location = ServerLocation;
+		Adjustment.Velocity = Velocity;
+		Adjustment.InitialJumpVelocity = InitialJumpVelocity;
+		Adjustment.State.Set(MovementMode, CrouchFrac);
+		ClientAdjustPosition(Adjustment);
+	}
+	else
+	{
+		ClientAckGoodMove(Move.MoveId);
+	}
+}
+
+void UFPMovementComponent::ClientAckGoodMove_Implementation(uint32 MoveId)
+{
+	// Replies are unreliable too. One older than the newest we have is stale.
+	if (MoveId <= ClientLastAckedMoveId)
+	{
+		return;
+	}
+	ClientLastAckedMoveId = MoveId;
+
+	SavedMoves.Acknowledge(MoveId);
+}
+
+void UFPMovementComponent::ClientAdjustPosition_Implementation(const FFPMoveAdjustment& Adjustment)
+{
+	// A late correction would snap back to a state the server has already moved on from.
+	if (Adjustment.MoveId <= ClientLastAckedMoveId)
+	{
+		return;
+	}
+	ClientLastAckedMoveId = Adjustment.MoveId;
+
+	SavedMoves.Acknowledge(Adjustment.MoveId);
+
+	// The correction and every replayed move update the children and overlaps once.
+	INC_DWORD_STAT_BY(STAT_FPMovementScopedUpdateCommits, UpdatedComponent->IsDeferringMovementUpdates() ? 0 : 1);
+	FScopedMovementUpdate ScopedUpdate(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+
+	ApplyCrouchFrac(Adjustment.State.GetCrouchFrac());
+	UpdatedComponent->SetWorldLocation(Adjustment.Location, false, nullptr, ETeleportType::TeleportPhysics);
+	Velocity = Adjustment.Velocity;
+	InitialJumpVelocity = Adjustment.InitialJumpVelocity;
+
+	const EFPMovementMode NewMovementMode = static_cast<EFPMovementMode>(Adjustment.State.MovementMode);
+	if (NewMovementMode != MovementMode)
+	{
+		SetMovementMode(NewMovementMode);
+	}
+
+	// The floors we had belong to the location we predicted.
+	InvalidateFloorCache();
+	if (IsMovingOnGround())
+	{
+		FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+		SlideFloorResult = CurrentFloor;
+	}
+
+	ReplaySavedMoves();
+}
+
+void UFPMovementComponent::ReplaySavedMoves()
+{
+	if (SavedMoves.IsEmpty())
+	{
+		return;
+	}
+
+	INC_DWORD_STAT_BY(STAT_FPMovementNetReplayedMoves, SavedMoves.Num());
+
+	// Replays use the buttons, facing and time of each move, then the buttons held and the facing right now are put back.
+	// The facing matters because the fall kernel steers along the pawn's forward and right vectors, the time because of the jump grace period.
+	// A pending face rotation and LOD time are left for the next tick, as they were when the moves were first predicted.
+	const uint8 CurrentFlags = GetMoveFlags();
+	const FQuat CurrentRotation = UpdatedComponent->GetComponentQuat();
+	TimestepAccumulator = SavedMoves[0].StartTimestepAccumulator;
+
+	for (int32 Index = 0; Index < SavedMoves.Num(); ++Index)
+	{
+		FFPSavedMove& Move = SavedMoves[Index];
+		ApplyMoveFlags(Move.Flags);
+		ApplyFaceRotation(Move.ControlRotation);
+		ReplayTimeSeconds = Move.Timestamp;
+		SimulateMovementSteps(Move.DeltaTime, Move.InputVector);
+		Move.EndLocation = UpdatedComponent->GetComponentLocation();
+		Move.EndVelocity = Velocity;
+	}
+
+	ReplayTimeSeconds.Reset();
+	ApplyMoveFlags(CurrentFlags);
+	MoveUpdatedComponent(FVector::ZeroVector, CurrentRotation, false);
+}
+
+float UFPMovementComponent::GetMovementTimeSeconds() const
+{
+	return ReplayTimeSeconds.IsSet() ? ReplayTimeSeconds.GetValue() : GetWorld()->GetTimeSeconds();
+}
+
+uint8 UFPMovementComponent::GetMoveFlags() const
+{
+	uint8 Flags = FPMoveFlag_None;
+	Flags |= CachedOwnerChar && CachedOwnerChar->IsJumpInputPending() ? FPMoveFlag_Jump : FPMoveFlag_None;
+	Flags |= bWantsToSprint ? FPMoveFlag_Sprint : FPMoveFlag_None;
+	Flags |= bWantsToCrouch ? FPMoveFlag_Crouch : FPMoveFlag_None;
+	return Flags;
+}
+
+void UFPMovementComponent::ApplyMoveFlags(uint8 Flags)
+{
+	if (CachedOwnerChar)
+	{
+		CachedOwnerChar->SetJumpInputPending((Flags & FPMoveFlag_Jump) != 0);
+	}
+	SetWantsToSprint((Flags & FPMoveFlag_Sprint) != 0);
+	SetWantsToCrouch((Flags & FPMoveFlag_Crouch) != 0);
+}
+
+void UFPMovementComponent::ApplyCrouchFrac(float NewCrouchFrac)
+{
+	const bool bWasCrouched = IsCrouching();
+	CrouchFrac = NewCrouchFrac;
+	UpdateCrouchedCapsule(bWasCrouched);
+}
+
+void UFPMovementComponent::UpdateReplicatedState()
+{
+	FFPCompactMovementState NewState;
+	NewState.Set(MovementMode, CrouchFrac);
+	if (NewState != ReplicatedState)
+	{
+		ReplicatedState = NewState;
+	}
+}
+
+void UFPMovementComponent::OnRep_ReplicatedState()
+{
+	// Simulated proxies follow the server's mode without running the transition logic.
+	MovementMode = static_cast<EFPMovementMode>(ReplicatedState.MovementMode);
+	ApplyCrouchFrac(ReplicatedState.GetCrouchFrac());
+}
+
+void UFPMovementComponent::UpdateCrouchedCapsule(bool bWasCrouched)
+{
+	if (!CachedOwnerChar)
+	{
+		return;
+	}
+
+	// The location comes from the server along with the crouch state, so only the capsule size changes here.
+	if (bWasCrouched != IsCrouching())
+	{
+		CachedOwnerChar->GetCapsuleComponent()->SetCapsuleHalfHeight(IsCrouching() ? CapsuleCrouchHalfHeight : CachedDefaultCapsuleHalfHeight);
+		CachedOwnerChar->OnCrouchChanged(IsCrouching());
+	}
+
+	CachedOwnerChar->RecalculateBaseEyeHeight();
+}
+
+float UFPMovementComponent::GetFixedTimestep() const
+{
+	if (ServerFixedTimestep > 0.0f && PawnOwner && PawnOwner->HasAuthority() && !PawnOwner->IsLocallyControlled())
+	{
+		return ServerFixedTimestep;
+	}
+
+	return FixedTimestep;
+}
+
+void UFPMovementComponent::UpdateVisualInterpolation(float StepAlpha)
+{
+	// Draw the capsule between the last two substeps, StepAlpha of the way into the next one.
+	const FVector CurrentLocation = UpdatedComponent->GetComponentLocation();
+	VisualInterpolationOffset = (PreviousSubstepLocation - CurrentLocation) * (1.0f - StepAlpha);
+
+	// Teleports and crouch height changes aren't worth smoothing over.
+	if (VisualInterpolationOffset.SizeSquared() > FMath::Square(CVarFPMovementMaxInterpolationOffset.GetValueOnGameThread()))
+	{
+		VisualInterpolationOffset = FVector::ZeroVector;
+		PreviousSubstepLocation = CurrentLocation;
+	}
+
+	if (CachedOwnerChar)
+	{
+		CachedOwnerChar->OnVisualInterpolationOffsetChanged(VisualInterpolationOffset);
+	}
+}
+
+void UFPMovementComponent::PerformMovement(const float DeltaTime, const FVector& InputVector)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementPerformMovement);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::PerformMovement);
+	INC_DWORD_STAT(STAT_FPMovementUpdates);
+	FPMovementProfile::FModeScope ProfileScope(MovementMode);
+
+	const EFPMovementMode StartMode = MovementMode;
+	const FVector StartLocation = UpdatedComponent->GetComponentLocation();
+	PendingTelemetryFlags = EFPMovementTelemetryFlags::None;
+
+	UpdateBasedMovement();
+
+	// Each mode tick runs until it is done or hands the rest of the update to another mode.
+	float RemainingTime = DeltaTime;
+	int32 Iterations = 0;
+	while (RemainingTime > 0.0f && Iterations < MaxModeIterations)
+	{
+		++Iterations;
+		PendingRemainingTime = 0.0f;
+
+		const FFPMovementModeFunctions& Mode = FFPMovementModeRegistry::Get(MovementMode);
+		if (Mode.Tick)
+		{
+			Mode.Tick(*this, RemainingTime, InputVector);
+		}
+
+		RemainingTime = FMath::Min(PendingRemainingTime, RemainingTime);
+	}
+
+	INC_DWORD_STAT_BY(STAT_FPMovementModeIterations, Iterations);
+	if (RemainingTime > 0.0f)
+	{
+		// Modes kept handing over to each other, e.g. sliding and walking on a surface each says belongs to the other.
+		INC_DWORD_STAT(STAT_FPMovementModeIterationCapHits);
+		PendingRemainingTime = 0.0f;
+	}
+
+	UpdateMovementBase();
+
+	// A precomputed job is only valid for the update it was provided for.
+	PrecomputedKernelJob = nullptr;
+
+	if (FPMovementTelemetry::IsEnabled())
+	{
+		RecordTelemetry(DeltaTime, StartMode, StartLocation);
+	}
+}
+
+void UFPMovementComponent::UpdateMovementBase()
+{
+	const FFindFloorResult& Floor = IsSliding() ? SlideFloorResult : CurrentFloor;
+	UPrimitiveComponent* FloorComponent = IsMovingOnGround() && Floor.IsWalkableFloor() ? Floor.HitResult.GetComponent() : nullptr;
+	SetMovementBase(FloorComponent && FloorComponent->Mobility == EComponentMobility::Movable ? FloorComponent : nullptr);
+
+	if (const UPrimitiveComponent* Base = MovementBase.Get())
+	{
+		OldBaseLocation = Base->GetComponentLocation();
+		OldBaseQuat = Base->GetComponentQuat();
+	}
+}
+
+void UFPMovementComponent::SetMovementBase(UPrimitiveComponent* NewBase)
+{
+	if (NewBase == MovementBase.Get() && !MovementBase.IsStale())
+	{
+		return;
+	}
+
+	// The base has to be done moving for the frame before the pawn follows it. Batched pawns tick from UFPMovementSubsystem's tick function instead,
+	// so they follow a base that moves later in TG_PrePhysics one frame late.
+	if (UPrimitiveComponent* OldBase = MovementBase.Get())
+	{
+		RemoveTickPrerequisiteComponent(OldBase);
+	}
+	if (AActor* OldBaseOwner = MovementBaseOwner.Get())
+	{
+		RemoveTickPrerequisiteActor(OldBaseOwner);
+	}
+	if (MovementBase.IsStale() || MovementBaseOwner.IsStale())
+	{
+		// A destroyed base can't be passed to RemoveTickPrerequisiteComponent. Its prerequisites are the ones whose object is gone.
+		PrimaryComponentTick.GetPrerequisites().RemoveAllSwap([](const FTickPrerequisite& Prerequisite) { return Prerequisite.PrerequisiteObject.IsStale(); });
+	}
+
+	MovementBase = NewBase;
+	MovementBaseOwner = NewBase ? NewBase->GetOwner() : nullptr;
+
+	if (NewBase)
+	{
+		AddTickPrerequisiteComponent(NewBase);
+		AddTickPrerequisiteActor(NewBase->GetOwner());
+	}
+}
+
+void UFPMovementComponent::UpdateBasedMovement()
+{
+	UPrimitiveComponent* Base = MovementBase.Get();
+	if (!Base)
+	{
+		// Drops the prerequisites of a base destroyed since the last update.
+		SetMovementBase(nullptr);
+		return;
+	}
+
+	const FVector NewBaseLocation = Base->GetComponentLocation();
+	const FQuat NewBaseQuat = Base->GetComponentQuat();
+	if (NewBaseLocation.Equals(OldBaseLocation, UE_KINDA_SMALL_NUMBER) && NewBaseQuat.Equals(OldBaseQuat, UE_KINDA_SMALL_NUMBER))
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_FPMovementBasedMoves);
+
+	// Rigid transform of the base since the last update, applied to the pawn's location relative to the base.
+	const FQuat DeltaQuat = NewBaseQuat * OldBaseQuat.Inverse();
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector NewLocation = NewBaseLocation + DeltaQuat.RotateVector(OldLocation - OldBaseLocation);
+
+	// Only yaw carries over, so the pawn stays upright on tilting bases.
+	const FRotator DeltaYaw(0.0f, DeltaQuat.Rotator().Yaw, 0.0f);
+	const FQuat NewRotation = DeltaYaw.Quaternion() * UpdatedComponent->GetComponentQuat();
+
+	// Swept, as the base can carry the pawn into walls, ceilings or other pawns. The base itself is ignored, since it may have moved up
+	// into the gap the pawn keeps above its floor. SafeMoveUpdatedComponent pushes the pawn out of anything it ends up in.
+	const bool bBaseAlreadyIgnored = UpdatedPrimitive->GetMoveIgnoreComponents().Contains(Base);
+	UpdatedPrimitive->IgnoreComponentWhenMoving(Base, true);
+	FHitResult MoveOnBaseHit(1.0f);
+	SafeMoveUpdatedComponent(NewLocation - OldLocation, NewRotation, true, MoveOnBaseHit);
+	UpdatedPrimitive->IgnoreComponentWhenMoving(Base, bBaseAlreadyIgnored);
+
+	if (AController* Controller = PawnOwner->GetController())
+	{
+		Controller->SetControlRotation(Controller->GetControlRotation() + DeltaYaw);
+	}
+
+	FFindFloorResult& Floor = IsSliding() ? SlideFloorResult : CurrentFloor;
+	if (MoveOnBaseHit.bBlockingHit)
+	{
+		// Held back while the base moved on. Whatever is under the pawn now decides what it does next.
+		FindFloor(UpdatedComponent->GetComponentLocation(), Floor);
+	}
+	else
+	{
+		// The floor moved with the base.
+		const FTransform DeltaTransform(DeltaQuat, NewBaseLocation - DeltaQuat.RotateVector(OldBaseLocation));
+		Floor.HitResult.Location = DeltaTransform.TransformPosition(Floor.HitResult.Location);
+		Floor.HitResult.ImpactPoint = DeltaTransform.TransformPosition(Floor.HitResult.ImpactPoint);
+		Floor.HitResult.Normal = DeltaQuat.RotateVector(Floor.HitResult.Normal);
+		Floor.HitResult.ImpactNormal = DeltaQuat.RotateVector(Floor.HitResult.ImpactNormal);
+	}
+
+	OldBaseLocation = NewBaseLocation;
+	OldBaseQuat = NewBaseQuat;
 }
 
-void UFPMovementComponent::BeginPlay()
+void UFPMovementComponent::RecordTelemetry(float DeltaTime, EFPMovementMode StartMode, const FVector& StartLocation)
 {
-	Super::BeginPlay();
+	if (!Telemetry)
+	{
+		Telemetry = MakeUnique<FFPMovementTelemetryRing>();
+	}
 
-	FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+	const FFindFloorResult& Floor = IsSliding() ? SlideFloorResult : CurrentFloor;
+	const bool bHasFloor = !IsFalling() && Floor.bBlockingHit;
 
-	if (CurrentFloor.IsWalkableFloor())
+	FFPMovementTelemetryRecord Record;
+	Record.Time = GetWorld()->GetTimeSeconds() - DeltaTime;
+	Record.Velocity = FVector3f(Velocity);
+	Record.FloorNormal = bHasFloor ? FVector3f(Floor.HitResult.ImpactNormal) : FVector3f::ZeroVector;
+	Record.Delta = FVector3f(UpdatedComponent->GetComponentLocation() - StartLocation);
+	Record.DeltaTime = DeltaTime;
+	Record.Mode = static_cast<uint8>(StartMode);
+	Record.Flags = PendingTelemetryFlags;
+	if (bHasFloor && Floor.IsWalkableFloor())
 	{
-		StartGroundMovement();
+		Record.Flags |= EFPMovementTelemetryFlags::OnWalkableFloor;
+	}
+	if (MovementMode != StartMode)
+	{
+		Record.Flags |= EFPMovementTelemetryFlags::ModeChanged;
 	}
+	Telemetry->Push(Record);
+
+	FPMovementTelemetry::CheckForHitch(GetWorld());
 }
 
-void UFPMovementComponent::InitializeComponent()
+bool UFPMovementComponent::BuildKernelJob(const FVector& InputVector, float DeltaTime, FFPMovementKernelJob& OutJob) const
 {
-	SetMovementMode(EFPMovementMode::Falling);
-
-	if (PawnOwner)
+	switch (MovementMode)
 	{
-		AFirstPersonProjCharacter* FPPCharacter = Cast<AFirstPersonProjCharacter>(PawnOwner);
-		check(FPPCharacter);
-		const UCapsuleComponent* CharacterCapsule = FPPCharacter->GetCapsuleComponent();
-		CachedDefaultCapsuleHalfHeight = CharacterCapsule->GetUnscaledCapsuleHalfHeight();
-		CachedOwnerChar = FPPCharacter;
-
-		CachedMinimumSlideSpeedSquared = StartSlideSpeedMinimum * StartSlideSpeedMinimum;
-		CachedSlideSpeedThresholdSquared = SlideSpeedThreshold * SlideSpeedThreshold;
+		case EFPMovementMode::Falling:
+			OutJob = MakeKernelJob(EFPMovementKernel::Fall, InputVector, DeltaTime);
+			return true;
+		case EFPMovementMode::Walking:
+		case EFPMovementMode::NavWalking:
+			OutJob = MakeKernelJob(EFPMovementKernel::Ground, InputVector, DeltaTime);
+			return true;
+		case EFPMovementMode::Sliding:
+			OutJob = MakeKernelJob(EFPMovementKernel::Slide, InputVector, DeltaTime);
+			return true;
+		default:
+			return false;
 	}
 }
 
-void UFPMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UFPMovementComponent::SetPrecomputedKernelJob(const FFPMovementKernelJob* Job)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	PerformMovement(DeltaTime);
+	PrecomputedKernelJob = Job;
 }
 
-#if WITH_EDITOR
-void UFPMovementComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+FFPMovementKernelJob UFPMovementComponent::MakeKernelJob(EFPMovementKernel Kernel, const FVector& InputVector, float DeltaTime) const
 {
-	Super::PostEditChangeProperty(PropertyChangedEvent);
+	FFPMovementKernelJob Job;
+	Job.Kernel = Kernel;
+	Job.DeltaTime = DeltaTime;
+	Job.InputVector = InputVector;
+	Job.State = GetMovementState();
 
-	const FProperty* PropertyThatChanged = PropertyChangedEvent.MemberProperty;
-	if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(UFPMovementComponent, WalkableFloorAngle))
+	if (Kernel == EFPMovementKernel::Fall)
 	{
-		// Compute WalkableFloorZ from the Angle.
-		SetWalkableFloorAngle(WalkableFloorAngle);
+		Job.FallContext.ForwardVector = UpdatedComponent->GetForwardVector();
+		Job.FallContext.RightVector = UpdatedComponent->GetRightVector();
+		Job.FallContext.GravityZ = GetGravityZ();
+		Job.FallContext.TerminalVelocity = GetPhysicsVolume()->TerminalVelocity;
 	}
-	else if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(UFPMovementComponent, SlideFloorAngle))
+	else if (Kernel == EFPMovementKernel::Slide)
 	{
-		// Compute WalkableFloorZ from the Angle.
-		SetSlidableFloorAngle(SlideFloorAngle);
+		Job.FloorNormal = SlideFloorResult.HitResult.Normal;
 	}
-}
-#endif // WITH_EDITOR
 
-AFirstPersonProjCharacter* UFPMovementComponent::GetFPPOwner() const
-{
-	return Cast<AFirstPersonProjCharacter>(GetPawnOwner());
+	return Job;
 }
 
-float UFPMovementComponent::GetWalkableFloorAngle() const
+void UFPMovementComponent::AddAsyncKernelResult(const FFPMovementKernelJob& Job)
 {
-	return WalkableFloorAngle;
+	// A movement update runs at most MaxSubsteps substeps, so older steps could never be used.
+	if (AsyncKernelResults.Num() >= MaxSubsteps)
+	{
+		AsyncKernelResults.RemoveAt(0, AsyncKernelResults.Num() - MaxSubsteps + 1, false);
+	}
+	AsyncKernelResults.Add(Job);
 }
 
-void UFPMovementComponent::SetWalkableFloorAngle(float InWalkableFloorAngle)
+FVector UFPMovementComponent::RunVelocityKernel(EFPMovementKernel Kernel, const FVector& InputVector, float DeltaTime)
 {
-	WalkableFloorAngle = InWalkableFloorAngle;
-	WalkableFloorZ = FMath::Cos(FMath::DegreesToRadians(InWalkableFloorAngle));
+	// Built up front, so jobs computed elsewhere are compared against exactly what this run would compute.
+	FFPMovementKernelJob Job = MakeKernelJob(Kernel, InputVector, DeltaTime);
+
+	const bool bPrecomputedHit = PrecomputedKernelJob && PrecomputedKernelJob->HasSameInputs(Job);
+	INC_DWORD_STAT_BY(STAT_FPMovementPrecomputedHits, bPrecomputedHit ? 1 : 0);
+	INC_DWORD_STAT_BY(STAT_FPMovementPrecomputedMisses, PrecomputedKernelJob && !bPrecomputedHit ? 1 : 0);
+
+	// Integrated on the physics thread from the same state, with the same delta and input.
+	const int32 AsyncIndex = bPrecomputedHit ? INDEX_NONE : AsyncKernelResults.IndexOfByPredicate([&Job](const FFPMovementKernelJob& AsyncJob)
+	{
+		return AsyncJob.HasSameInputs(Job);
+	});
+	INC_DWORD_STAT_BY(STAT_FPMovementAsyncKernelHits, AsyncIndex != INDEX_NONE ? 1 : 0);
+	INC_DWORD_STAT_BY(STAT_FPMovementAsyncKernelMisses, !bPrecomputedHit && AsyncIndex == INDEX_NONE && !AsyncKernelResults.IsEmpty() ? 1 : 0);
+
+	FVector GravitationalAccel;
+	if (bPrecomputedHit)
+	{
+		ApplyMovementState(PrecomputedKernelJob->Result);
+		GravitationalAccel = PrecomputedKernelJob->GravitationalAccel;
+	}
+	else if (AsyncIndex != INDEX_NONE)
+	{
+		ApplyMovementState(AsyncKernelResults[AsyncIndex].Result);
+		GravitationalAccel = AsyncKernelResults[AsyncIndex].GravitationalAccel;
+
+		// Steps chained after this one can still match the following substeps.
+		AsyncKernelResults.RemoveAt(0, AsyncIndex + 1, false);
+	}
+	else
+	{
+		FPMovementCore::RunKernel(Job, GetMovementTunables());
+		ApplyMovementState(Job.Result);
+		GravitationalAccel = Job.GravitationalAccel;
+	}
+
+	// A precomputed job covers a single kernel run.
+	PrecomputedKernelJob = nullptr;
+	return GravitationalAccel;
 }
 
-float UFPMovementComponent::GetWalkableFloorZ() const
+FFPMovementTunables UFPMovementComponent::GetMovementTunables() const
 {
-	return WalkableFloorZ;
+	FFPMovementTunables Tunables;
+	Tunables.MaxWalkSpeed = MaxWalkSpeed;
+	Tunables.MaxSprintSpeed = MaxSprintSpeed;
+	Tunables.MaxSpeedCrouched = MaxSpeedCrouched;
+	Tunables.WalkAcceleration = WalkAcceleration;
+	Tunables.BrakingDecelerationWalking = BrakingDecelerationWalking;
+	Tunables.MaxAirSpeed = MaxAirSpeed;
+	Tunables.MaxAirStrafe = MaxAirStrafe;
+	Tunables.AirAcceleration = AirAcceleration;
+	Tunables.AirBrakingDeceleration = AirBrakingDeceleration;
+	Tunables.AirFrictionFactor = AirFrictionFactor;
+	Tunables.SlideFrictionFactor = SlideFrictionFactor;
+	Tunables.SlideBrakingDeceleration = SlideBrakingDeceleration;
+	Tunables.SlideGravityAcceleration = SlideGravityAcceleration;
+	Tunables.SlideFloorZ = SlideFloorZ;
+	return Tunables;
 }
 
-void UFPMovementComponent::SetWalkableFloorZ(float InWalkableFloorZ)
+FFPMovementState UFPMovementComponent::GetMovementState() const
 {
-	WalkableFloorZ = InWalkableFloorZ;
-	WalkableFloorAngle = FMath::RadiansToDegrees(FMath::Acos(InWalkableFloorZ));
+	FFPMovementState State;
+	State.Velocity = Velocity;
+	State.InitialJumpVelocity = InitialJumpVelocity;
+	State.CrouchFrac = CrouchFrac;
+	State.bIsSprinting = IsSprinting();
+	return State;
 }
 
-void UFPMovementComponent::PerformMovement(const float DeltaTime)
+void UFPMovementComponent::ApplyMovementState(const FFPMovementState& State)
 {
-	const FVector InputVector = ConsumeInputVector();
-	switch (MovementMode)
-	{
-		case EFPMovementMode::Falling:
-			PerformFallMovement(DeltaTime, InputVector);
-			break;
-		case EFPMovementMode::Walking:
-			PerformWalkMovement(DeltaTime, InputVector);
-			break;
-		case EFPMovementMode::Sliding:
-			PerformSlideMovement(DeltaTime, InputVector);
-			break;
-		default:
-			return;
-	}
+	Velocity = State.Velocity;
 }
 
 void UFPMovementComponent::PerformWalkMovement(const float DeltaTime, const FVector& InputVector)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementWalk);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::PerformWalkMovement);
+	FPMovementProfile::FPhaseScope ProfileScope(FPMovementProfile::EPhase::Walk);
+
 	if (DeltaTime <= 0.0f)
 	{
 		return;
 	}
 
-	if (IsSprinting() && (!bWantsToSprint || !CanSprint(InputVector)))
-	{
-		SetIsSprinting(false);
-	}
-	else if (!IsSprinting() && bWantsToSprint && CanSprint(InputVector))
-	{
-		SetIsSprinting(true);
-	}
+	UpdateSprinting(InputVector);
 
 	AFirstPersonProjCharacter* Character = GetFPPOwner();
 	if (Character->ConsumeJumpInput() && CanJump())
 	{
 		DoJump();
-		PerformFallMovement(DeltaTime, InputVector);
+		HandOffRemainingTime(DeltaTime);
 		return;
 	}
 
 	if (CanBeginSliding(CurrentFloor))
 	{
 		StartSliding(CurrentFloor);
-		PerformSlideMovement(DeltaTime, InputVector);
+		HandOffRemainingTime(DeltaTime);
 		return;
 	}
 
@@ -196,6 +1192,8 @@ void UFPMovementComponent::PerformWalkMovement(const float DeltaTime, const FVec
 
 
 	FHitResult MoveHitResult(1.0f);
+	FStepDownResult StepDownResult;
+	bool bComputedFloor = false;
 	SafeMoveUpdatedComponent(MoveDelta, UpdatedComponent->GetComponentQuat(), true, MoveHitResult);
 
 	if (MoveHitResult.bStartPenetrating)
@@ -226,11 +1224,14 @@ void UFPMovementComponent::PerformWalkMovement(const float DeltaTime, const FVec
 				// Try to step on top of barrier.
 				const FVector PreStepUpLocation = UpdatedComponent->GetComponentLocation();
 				const FVector GravityDir = FVector::DownVector;
-				FStepDownResult StepDownResult;
 				if (!StepUp(GravityDir, MoveDelta * (1.0f - PercentTimeApplied), MoveHitResult, &StepDownResult))
 				{
 					SlideAlongSurface(MoveDelta, 1.0f - PercentTimeApplied, MoveHitResult.Normal, MoveHitResult, true);
 				}
+				else if (StepDownResult.bComputedFloor)
+				{
+					bComputedFloor = true;
+				}
 			}
 		}
 		else if (MoveHitResult.Component.IsValid() && MoveHitResult.Component.Get()->CanCharacterStepUp(PawnOwner))
@@ -242,53 +1243,218 @@ void UFPMovementComponent::PerformWalkMovement(const float DeltaTime, const FVec
 	Velocity = (UpdatedComponent->GetComponentLocation() - PositionBeforeMove) / DeltaTime;
 	Velocity.Z = 0.0f;
 
-	FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+	// A successful step up already found the floor on its way down.
+	if (bComputedFloor)
+	{
+		CurrentFloor = StepDownResult.FloorResult;
+	}
+	else
+	{
+		FindFloorDeferred(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+	}
+
 	if (!CurrentFloor.IsWalkableFloor())
 	{
 		StartFalling();
 	}
+	else
+	{
+		TryStartNavWalking();
+	}
+}
+
+void UFPMovementComponent::PerformNavWalkMovement(const float DeltaTime, const FVector& InputVector)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementNavWalk);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::PerformNavWalkMovement);
+	FPMovementProfile::FPhaseScope ProfileScope(FPMovementProfile::EPhase::NavWalk);
+
+	if (DeltaTime <= 0.0f)
+	{
+		return;
+	}
+
+	UpdateSprinting(InputVector);
+
+	if (GetFPPOwner()->ConsumeJumpInput() && CanJump())
+	{
+		DoJump();
+		HandOffRemainingTime(DeltaTime);
+		return;
+	}
+
+	TickCrouch(DeltaTime);
+
+	const FVector VelocityBeforeMove = Velocity;
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	CalculateGroundVelocity(InputVector, DeltaTime);
+	Velocity.Z = 0.0f;
+
+	const FVector MoveDelta = Velocity * DeltaTime;
+	if (MoveDelta.IsNearlyZero())
+	{
+		return;
+	}
+
+	float PawnRadius, PawnHalfHeight;
+	CachedOwnerChar->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+
+	FNavLocation NavFloor;
+	if (!FindNavFloor(OldLocation + MoveDelta, PawnHalfHeight, NavFloor))
+	{
+		// Walking off the navmesh.
+		Velocity = VelocityBeforeMove;
+		StopNavWalking(DeltaTime);
+		return;
+	}
+
+	// The navmesh only approximates the floor's height. Correct it with a line trace now and then, instead of sweeping for the floor every move.
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	if (WorldTime >= NextNavFloorTraceTime)
+	{
+		NextNavFloorTraceTime = WorldTime + NavWalkingFloorTraceInterval;
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FPNavFloorTrace), false, PawnOwner);
+		FCollisionResponseParams ResponseParams;
+		UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+		const FVector TraceStart = NavFloor.Location + FVector(0.0f, 0.0f, MaxStepHeight);
+		const FVector TraceEnd = NavFloor.Location - FVector(0.0f, 0.0f, MaxStepHeight);
+
+		FHitResult FloorHit;
+		QueryStats::RecordLineTrace();
+		if (GetWorld()->LineTraceSingleByChannel(FloorHit, TraceStart, TraceEnd, UpdatedComponent->GetCollisionObjectType(), QueryParams, ResponseParams) && IsWalkableSurface(FloorHit))
+		{
+			const UPrimitiveComponent* FloorComponent = FloorHit.GetComponent();
+			if (!FloorComponent || FloorComponent->Mobility != EComponentMobility::Static)
+			{
+				// The navmesh doesn't follow moving floors.
+				Velocity = VelocityBeforeMove;
+				StopNavWalking(DeltaTime);
+				return;
+			}
+
+			NavFloorZOffset = FloorHit.ImpactPoint.Z - NavFloor.Location.Z;
+		}
+	}
+
+	const FVector NewLocation(NavFloor.Location.X, NavFloor.Location.Y, NavFloor.Location.Z + NavFloorZOffset + PawnHalfHeight + MAX_FLOOR_DIST);
+
+	// Sweeping costs as much as walking, so only pawns that need overlap events pay for it. The navmesh routes around static geometry,
+	// so the others only test for dynamic obstacles where they end up, and hand over to Walking instead of walking into one.
+	const bool bSweep = UpdatedPrimitive->GetGenerateOverlapEvents();
+	if (!bSweep)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FPNavWalkOverlap), false, PawnOwner);
+		FCollisionResponseParams ResponseParams;
+		UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+		ResponseParams.CollisionResponse.SetResponse(ECC_WorldStatic, ECR_Ignore);
+
+		QueryStats::RecordOverlap();
+		if (GetWorld()->OverlapBlockingTestByChannel(NewLocation, UpdatedComponent->GetComponentQuat(), UpdatedComponent->GetCollisionObjectType(), FCollisionShape::MakeCapsule(PawnRadius, PawnHalfHeight), QueryParams, ResponseParams))
+		{
+			Velocity = VelocityBeforeMove;
+			StopNavWalking(DeltaTime);
+			return;
+		}
+	}
+
+	FHitResult MoveHitResult(1.0f);
+	SafeMoveUpdatedComponent(NewLocation - OldLocation, UpdatedComponent->GetComponentQuat(), bSweep, MoveHitResult);
+
+	Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / DeltaTime;
+	Velocity.Z = 0.0f;
+
+	if (MoveHitResult.IsValidBlockingHit())
+	{
+		// Something the navmesh doesn't know about is in the way. Walking can step over it or slide along it.
+		StopNavWalking(DeltaTime * (1.0f - MoveHitResult.Time));
+	}
+}
 
+bool UFPMovementComponent::ShouldNavWalk() const
+{
+	return bNavWalkWhenAIControlled && PawnOwner && PawnOwner->GetController() && !PawnOwner->IsPlayerControlled();
 }
 
-void UFPMovementComponent::CalculateGroundVelocity(const FVector& InputVector, float DeltaTime)
+void UFPMovementComponent::TryStartNavWalking()
 {
-	if (InputVector.IsNearlyZero() && Velocity.IsNearlyZero())
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	if (MovementMode != EFPMovementMode::Walking || WorldTime < NavWalkingRetryTime || !ShouldNavWalk())
 	{
 		return;
 	}
 
-	const float PreviousVelocity2D = Velocity.Size2D();
-	const float CurrentMaxGroundSpeed = FMath::Lerp(IsSprinting() ? MaxSprintSpeed : MaxWalkSpeed, MaxSpeedCrouched, CrouchFrac);
-	const FVector TargetVelocity = InputVector.GetSafeNormal2D() * CurrentMaxGroundSpeed;
-	FVector AccelerationVec = TargetVelocity - Velocity;
-	const bool bIsDecelerating = InputVector.IsNearlyZero() || TargetVelocity.SizeSquared2D() < (PreviousVelocity2D * PreviousVelocity2D);
+	const UPrimitiveComponent* FloorComponent = CurrentFloor.HitResult.GetComponent();
+	float PawnRadius, PawnHalfHeight;
+	CachedOwnerChar->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
 
-	if (AccelerationVec.IsNearlyZero())
+	FNavLocation NavFloor;
+	if (!FloorComponent || FloorComponent->Mobility != EComponentMobility::Static || !FindNavFloor(UpdatedComponent->GetComponentLocation(), PawnHalfHeight, NavFloor))
 	{
+		NavWalkingRetryTime = WorldTime + NavWalkingRetryDelay;
 		return;
 	}
 
-	float AccelerationToUse = WalkAcceleration;
-	if (bIsDecelerating)
+	NavFloorZOffset = CurrentFloor.HitResult.ImpactPoint.Z - NavFloor.Location.Z;
+	NextNavFloorTraceTime = WorldTime + NavWalkingFloorTraceInterval;
+	SetMovementMode(EFPMovementMode::NavWalking);
+}
+
+void UFPMovementComponent::StopNavWalking(float RemainingTime)
+{
+	NavWalkingRetryTime = GetWorld()->GetTimeSeconds() + NavWalkingRetryDelay;
+
+	FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor);
+	if (CurrentFloor.IsWalkableFloor())
 	{
-		AccelerationToUse = BrakingDecelerationWalking;
+		SetMovementMode(EFPMovementMode::Walking);
 	}
 	else
 	{
-		Velocity = Velocity - (Velocity - AccelerationVec.GetSafeNormal2D() * Velocity.Size2D()) * DeltaTime;
-		AccelerationVec = TargetVelocity - Velocity;
+		StartFalling();
+	}
+
+	HandOffRemainingTime(RemainingTime);
+}
+
+bool UFPMovementComponent::FindNavFloor(const FVector& CapsuleLocation, float PawnHalfHeight, FNavLocation& OutNavFloor) const
+{
+	const ANavigationData* NavData = GetNavData();
+	if (!NavData)
+	{
+		return false;
+	}
+
+	// Close to the capsule horizontally, and within a step up or down.
+	const FVector Extent(10.0f, 10.0f, MaxStepHeight);
+	return NavData->ProjectPoint(CapsuleLocation - FVector(0.0f, 0.0f, PawnHalfHeight), OutNavFloor, Extent, NavData->GetDefaultQueryFilter(), PawnOwner);
+}
+
+const ANavigationData* UFPMovementComponent::GetNavData() const
+{
+	if (!CachedNavData.IsValid())
+	{
+		const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+		CachedNavData = NavSys ? NavSys->GetNavDataForProps(GetNavAgentPropertiesRef(), UpdatedComponent->GetComponentLocation()) : nullptr;
 	}
-	AccelerationToUse *= DeltaTime;
+	return CachedNavData.Get();
+}
+
+void UFPMovementComponent::CalculateGroundVelocity(const FVector& InputVector, float DeltaTime)
+{
+	RunVelocityKernel(EFPMovementKernel::Ground, InputVector, DeltaTime);
+}
 
-	// Prevent new velocity from exceeding desired velocity.
-	FVector VelocityDelta = (AccelerationVec.GetSafeNormal2D() * AccelerationToUse);
-	//UE_LOG(LogTemp, Warning, TEXT("before Vel: %s, Delta: %s, Accel Vec: %s"), *Velocity.ToString(), *VelocityDelta.ToString(), *AccelerationVec.ToString());
-	if (VelocityDelta.SizeSquared2D() > AccelerationVec.SizeSquared2D())
+void UFPMovementComponent::UpdateSprinting(const FVector& InputVector)
+{
+	if (IsSprinting() && (!bWantsToSprint || !CanSprint(InputVector)))
+	{
+		SetIsSprinting(false);
+	}
+	else if (!IsSprinting() && bWantsToSprint && CanSprint(InputVector))
 	{
-		VelocityDelta *= AccelerationVec.Size2D() / VelocityDelta.Size2D();
+		SetIsSprinting(true);
 	}
-	Velocity += VelocityDelta;
-	//UE_LOG(LogTemp, Warning, TEXT("after Vel: %s, after Delta: %s"), *Velocity.ToString(), *VelocityDelta.ToString());
 }
 
 bool UFPMovementComponent::CanSprint(const FVector& InputVector) const
@@ -321,6 +1487,10 @@ void UFPMovementComponent::StartGroundMovement()
 
 bool UFPMovementComponent::StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult& InHit, FStepDownResult* OutStepDownResult)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementStepUp);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::StepUp);
+	FPMovementProfile::FPhaseScope ProfileScope(FPMovementProfile::EPhase::StepUp);
+
 	// This function moves up, over the obstacle, then down to the floor.
 
 	if (!CanStepUp(InHit) || MaxStepHeight <= 0.f)
@@ -384,6 +1554,12 @@ bool UFPMovementComponent::StepUp(const FVector& GravDir, const FVector& Delta,
 		return false;
 	}
 
+	if (TryBakedStepUp(Delta, InHit, PawnRadius, PawnHalfHeight, PawnFloorPointZ, OutStepDownResult))
+	{
+		PendingTelemetryFlags |= EFPMovementTelemetryFlags::SteppedUp;
+		return true;
+	}
+
 	// Scope our movement updates, and do not apply them until all intermediate moves are completed.
 	FScopedMovementUpdate ScopedStepUpMovement(UpdatedComponent, EScopedUpdate::DeferredUpdates);
 
@@ -501,39 +1677,167 @@ bool UFPMovementComponent::StepUp(const FVector& GravDir, const FVector& Delta,
 		// Don't step up onto invalid surfaces if traveling higher.
 		if (DeltaZ > 0.f && !CanStepUp(Hit))
 		{
-			//UE_LOG(LogCharacterMovement, VeryVerbose, TEXT("- Reject StepUp (up onto surface with !CanStepUp())"));
-			ScopedStepUpMovement.RevertMove();
-			return false;
+			//UE_LOG(LogCharacterMovement, VeryVerbose, TEXT("- Reject StepUp (up onto surface with !CanStepUp())"));
+			ScopedStepUpMovement.RevertMove();
+			return false;
+		}
+
+		// See if we can validate the floor as a result of this step down. In almost all cases this should succeed, and we can avoid computing the floor outside this method.
+		if (OutStepDownResult != NULL)
+		{
+			FindFloor(UpdatedComponent->GetComponentLocation(), StepDownResult.FloorResult, &Hit);
+
+			// Reject unwalkable normals if we end up higher than our initial height.
+			// It's fine to walk down onto an unwalkable surface, don't reject those moves.
+			if (Hit.Location.Z > OldLocation.Z)
+			{
+				// We should reject the floor result if we are trying to step up an actual step where we are not able to perch (this is rare).
+				// In those cases we should instead abort the step up and try to slide along the stair.
+				if (!StepDownResult.FloorResult.bBlockingHit && StepSideZ < .08f)
+				{
+					ScopedStepUpMovement.RevertMove();
+					return false;
+				}
+			}
+
+			StepDownResult.bComputedFloor = true;
+		}
+	}
+
+	// Copy step down result.
+	if (OutStepDownResult != NULL)
+	{
+		*OutStepDownResult = StepDownResult;
+	}
+
+	PendingTelemetryFlags |= EFPMovementTelemetryFlags::SteppedUp;
+	return true;
+}
+
+bool UFPMovementComponent::TryBakedStepUp(const FVector& Delta, const FHitResult& InHit, float PawnRadius, float PawnHalfHeight, float PawnFloorPointZ, FStepDownResult* OutStepDownResult)
+{
+	const UFPTraversabilityData* Traversability = TraversabilitySubsystem ? TraversabilitySubsystem->GetData() : nullptr;
+	const UPrimitiveComponent* StepComponent = InHit.GetComponent();
+	if (!Traversability || !StepComponent || StepComponent->Mobility != EComponentMobility::Static || !IsMovingOnGround() || !CurrentFloor.IsWalkableFloor())
+	{
+		return false;
+	}
+
+	// Baked tops within this of each other count as the same height, to absorb the bake's sampling.
+	constexpr float HeightTolerance = 1.0f;
+	constexpr float FlatNormalZ = 0.99f;
+
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector Target = OldLocation + FVector(Delta.X, Delta.Y, 0.0f);
+	const float CapsuleHeight = PawnHalfHeight * 2.0f;
+
+	// The capsule has to end up centered over a flat top, higher than the floor but no higher than a step, with room to stand.
+	float StepZ = 0.0f;
+	bool bFoundStep = false;
+	for (const FFPTraversabilitySurface& Surface : Traversability->GetSurfaces(Target))
+	{
+		if (Surface.Z <= PawnFloorPointZ + MaxStepHeight)
+		{
+			StepZ = Surface.Z;
+			bFoundStep = Surface.Z > PawnFloorPointZ + HeightTolerance && Surface.GetNormalZ() >= FlatNormalZ && Surface.Clearance >= CapsuleHeight + MAX_FLOOR_DIST;
+			break;
 		}
+	}
 
-		// See if we can validate the floor as a result of this step down. In almost all cases this should succeed, and we can avoid computing the floor outside this method.
-		if (OutStepDownResult != NULL)
+	// Nothing else under the capsule may stand higher than the step, or hang lower than the top of the capsule.
+	const float CapsuleTopZ = StepZ + CapsuleHeight + MAX_FLOOR_DIST;
+	const float CellSize = Traversability->GetCellSize();
+	const int32 CellRadius = FMath::CeilToInt(PawnRadius / CellSize);
+	const FVector TargetCell = Traversability->GetCellCenter(Target);
+	for (int32 OffsetY = -CellRadius; bFoundStep && OffsetY <= CellRadius; ++OffsetY)
+	{
+		for (int32 OffsetX = -CellRadius; bFoundStep && OffsetX <= CellRadius; ++OffsetX)
 		{
-			FindFloor(UpdatedComponent->GetComponentLocation(), StepDownResult.FloorResult);
+			const FVector Cell = TargetCell + FVector(OffsetX * CellSize, OffsetY * CellSize, 0.0f);
+			if (FVector::DistSquared2D(Cell, Target) > FMath::Square(PawnRadius + CellSize * UE_HALF_SQRT_2))
+			{
+				continue;
+			}
 
-			// Reject unwalkable normals if we end up higher than our initial height.
-			// It's fine to walk down onto an unwalkable surface, don't reject those moves.
-			if (Hit.Location.Z > OldLocation.Z)
+			for (const FFPTraversabilitySurface& Surface : Traversability->GetSurfaces(Cell))
 			{
-				// We should reject the floor result if we are trying to step up an actual step where we are not able to perch (this is rare).
-				// In those cases we should instead abort the step up and try to slide along the stair.
-				if (!StepDownResult.FloorResult.bBlockingHit && StepSideZ < .08f)
+				if (Surface.Z <= CapsuleTopZ)
 				{
-					ScopedStepUpMovement.RevertMove();
-					return false;
+					bFoundStep = Surface.Z <= StepZ + HeightTolerance && Surface.GetTopOfClearance() >= CapsuleTopZ;
+					break;
 				}
 			}
-
-			StepDownResult.bComputedFloor = true;
 		}
 	}
 
-	// Copy step down result.
-	if (OutStepDownResult != NULL)
+	if (!bFoundStep)
 	{
-		*OutStepDownResult = StepDownResult;
+		TraversabilitySubsystem->RecordStepUp(false);
+		return false;
+	}
+
+	// The bake only knows about static geometry. An overlap test at the top of the rise stands in for the up sweep, and catches anything
+	// else over the capsule or anything the bake's sampling missed. The move onto the step is swept, so nothing between the apex and the
+	// step is passed through. A line trace onto the baked top stands in for the down sweep, and finds what the pawn ends up standing on.
+	const FVector NewLocation(Target.X, Target.Y, StepZ + PawnHalfHeight + MAX_FLOOR_DIST);
+	const FVector Apex(OldLocation.X, OldLocation.Y, NewLocation.Z);
+	const FQuat PawnRotation = UpdatedComponent->GetComponentQuat();
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FPBakedStepUp), false, PawnOwner);
+	FCollisionResponseParams ResponseParams;
+	UpdatedPrimitive->InitSweepCollisionParams(QueryParams, ResponseParams);
+
+	FHitResult LandingHit;
+	const FVector LandingTraceEnd(Target.X, Target.Y, StepZ - HeightTolerance);
+	QueryStats::RecordLineTrace();
+	if (!GetWorld()->LineTraceSingleByChannel(LandingHit, NewLocation, LandingTraceEnd, UpdatedComponent->GetCollisionObjectType(), QueryParams, ResponseParams)
+		|| !FMath::IsNearlyEqual(LandingHit.ImpactPoint.Z, StepZ, HeightTolerance) || !LandingHit.GetComponent() || LandingHit.GetComponent()->Mobility != EComponentMobility::Static)
+	{
+		// Something the bake doesn't know about is on the step, or the step isn't where the bake put it.
+		TraversabilitySubsystem->RecordStepUp(false);
+		return false;
+	}
+
+	QueryStats::RecordOverlap();
+	if (GetWorld()->OverlapBlockingTestByChannel(Apex, PawnRotation, UpdatedComponent->GetCollisionObjectType(), FCollisionShape::MakeCapsule(PawnRadius, PawnHalfHeight), QueryParams, ResponseParams))
+	{
+		TraversabilitySubsystem->RecordStepUp(false);
+		return false;
+	}
+
+	FScopedMovementUpdate ScopedStepUpMovement(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+	MoveUpdatedComponent(Apex - OldLocation, PawnRotation, false);
+
+	FHitResult ForwardHit;
+	MoveUpdatedComponent(NewLocation - Apex, PawnRotation, true, &ForwardHit);
+	if (ForwardHit.bBlockingHit)
+	{
+		ScopedStepUpMovement.RevertMove();
+		TraversabilitySubsystem->RecordStepUp(false);
+		return false;
+	}
+
+	if (OutStepDownResult)
+	{
+		// Standing at the baked height on whatever the landing trace hit, which need not be the riser that blocked the move.
+		FHitResult FloorHit(1.0f);
+		FloorHit.bBlockingHit = true;
+		FloorHit.Component = LandingHit.Component;
+		FloorHit.HitObjectHandle = LandingHit.HitObjectHandle;
+		FloorHit.PhysMaterial = LandingHit.PhysMaterial;
+		FloorHit.Item = LandingHit.Item;
+		FloorHit.TraceStart = NewLocation;
+		FloorHit.TraceEnd = NewLocation - FVector(0.0f, 0.0f, MAX_FLOOR_DIST);
+		FloorHit.Location = NewLocation;
+		FloorHit.ImpactPoint = FVector(Target.X, Target.Y, StepZ);
+		FloorHit.Normal = FVector::UpVector;
+		FloorHit.ImpactNormal = FVector::UpVector;
+
+		*OutStepDownResult = FStepDownResult();
+		OutStepDownResult->FloorResult.SetFromSweep(FloorHit, MAX_FLOOR_DIST, true);
+		OutStepDownResult->bComputedFloor = true;
 	}
 
+	TraversabilitySubsystem->RecordStepUp(true);
 	return true;
 }
 
@@ -568,17 +1872,223 @@ bool UFPMovementComponent::IsSprinting() const
 	return bIsSprinting;
 }
 
-void UFPMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult) const
+void UFPMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, const FHitResult* DownwardSweepResult) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementFindFloor);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::FindFloor);
+
 	const AFirstPersonProjCharacter* FPPCharacter = Cast<AFirstPersonProjCharacter>(PawnOwner);
 	check(FPPCharacter);
 	const UCapsuleComponent* CharacterCapsule = FPPCharacter->GetCapsuleComponent();
 	check(CharacterCapsule);
 	float PawnRadius, PawnHalfHeight;
 	CharacterCapsule->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+	const FVector2f CapsuleSize(PawnRadius, PawnHalfHeight);
+	const float HeightCheckAdjust = GetFloorHeightCheckAdjust();
+
+	// A downward sweep that ended here already tells us what we are standing on.
+	if (DownwardSweepResult && DownwardSweepResult->IsValidBlockingHit() && !DownwardSweepResult->bStartPenetrating
+		&& DownwardSweepResult->TraceStart.Z > DownwardSweepResult->TraceEnd.Z
+		&& IsWalkableSurface(*DownwardSweepResult)
+		&& IsWithinEdgeTolerance(DownwardSweepResult->Location, DownwardSweepResult->ImpactPoint, PawnRadius))
+	{
+		const float FloorDist = CapsuleLocation.Z - DownwardSweepResult->Location.Z;
+		if (FloorDist >= -MAX_FLOOR_DIST && FloorDist <= MAX_FLOOR_DIST)
+		{
+			OutFloorResult.Clear();
+			OutFloorResult.SetFromSweep(*DownwardSweepResult, FloorDist, true);
+			// Not cached: it was edge tested wider than ComputeFloor's shrunk capsule, so it can't stand in for ComputeFloor later,
+			// and writing it would evict a cached floor that can.
+			FloorCacheStats::RecordSweepAvoided();
+			return;
+		}
+	}
+
+	if (TryReuseCachedFloor(CapsuleLocation, CapsuleSize, HeightCheckAdjust, OutFloorResult))
+	{
+		FloorCacheStats::RecordHit();
+		return;
+	}
+
+	FloorCacheStats::RecordMiss();
+	OutFloorResult.Clear();
+	ComputeFloor(CapsuleLocation, OutFloorResult);
+	UpdateFloorCache(CapsuleLocation, CapsuleSize, HeightCheckAdjust, OutFloorResult);
+}
+
+bool UFPMovementComponent::TryReuseCachedFloor(const FVector& CapsuleLocation, const FVector2f& CapsuleSize, float HeightCheckAdjust, FFindFloorResult& OutFloorResult) const
+{
+	if (!FloorCache.bValid || !CVarFPMovementFloorCache.GetValueOnGameThread() || CapsuleSize != FloorCache.CapsuleSize)
+	{
+		return false;
+	}
+
+	// The reused floor stands in for ComputeFloor, so it must have been found with the same reach. The same capsule size means the same extent.
+	if (HeightCheckAdjust != FloorCache.HeightCheckAdjust)
+	{
+		return false;
+	}
+
+	const UPrimitiveComponent* FloorComponent = FloorCache.FloorComponent.Get();
+	if (!FloorComponent || FloorComponent->Mobility != EComponentMobility::Static || !FloorComponent->GetComponentTransform().Equals(FloorCache.FloorTransform))
+	{
+		return false;
+	}
+
+	// The distance is measured from the last real sweep, not the last reuse, so error can't accumulate across frames.
+	if (FVector::DistSquared(CapsuleLocation, FloorCache.CapsuleLocation) > FMath::Square(CVarFPMovementFloorCacheMaxDisplacement.GetValueOnGameThread()))
+	{
+		return false;
+	}
+
+	return ProjectFloorResult(FloorCache.FloorResult, FloorCache.CapsuleLocation, CapsuleLocation, OutFloorResult);
+}
+
+bool UFPMovementComponent::ProjectFloorResult(const FFindFloorResult& FloorResult, const FVector& FromLocation, const FVector& ToLocation, FFindFloorResult& OutFloorResult) const
+{
+	const FVector FloorNormal = FloorResult.HitResult.Normal;
+	if (FloorNormal.Z <= UE_KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Move the contact along the floor plane, and measure the new distance to it.
+	const FVector Displacement = ToLocation - FromLocation;
+	const float PlaneHeightChange = -(FloorNormal.X * Displacement.X + FloorNormal.Y * Displacement.Y) / FloorNormal.Z;
+	const float FloorDist = FloorResult.FloorDist + Displacement.Z - PlaneHeightChange;
+	if (FloorDist < -MAX_FLOOR_DIST || FloorDist > MaxStepHeight + MAX_FLOOR_DIST)
+	{
+		return false;
+	}
+
+	OutFloorResult = FloorResult;
+	OutFloorResult.FloorDist = FloorDist;
+	FHitResult& Hit = OutFloorResult.HitResult;
+	Hit.TraceStart += Displacement;
+	Hit.TraceEnd += Displacement;
+	Hit.Location = FVector(ToLocation.X, ToLocation.Y, ToLocation.Z - FloorDist);
+	Hit.ImpactPoint += FVector(Displacement.X, Displacement.Y, PlaneHeightChange);
+	return true;
+}
+
+void UFPMovementComponent::UpdateFloorCache(const FVector& CapsuleLocation, const FVector2f& CapsuleSize, float HeightCheckAdjust, const FFindFloorResult& FloorResult) const
+{
+	// Only walkable sweep hits on static primitives are worth keeping. Anything else can change under us without the pawn moving.
+	const UPrimitiveComponent* FloorComponent = FloorResult.HitResult.GetComponent();
+	FloorCache.bValid = FloorResult.IsWalkableFloor() && !FloorResult.bLineTrace && FloorComponent && FloorComponent->Mobility == EComponentMobility::Static
+		&& FloorResult.HitResult.Normal.Z > UE_KINDA_SMALL_NUMBER;
+	if (FloorCache.bValid)
+	{
+		FloorCache.FloorComponent = FloorComponent;
+		FloorCache.FloorTransform = FloorComponent->GetComponentTransform();
+		FloorCache.CapsuleLocation = CapsuleLocation;
+		FloorCache.CapsuleSize = CapsuleSize;
+		FloorCache.HeightCheckAdjust = HeightCheckAdjust;
+		FloorCache.FloorResult = FloorResult;
+	}
+}
+
+void UFPMovementComponent::InvalidateFloorCache()
+{
+	FloorCache.bValid = false;
+}
+
+bool UFPMovementComponent::UseAsyncQueries()
+{
+	return CVarFPMovementAsyncQueries.GetValueOnGameThread() != 0;
+}
+
+void UFPMovementComponent::FindFloorDeferred(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult)
+{
+	if (!UseAsyncQueries())
+	{
+		FindFloor(CapsuleLocation, OutFloorResult);
+		return;
+	}
+
+	const UCapsuleComponent* CharacterCapsule = CachedOwnerChar->GetCapsuleComponent();
+	check(CharacterCapsule);
+	float PawnRadius, PawnHalfHeight;
+	CharacterCapsule->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+	const FVector2f CapsuleSize(PawnRadius, PawnHalfHeight);
+
+	// Only a walkable sweep hit can stand in for FindFloor. Anything else needs the line trace as well, so query synchronously.
+	const FVector PendingLocation = PendingFloorQuery.CapsuleLocation;
+	FHitResult SweepHitResult;
+	FFindFloorResult PendingFloorResult;
+	bool bUsedAsyncResult = false;
+	if (ConsumeAsyncSweep(PendingFloorQuery, CapsuleLocation, CapsuleSize, SweepHitResult) && SweepHitResult.bBlockingHit && IsWalkableSurface(SweepHitResult))
+	{
+		const float TraceHeight = MaxStepHeight + MAX_FLOOR_DIST;
+		PendingFloorResult.SetFromSweep(SweepHitResult, FMath::Max(-MAX_FLOOR_DIST, SweepHitResult.Time * TraceHeight), true);
+		bUsedAsyncResult = ProjectFloorResult(PendingFloorResult, PendingLocation, CapsuleLocation, OutFloorResult);
+	}
+
+	if (bUsedAsyncResult)
+	{
+		INC_DWORD_STAT(STAT_FPMovementAsyncFloorHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_FPMovementAsyncFloorFallbacks);
+		FindFloor(CapsuleLocation, OutFloorResult);
+	}
+
+	// Sweep from here for the next move. The world runs every queued async trace in one batch.
+	const FCollisionShape CapsuleShape = FCollisionShape::MakeCapsule(PawnRadius - CAPSULE_RADIUS_SHRINK_FACTOR, PawnHalfHeight);
+	QueueAsyncSweep(PendingFloorQuery, CapsuleLocation, CapsuleLocation + (FVector::DownVector * (MaxStepHeight + MAX_FLOOR_DIST)), CapsuleSize, CapsuleShape);
+}
+
+bool UFPMovementComponent::ConsumeAsyncSweep(FPendingAsyncQuery& PendingQuery, const FVector& CapsuleLocation, const FVector2f& CapsuleSize, FHitResult& OutHit) const
+{
+	if (!PendingQuery.Handle.IsValid())
+	{
+		return false;
+	}
+
+	FTraceDatum TraceDatum;
+	const bool bHasResult = GetWorld()->QueryTraceData(PendingQuery.Handle, TraceDatum);
+	PendingQuery.Reset();
+
+	if (!bHasResult || PendingQuery.CapsuleSize != CapsuleSize
+		|| FVector::DistSquared(PendingQuery.CapsuleLocation, CapsuleLocation) > FMath::Square(CVarFPMovementAsyncQueriesMaxDisplacement.GetValueOnGameThread()))
+	{
+		return false;
+	}
+
+	OutHit = TraceDatum.OutHits.Num() > 0 ? TraceDatum.OutHits[0] : FHitResult(1.0f);
+	return true;
+}
+
+void UFPMovementComponent::QueueAsyncSweep(FPendingAsyncQuery& PendingQuery, const FVector& Start, const FVector& End, const FVector2f& CapsuleSize, const FCollisionShape& Shape) const
+{
+	FCollisionQueryParams CollisionQueryParams;
+	CollisionQueryParams.AddIgnoredActor(PawnOwner);
+	FCollisionResponseParams ResponseParams;
+	UpdatedPrimitive->InitSweepCollisionParams(CollisionQueryParams, ResponseParams);
+
+	QueryStats::RecordSweep();
+	PendingQuery.Handle = GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, Start, End, UpdatedComponent->GetComponentQuat(), UpdatedComponent->GetCollisionObjectType(), Shape, CollisionQueryParams, ResponseParams);
+	PendingQuery.CapsuleLocation = Start;
+	PendingQuery.CapsuleSize = CapsuleSize;
+}
 
+float UFPMovementComponent::GetFloorHeightCheckAdjust() const
+{
 	// Increase height check slightly if walking, to prevent floor height adjustment from later invalidating the floor result.
-	const float HeightCheckAdjust = (IsMovingOnGround() ? MAX_FLOOR_DIST + UE_KINDA_SMALL_NUMBER : -MAX_FLOOR_DIST);
+	return IsMovingOnGround() ? MAX_FLOOR_DIST + UE_KINDA_SMALL_NUMBER : -MAX_FLOOR_DIST;
+}
+
+void UFPMovementComponent::ComputeFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult) const
+{
+	const AFirstPersonProjCharacter* FPPCharacter = Cast<AFirstPersonProjCharacter>(PawnOwner);
+	check(FPPCharacter);
+	const UCapsuleComponent* CharacterCapsule = FPPCharacter->GetCapsuleComponent();
+	check(CharacterCapsule);
+	float PawnRadius, PawnHalfHeight;
+	CharacterCapsule->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+
+	const float HeightCheckAdjust = GetFloorHeightCheckAdjust();
 	float FloorSweepTraceDist = FMath::Max(MAX_FLOOR_DIST, MaxStepHeight + HeightCheckAdjust);
 	float FloorLineTraceDist = FloorSweepTraceDist;
 
@@ -594,6 +2104,7 @@ void UFPMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorR
 
 
 	FHitResult SweepHitResult;
+	FloorCacheStats::RecordSweep();
 	GetWorld()->SweepSingleByChannel(SweepHitResult, CapsuleLocation, EndTraceLocation, CharacterCapsule->GetComponentQuat(), CharacterCapsule->GetCollisionObjectType(), CapsuleShape, CollisionQueryParams, ResponseParams);
 
 	if (SweepHitResult.bBlockingHit)
@@ -626,6 +2137,7 @@ void UFPMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorR
 		CollisionQueryParams.TraceTag = SCENE_QUERY_STAT_NAME_ONLY(FloorLineTrace);
 
 		FHitResult Hit(1.f);
+		QueryStats::RecordLineTrace();
 		bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(Hit, LineTraceStart, LineTraceStart + Down, CollisionChannel, CollisionQueryParams, ResponseParams);
 
 		if (bBlockingHit)
@@ -708,6 +2220,9 @@ void UFPMovementComponent::OnGroundMovementStopped()
 
 float UFPMovementComponent::SlideAlongSurface(const FVector& Delta, float Time, const FVector& Normal, FHitResult& Hit, bool bHandleImpact)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementSlideAlongSurface);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::SlideAlongSurface);
+
 	if (!Hit.bBlockingHit)
 	{
 		return 0.0f;
@@ -748,7 +2263,7 @@ void UFPMovementComponent::StartFalling()
 	if (!IsFalling())
 	{
 		CurrentFloor.Clear();
-		TimeFallStartedSeconds = GetWorld()->GetTimeSeconds();
+		TimeFallStartedSeconds = GetMovementTimeSeconds();
 		InitialJumpVelocity= Velocity.GetSafeNormal2D() * Velocity.Size2D();
 		SetMovementMode(EFPMovementMode::Falling);
 	}
@@ -756,6 +2271,10 @@ void UFPMovementComponent::StartFalling()
 
 void UFPMovementComponent::PerformFallMovement(const float DeltaTime, const FVector& InputVector)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementFall);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::PerformFallMovement);
+	FPMovementProfile::FPhaseScope ProfileScope(FPMovementProfile::EPhase::Fall);
+
 	if (DeltaTime <= 0.0f)
 	{
 		return;
@@ -793,11 +2312,13 @@ void UFPMovementComponent::PerformFallMovement(const float DeltaTime, const FVec
 			if (CanBeginSliding(CurrentFloor))
 			{
 				StartSliding(CurrentFloor);
+				HandOffRemainingTime(DeltaTime * (1.0f - MoveHitResult.Time));
 				return;
 			}
 			else if (CurrentFloor.IsWalkableFloor())
 			{
 				StartGroundMovement();
+				HandOffRemainingTime(DeltaTime * (1.0f - MoveHitResult.Time));
 				return;
 			}
 		}
@@ -816,83 +2337,15 @@ void UFPMovementComponent::PerformFallMovement(const float DeltaTime, const FVec
 
 void UFPMovementComponent::CalculateFallVelocity(const FVector& InputVector, float DeltaTime)
 {
-	const FVector ForwardVector = UpdatedComponent->GetForwardVector();
-	const FVector RightVector = UpdatedComponent->GetRightVector();
-	const FVector LateralInputVector = InputVector.ProjectOnTo(RightVector);
-
-	FVector ForwardVelocity = Velocity.ProjectOnToNormal(ForwardVector);
-	FVector LateralVelocity = Velocity.ProjectOnToNormal(RightVector);
-
-	float MaxForwardAirVelocity = FMath::Min(MaxAirSpeed, FMath::Max(InitialJumpVelocity.Size2D(), MaxAirSpeed * .20f));
-	FVector TargetForwardVelocity = InputVector.IsNearlyZero() ? ForwardVelocity : InputVector.ProjectOnToNormal(ForwardVector) * MaxForwardAirVelocity;
-
-	FVector InputLateralTargetVelocity = LateralInputVector * MaxAirStrafe;
-	FVector TargetLateralVelocity = InputVector.IsNearlyZero() ? LateralVelocity : FMath::Max(InputLateralTargetVelocity.Size(), LateralVelocity.Size()) * InputLateralTargetVelocity.GetSafeNormal2D();
-
-	//UE_LOG(LogTemp, Warning, TEXT("Forward Velocity: %s, Lateral Velocity: %s, Current Velocity: %s"), *ForwardVelocity.ToString(), *LateralVelocity.ToString(), *Velocity.ToString());
-	//UE_LOG(LogTemp, Warning, TEXT("Input Vec: %s, Target Forward Velocity: %s, Target Lateral Velocity: %s"), *InputVector.GetSafeNormal2D().ToString(), *TargetForwardVelocity.ToString(), *TargetLateralVelocity.ToString());
-
-	const FVector TargetVelocity = TargetForwardVelocity + TargetLateralVelocity + (FVector::DownVector * GetPhysicsVolume()->TerminalVelocity);
-	FVector Acceleration = TargetVelocity - Velocity;
-
-	FVector ForwardAcceleration = Acceleration.ProjectOnToNormal(ForwardVector);
-	const float ForwardAccelerationDot = ForwardAcceleration.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
-	if (ForwardAccelerationDot <= -.1f)
-	{
-		ForwardAcceleration = ForwardAcceleration.GetSafeNormal2D() * AirBrakingDeceleration * -ForwardAccelerationDot;
-	}
-	else
-	{
-		// Increase acceleration if the player is providing lateral input in the direction they want to turn in the air.
-		// Start by checking how orthogonal the forward vector and velocity are. The more orthogonal, the more the player has to turn.
-		// Scale this value by the dot product between the initial jump vector and the input. This is to ensure the player is inputting the correct direction into the turn.
-		const float TurnAccelerationScalar = (ForwardVector ^ Velocity.GetSafeNormal2D()).Size() * FMath::Max(0.0f, InitialJumpVelocity.GetSafeNormal2D() | -LateralInputVector);
-		const float ForwardAirAcceleration = AirAcceleration * FMath::Lerp(1.0f, 3.0f, TurnAccelerationScalar);
-		//UE_LOG(LogTemp, Warning, TEXT("Air acceleration bonus: %f, final: %f"),  AirAccelerationInputBonus, AirAcceleration + AirAccelerationInputBonus);
-		ForwardAcceleration = ForwardAcceleration.GetSafeNormal2D() * ForwardAirAcceleration;
-	}
-
-	FVector LateralAcceleration = Acceleration.ProjectOnToNormal(RightVector);
-	const float LateralAccelerationDot = LateralAcceleration.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
-	if (LateralAccelerationDot <= -.1f)
-	{
-		LateralAcceleration = LateralAcceleration.GetSafeNormal2D() * AirBrakingDeceleration * -LateralAccelerationDot;
-	}
-	else
-	{
-		LateralAcceleration = LateralAcceleration.GetSafeNormal2D() * AirAcceleration;
-	}
-
-	//UE_LOG(LogTemp, Warning, TEXT("Lat acc: %s, Fow acc:%s"), *LateralAcceleration.ToString(), *ForwardAcceleration.ToString());
-	
-	FVector VelocityDelta = LateralAcceleration + ForwardAcceleration;
-
-	// Subtract the deceleration vector from the velocity to allow the player to change directions.
-	// Scale by friction.
-	if (!Acceleration.GetSafeNormal2D().IsNearlyZero())
-	{
-		const FVector Velocity2D = FVector(Velocity.X, Velocity.Y, 0);
-		Velocity = Velocity - (Velocity2D - VelocityDelta.GetSafeNormal2D() * Velocity2D.Size()) * DeltaTime * AirFrictionFactor;
-		Acceleration = TargetVelocity - Velocity;
-		//UE_LOG(LogTemp, Warning, TEXT("Old vel: %s, New Vel: %s, Accel vector: %s"), *OldVel.ToString(), *Velocity.ToString(), *Acceleration.ToString());
-	}
-	
-	if (VelocityDelta.Size2D() > Acceleration.Size2D())
-	{
-		VelocityDelta *= Acceleration.Size2D() / VelocityDelta.Size2D();
-	}
-
-	VelocityDelta.Z = GetGravityZ();
-	VelocityDelta *= DeltaTime;
-	//UE_LOG(LogTemp, Warning, TEXT("Target Velocity: %s, Vel Delta: %s"), *TargetVelocity.ToString(),  *VelocityDelta.ToString());
-
-	Velocity += VelocityDelta;
-	Velocity.Z = FMath::Max(Velocity.Z, -GetPhysicsVolume()->TerminalVelocity);
-	//UE_LOG(LogTemp, Warning, TEXT("New Velocity: %s"), *Velocity.ToString());
+	RunVelocityKernel(EFPMovementKernel::Fall, InputVector, DeltaTime);
 }
 
 void UFPMovementComponent::PerformSlideMovement(const float DeltaTime, const FVector& InputVector)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementSlide);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::PerformSlideMovement);
+	FPMovementProfile::FPhaseScope ProfileScope(FPMovementProfile::EPhase::Slide);
+
 	if (DeltaTime <= 0.0f)
 	{
 		return;
@@ -901,67 +2354,62 @@ void UFPMovementComponent::PerformSlideMovement(const float DeltaTime, const FVe
 	if (CachedOwnerChar->ConsumeJumpInput() && CanJump())
 	{
 		DoJump();
-		PerformFallMovement(DeltaTime, InputVector);
+		HandOffRemainingTime(DeltaTime);
 		return;
 	}
 
 	TickCrouch(DeltaTime);
 
 	float RemainingDeltaTime = DeltaTime;
-	const FVector PositionBeforeSlide = UpdatedComponent->GetComponentLocation();
 	int32 Iterations = 0;
 	FVector GravitationalAcceleration = FVector::ZeroVector;
 	bool bCouldPreviouslyWalkOnSurface = SlideFloorResult.IsWalkableFloor();
 
-	while (RemainingDeltaTime > 0.0f && Iterations < 3)
+	// Each iteration accelerates along the surface for the time it moves, until the move isn't blocked.
+	while (RemainingDeltaTime > UE_KINDA_SMALL_NUMBER && Iterations < MaxSlideIterations)
 	{
-		CalculateSlideVelocity(DeltaTime, InputVector, GravitationalAcceleration);
-		FVector MoveDelta = Velocity * RemainingDeltaTime;
-		FHitResult SlideHitResult = SlideFloorResult.HitResult;
-		SlideAlongSurface(MoveDelta, 1.0f, SlideFloorResult.HitResult.Normal, SlideHitResult, true);
-		RemainingDeltaTime -= RemainingDeltaTime * SlideHitResult.Time;
+		++Iterations;
+		QueryStats::RecordSlideIteration();
 
-		/*
-		if (SlideHitResult.bBlockingHit)
+		const FVector SurfaceNormal = SlideFloorResult.HitResult.Normal;
+		const FVector StartVelocity = Velocity;
+		CalculateSlideVelocity(RemainingDeltaTime, InputVector, GravitationalAcceleration);
+
+		const FVector MoveDelta = FVector::VectorPlaneProject(Velocity * RemainingDeltaTime, SurfaceNormal);
+		if (MoveDelta.IsNearlyZero())
 		{
-			bool bShouldMoveAgain = true;
-			if (FMath::IsNearlyZero(SlideHitResult.Normal.Z))
-			{
-				const FVector Vel2D = Velocity.GetSafeNormal2D();
-				const float VelocityNormalDot = -SlideHitResult.Normal | Vel2D;
-				if (VelocityNormalDot <= .6)
-				{
-					// Try to bounce off of the surface.
-					const FVector DeflectionVectorDirection2D = Vel2D - Vel2D.ProjectOnToNormal(SlideHitResult.Normal) * 2;
-					const FVector NewVelocity = DeflectionVectorDirection2D * Velocity.Size2D() * (1.0f - VelocityNormalDot);
-					Velocity = FVector(NewVelocity.X, NewVelocity.Y, Velocity.Z);
-				}
-				else
-				{
-					break;
-				}
-			}
-			else
-			{
-				// We may have hit another flatter surface. Recheck the floor and try again.
-				FindFloor(UpdatedComponent->GetComponentLocation(), SlideFloorResult);
+			break;
+		}
 
-				if (CanSlideOnSurface(SlideFloorResult))
-				{
-					const FVector GravityAccelerationDirection = FVector::VectorPlaneProject(FVector::DownVector, SlideFloorResult.HitResult.Normal).GetSafeNormal();
-					const FVector CurrentVelDirection = Velocity.GetSafeNormal();
-					const FVector NewVelDirection = FVector(CurrentVelDirection.X, CurrentVelDirection.Y, GravityAccelerationDirection.Z).GetSafeNormal();
-					Velocity = Velocity.Size() * NewVelDirection;
-				}
-				else
-				{
-					break;
-				}
-			}
+		FHitResult SlideHitResult(1.0f);
+		SafeMoveUpdatedComponent(MoveDelta, UpdatedComponent->GetComponentQuat(), true, SlideHitResult);
+		if (!SlideHitResult.IsValidBlockingHit())
+		{
+			RemainingDeltaTime = 0.0f;
+			break;
 		}
-		*/
 
-		++Iterations;
+		// The slide kernel is linear in time, so this is the velocity at the hit.
+		Velocity = StartVelocity + (Velocity - StartVelocity) * SlideHitResult.Time;
+		RemainingDeltaTime -= RemainingDeltaTime * SlideHitResult.Time;
+
+		if (SlideHitResult.bStartPenetrating)
+		{
+			break;
+		}
+
+		if (SlideHitResult.Normal.Z >= SlideFloorZ)
+		{
+			// Onto a flatter surface, which the rest of the slide follows.
+			SlideFloorResult.SetFromSweep(SlideHitResult, 0.0f, IsWalkableSurface(SlideHitResult));
+			Velocity = FVector::VectorPlaneProject(Velocity, SlideHitResult.Normal).GetSafeNormal() * Velocity.Size();
+		}
+		else
+		{
+			// Into a wall, which takes away the velocity into it.
+			HandleImpact(SlideHitResult, RemainingDeltaTime, MoveDelta);
+			Velocity = FVector::VectorPlaneProject(Velocity, SlideHitResult.Normal);
+		}
 	}
 
 	FindFloor(UpdatedComponent->GetComponentLocation(), SlideFloorResult);
@@ -970,27 +2418,21 @@ void UFPMovementComponent::PerformSlideMovement(const float DeltaTime, const FVe
 		CachedOwnerChar->OnLanded(SlideFloorResult.HitResult);
 	}
 
-	if (RemainingDeltaTime < DeltaTime)
-	{
-		Velocity = (UpdatedComponent->GetComponentLocation() - PositionBeforeSlide) / (DeltaTime - RemainingDeltaTime);
-	}
-
 	bool bShouldStopSlide = !bWantsToCrouch || !CanSlideOnSurface(SlideFloorResult);
 	bShouldStopSlide |= GravitationalAcceleration.IsNearlyZero(4.0f) && Velocity.SizeSquared2D() <= CachedSlideSpeedThresholdSquared;
-	UE_LOG(LogTemp, Warning, TEXT("Velocity: %s, Grav acceleration: %s"), *Velocity.ToString(), *GravitationalAcceleration.ToString());
 	if (bShouldStopSlide)
 	{
 		if (!SlideFloorResult.IsWalkableFloor())
 		{
 			StartFalling();
-			PerformFallMovement(RemainingDeltaTime, InputVector);
 		}
 		else
 		{
 			CurrentFloor = SlideFloorResult;
 			StartGroundMovement();
-			PerformWalkMovement(RemainingDeltaTime, InputVector);
 		}
+
+		HandOffRemainingTime(RemainingDeltaTime);
 	}
 }
 
@@ -1024,44 +2466,7 @@ void UFPMovementComponent::StartSliding(const FFindFloorResult& NewSlideFloor)
 
 void UFPMovementComponent::CalculateSlideVelocity(float DeltaTime, const FVector& InputVector, FVector& OutGravitationalAccelVec)
 {
-	const FVector GravityAcceelerationDirection = FVector::VectorPlaneProject(FVector::DownVector, SlideFloorResult.HitResult.Normal).GetSafeNormal();
-	const float GravityAccelerationRatio = (1.0f - SlideFloorResult.HitResult.Normal.Z) / (1.0f - SlideFloorZ);
-	OutGravitationalAccelVec = GravityAcceelerationDirection * SlideGravityAcceleration * GravityAccelerationRatio;
-
-	FVector SlideFrictionAccelerationVector = FVector::ZeroVector;
-	const float VelocityGravityDot = GravityAcceelerationDirection | Velocity.GetSafeNormal();
-	// If we are moving perpindicular to the gravity vector, apply slide friction.
-	if (FMath::Abs(VelocityGravityDot) <= .1f)
-	{
-		SlideFrictionAccelerationVector = -Velocity.GetSafeNormal2D() * Velocity.Size2D() * SlideFrictionFactor * (1.0f - GravityAccelerationRatio);
-	}
-
-	// Consider lateral slide input and deceleration.
-	FVector InputAcceleration = FVector::ZeroVector;
-
-	float InputVelocityDot = Velocity.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
-	if (InputVelocityDot <= -.45f)
-	{
-		InputAcceleration += Velocity.GetSafeNormal() * InputVelocityDot * SlideBrakingDeceleration;
-	}
-	if (!InputAcceleration.IsNearlyZero())
-	{
-		// Subtract the deceleration vector from the velocity to allow the player to change directions.
-		// Scale by friction.
-		const FVector Velocity2D = FVector(Velocity.X, Velocity.Y, 0);
-		//Velocity = Velocity - (Velocity2D - InputAcceleration.GetSafeNormal() * Velocity2D.Size()) * DeltaTime * .3f;
-		//UE_LOG(LogTemp, Warning, TEXT("Old vel: %s, New Vel: %s, Accel vector: %s"), *OldVel.ToString(), *Velocity.ToString(), *Acceleration.ToString());
-	}
-
-	FVector LateralVec = Velocity.GetSafeNormal2D() ^ FVector::UpVector;
-	const FVector LateralInputVec = InputVector.ProjectOnToNormal(LateralVec) * SlideLateralAcceleration;
-	//InputAcceleration += LateralInputVec;
-	//UE_LOG(LogTemp, Warning, TEXT("Projection: %s, Lateral Vector: %s"), *InputVector.ProjectOnToNormal(LateralVec).ToString(), *LateralInputVec.ToString());
-
-	//UE_LOG(LogTemp, Warning, TEXT("Slide: Ratio: %f, Grav accel: %s, friction: %s, input: %s"), GravityAccelerationRatio, *OutGravitationalAccelVec.ToString(), *SlideFrictionAccelerationVector.ToString(), *InputAcceleration.ToString());
-	FVector FinalAcceleration = (OutGravitationalAccelVec + SlideFrictionAccelerationVector + InputAcceleration) * DeltaTime;
-
-	Velocity += FinalAcceleration;
+	OutGravitationalAccelVec = RunVelocityKernel(EFPMovementKernel::Slide, InputVector, DeltaTime);
 }
 
 bool UFPMovementComponent::IsSliding() const
@@ -1083,18 +2488,31 @@ float UFPMovementComponent::GetCrouchFrac() const
 
 void UFPMovementComponent::OnMovementModeChanged(EFPMovementMode OldMovementMode, EFPMovementMode NewMovementMode)
 {
-	switch (OldMovementMode)
+	FPMovementProfile::FModeSwitchScope ProfileScope;
+
+	const FFPMovementModeFunctions& OldMode = FFPMovementModeRegistry::Get(OldMovementMode);
+	if (OldMode.Exit)
 	{
-		case EFPMovementMode::Walking:
-			OnGroundMovementStopped();
-			break;
-		default:
-			break;
+		OldMode.Exit(*this, NewMovementMode);
 	}
+
+	ModeState.Reset();
+
+	const FFPMovementModeFunctions& NewMode = FFPMovementModeRegistry::Get(NewMovementMode);
+	if (NewMode.Enter)
+	{
+		NewMode.Enter(*this, OldMovementMode);
+	}
+
+	// Mode changes (landing, starting to fall or slide) need full rate simulation to look right.
+	PromoteMovementLOD();
 }
 
 bool UFPMovementComponent::CanCharacterUncrouch() const
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementCanUncrouch);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::CanCharacterUncrouch);
+
 	if (!IsCrouching())
 	{
 		return true;
@@ -1109,6 +2527,23 @@ bool UFPMovementComponent::CanCharacterUncrouch() const
 	const float HalfHeightDifference = CachedDefaultCapsuleHalfHeight - CapsuleCrouchHalfHeight;
 	const FVector UncrouchPosition = UpdatedComponent->GetComponentLocation() + (FVector::UpVector * HalfHeightDifference);
 
+	if (UseAsyncQueries())
+	{
+		// Use the headroom swept at the end of the previous tick if we haven't moved much since, and queue the next one.
+		const FVector2f CapsuleSize(PawnRadius, PawnHalfHeight);
+		FHitResult PendingHitResult;
+		const bool bUsedAsyncResult = ConsumeAsyncSweep(PendingHeadroomQuery, UpdatedComponent->GetComponentLocation(), CapsuleSize, PendingHitResult);
+		QueueAsyncSweep(PendingHeadroomQuery, UpdatedComponent->GetComponentLocation(), UncrouchPosition, CapsuleSize, CapsuleShape);
+
+		if (bUsedAsyncResult)
+		{
+			INC_DWORD_STAT(STAT_FPMovementAsyncHeadroomHits);
+			return !PendingHitResult.bBlockingHit;
+		}
+
+		INC_DWORD_STAT(STAT_FPMovementAsyncHeadroomFallbacks);
+	}
+
 	FCollisionQueryParams CollisionQueryParams;
 	CollisionQueryParams.AddIgnoredActor(PawnOwner);
 	FCollisionResponseParams ResponseParams;
@@ -1116,12 +2551,15 @@ bool UFPMovementComponent::CanCharacterUncrouch() const
 	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
 
 	FHitResult HitResult(1.0f);
+	QueryStats::RecordSweep();
 	GetWorld()->SweepSingleByChannel(HitResult, UpdatedComponent->GetComponentLocation(), UncrouchPosition, UpdatedComponent->GetComponentQuat(), CollisionChannel, CapsuleShape, CollisionQueryParams, ResponseParams);
 
-	if (HitResult.bBlockingHit)
+#if ENABLE_DRAW_DEBUG
+	if (HitResult.bBlockingHit && CVarFPMovementDebugUncrouch.GetValueOnGameThread())
 	{
 		DrawDebugSphere(GetWorld(), HitResult.ImpactPoint, 20.0f, 4, FColor::Red, false, 5.0f, 0, .5f);
 	}
+#endif // ENABLE_DRAW_DEBUG
 	return !HitResult.bBlockingHit;
 }
 
@@ -1142,7 +2580,7 @@ bool UFPMovementComponent::IsFalling() const
 
 bool UFPMovementComponent::IsMovingOnGround() const
 {
-	return UpdatedComponent && MovementMode == EFPMovementMode::Walking || MovementMode == EFPMovementMode::Sliding;
+	return UpdatedComponent && (MovementMode == EFPMovementMode::Walking || MovementMode == EFPMovementMode::Sliding || MovementMode == EFPMovementMode::NavWalking);
 }
 
 float UFPMovementComponent::GetGravityZ() const
@@ -1165,11 +2603,11 @@ bool UFPMovementComponent::CanJump()
 	const AFirstPersonProjCharacter* FPPCharacter = GetFPPOwner();
 	check(FPPCharacter);
 
-	if (MovementMode == EFPMovementMode::Falling && (GetWorld()->GetTimeSeconds() - TimeFallStartedSeconds) > JumpGracePeriod)
+	if (MovementMode == EFPMovementMode::Falling && (GetMovementTimeSeconds() - TimeFallStartedSeconds) > JumpGracePeriod)
 	{
 		return false;
 	}
-	if (MovementMode == EFPMovementMode::Walking && IsCrouching())
+	if ((MovementMode == EFPMovementMode::Walking || MovementMode == EFPMovementMode::NavWalking) && IsCrouching())
 	{
 		return false;
 	}
@@ -1210,6 +2648,9 @@ void UFPMovementComponent::SetWantsToCrouch(bool WantsToCrouch)
 
 void UFPMovementComponent::TickCrouch(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementTickCrouch);
+	TRACE_CPUPROFILER_EVENT_SCOPE(UFPMovementComponent::TickCrouch);
+
 	AFirstPersonProjCharacter* FPPCharacter = GetFPPOwner();
 	check(FPPCharacter);
 
@@ -1220,6 +2661,7 @@ void UFPMovementComponent::TickCrouch(float DeltaTime)
 		if (bWasPreviouslyUncrouched && CrouchFrac >= .5f)
 		{
 			FPPCharacter->GetCapsuleComponent()->SetCapsuleHalfHeight(CapsuleCrouchHalfHeight);
+			INC_DWORD_STAT_BY(STAT_FPMovementDeferredUpdates, UpdatedComponent->IsDeferringMovementUpdates() ? 1 : 0);
 			FPPCharacter->OnCrouchChanged(true);
 
 			if (IsMovingOnGround())
@@ -1227,6 +2669,9 @@ void UFPMovementComponent::TickCrouch(float DeltaTime)
 				const float CrouchCapsuleDelta = CachedDefaultCapsuleHalfHeight - CapsuleCrouchHalfHeight;
 				const FVector NewPosition = UpdatedComponent->GetComponentLocation() + (FVector::DownVector * CrouchCapsuleDelta);
 				UpdatedComponent->SetWorldLocation(NewPosition);
+
+				// Crouching shifts the capsule center, not the pawn. Don't interpolate it.
+				PreviousSubstepLocation += FVector::DownVector * CrouchCapsuleDelta;
 			}
 		}
 
@@ -1243,6 +2688,7 @@ void UFPMovementComponent::TickCrouch(float DeltaTime)
 			if (bWasPreviouslyCrouched && CrouchFrac < .5f)
 			{
 				FPPCharacter->GetCapsuleComponent()->SetCapsuleHalfHeight(CachedDefaultCapsuleHalfHeight);
+				INC_DWORD_STAT_BY(STAT_FPMovementDeferredUpdates, UpdatedComponent->IsDeferringMovementUpdates() ? 1 : 0);
 				FPPCharacter->OnCrouchChanged(false);
 
 				if (IsMovingOnGround())
@@ -1250,6 +2696,9 @@ void UFPMovementComponent::TickCrouch(float DeltaTime)
 					const float CrouchCapsuleDelta = CachedDefaultCapsuleHalfHeight - CapsuleCrouchHalfHeight;
 					const FVector NewPosition = UpdatedComponent->GetComponentLocation() + (FVector::UpVector * CrouchCapsuleDelta);
 					UpdatedComponent->SetWorldLocation(NewPosition);
+
+					// Crouching shifts the capsule center, not the pawn. Don't interpolate it.
+					PreviousSubstepLocation += FVector::UpVector * CrouchCapsuleDelta;
 				}
 			}
 
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementModes.h"
+#include "FPMovementComponent.h"
+#include "FPMovementNetworking.h"
+
+/** The EFPMovementMode modes, forwarding to UFPMovementComponent. */
+class FFPBuiltinMovementModes
+{
+public:
+
+	static void TickWalking(UFPMovementComponent& Component, float DeltaTime, const FVector& InputVector)
+	{
+		Component.PerformWalkMovement(DeltaTime, InputVector);
+	}
+
+	static void ExitWalking(UFPMovementComponent& Component, uint8 NewMode)
+	{
+		Component.OnGroundMovementStopped();
+	}
+
+	static void TickSliding(UFPMovementComponent& Component, float DeltaTime, const FVector& InputVector)
+	{
+		Component.PerformSlideMovement(DeltaTime, InputVector);
+	}
+
+	static void TickNavWalking(UFPMovementComponent& Component, float DeltaTime, const FVector& InputVector)
+	{
+		Component.PerformNavWalkMovement(DeltaTime, InputVector);
+	}
+
+	static void TickFalling(UFPMovementComponent& Component, float DeltaTime, const FVector& InputVector)
+	{
+		Component.PerformFallMovement(DeltaTime, InputVector);
+	}
+};
+
+static_assert(EFPMovementMode::None == 0 && EFPMovementMode::Walking == 1 && EFPMovementMode::Sliding == 2 && EFPMovementMode::NavWalking == 3 && EFPMovementMode::Falling == 4,
+	"FFPMovementModeRegistry::Modes lists the built in modes in EFPMovementMode order.");
+static_assert(EFPMovementMode::MAX <= FFPMovementModeRegistry::MaxModes, "EFPMovementMode has more modes than FFPMovementModeRegistry holds.");
+static_assert(FFPMovementModeRegistry::MaxModes == 1 << FFPCompactMovementState::MovementModeBits, "FFPMovementModeRegistry::MaxModes must match the bits movement modes are replicated in.");
+
+// Constant initialized, so the built in modes are there before any static constructor runs.
+FFPMovementModeFunctions FFPMovementModeRegistry::Modes[MaxModes] =
+{
+	{ TEXT("None") },
+	{ TEXT("Walking"), &FFPBuiltinMovementModes::TickWalking, nullptr, &FFPBuiltinMovementModes::ExitWalking },
+	{ TEXT("Sliding"), &FFPBuiltinMovementModes::TickSliding },
+	{ TEXT("NavWalking"), &FFPBuiltinMovementModes::TickNavWalking },
+	{ TEXT("Falling"), &FFPBuiltinMovementModes::TickFalling },
+};
+
+int32 FFPMovementModeRegistry::Register(const FFPMovementModeFunctions& Functions)
+{
+	check(IsInGameThread());
+	check(Functions.IsRegistered());
+
+	for (int32 Mode = EFPMovementMode::MAX; Mode < MaxModes; ++Mode)
+	{
+		if (!Modes[Mode].IsRegistered())
+		{
+			Modes[Mode] = Functions;
+			UE_LOG(LogFPMovement, Log, TEXT("Registered movement mode %s as %d"), GetName(Mode), Mode);
+			return Mode;
+		}
+	}
+
+	UE_LOG(LogFPMovement, Error, TEXT("Couldn't register movement mode %s, all %d modes are taken."), Functions.Name ? Functions.Name : TEXT("?"), MaxModes);
+	return INDEX_NONE;
+}
+
+void FFPMovementModeRegistry::Unregister(int32 Mode)
+{
+	check(IsInGameThread());
+
+	if (Mode >= EFPMovementMode::MAX && Mode < MaxModes)
+	{
+		Modes[Mode] = FFPMovementModeFunctions();
+	}
+}
+
+const TCHAR* FFPMovementModeRegistry::GetName(int32 Mode)
+{
+	return Get(Mode).Name ? Get(Mode).Name : TEXT("Unregistered");
+}
@@ -0,0 +1,290 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementNetworking.h"
+#include "FPMovementComponent.h"
+#include "UObject/CoreNet.h"
+
+static TAutoConsoleVariable<int32> CVarFPMovementNetCombineMoves(
+	TEXT("FPMovement.Net.CombineMoves"),
+	1,
+	TEXT("If non-zero, consecutive client moves with the same input that walked at a constant velocity are combined and sent to the server in one ServerMove."));
+
+static TAutoConsoleVariable<float> CVarFPMovementNetMaxCombinedDeltaTime(
+	TEXT("FPMovement.Net.MaxCombinedDeltaTime"),
+	1.0f / 30.0f,
+	TEXT("Longest delta time in seconds of a combined client move. Also the longest a move is held back waiting to be combined. Keep below FPMovement.Net.MaxMoveDeltaTime."));
+
+namespace FPMovementNetQuantize
+{
+	/** Input axes are sent as [0, 254], with 127 for zero so that no input stays exactly zero. */
+	static constexpr uint32 InputAxisMax = 255;
+	static constexpr float InputAxisScale = 127.0f;
+
+	/** Delta time is sent in tenths of a millisecond. 14 bits cover moves up to 1.6 seconds. */
+	static constexpr uint32 DeltaTimeMax = 1 << 14;
+	static constexpr float DeltaTimeScale = 10000.0f;
+
+	/** Enough for every EFPMoveFlags bit, and for every EFPMovementMode. */
+	static constexpr uint32 FlagsMax = 1 << 3;
+	static constexpr uint32 MovementModeMax = 1 << FFPCompactMovementState::MovementModeBits;
+
+	static uint32 CompressInputAxis(float Value)
+	{
+		return static_cast<uint32>(FMath::RoundToInt(FMath::Clamp(Value, -1.0f, 1.0f) * InputAxisScale) + InputAxisScale);
+	}
+
+	static float DecompressInputAxis(uint32 Value)
+	{
+		return (static_cast<float>(Value) - InputAxisScale) / InputAxisScale;
+	}
+}
+
+bool FFPCompactMovementState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	static_assert(FFPMovementModeRegistry::MaxModes <= FPMovementNetQuantize::MovementModeMax, "Movement modes no longer fit in FFPCompactMovementState.");
+
+	uint32 PackedMovementMode = MovementMode;
+	Ar.SerializeInt(PackedMovementMode, FPMovementNetQuantize::MovementModeMax);
+	MovementMode = static_cast<uint8>(PackedMovementMode);
+
+	Ar << QuantizedCrouchFrac;
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FFPNetMove::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace FPMovementNetQuantize;
+
+	Ar.SerializeIntPacked(MoveId);
+
+	uint32 PackedDeltaTime = FMath::Min<uint32>(FMath::RoundToInt(FMath::Max(DeltaTime, 0.0f) * DeltaTimeScale), DeltaTimeMax - 1);
+	Ar.SerializeInt(PackedDeltaTime, DeltaTimeMax);
+
+	uint32 PackedInputX = CompressInputAxis(InputVector.X);
+	uint32 PackedInputY = CompressInputAxis(InputVector.Y);
+	Ar.SerializeInt(PackedInputX, InputAxisMax);
+	Ar.SerializeInt(PackedInputY, InputAxisMax);
+
+	uint16 PackedYaw = FRotator::CompressAxisToShort(ControlRotation.Yaw);
+	uint16 PackedPitch = FRotator::CompressAxisToShort(ControlRotation.Pitch);
+	Ar << PackedYaw;
+	Ar << PackedPitch;
+
+	uint32 PackedFlags = Flags;
+	Ar.SerializeInt(PackedFlags, FlagsMax);
+
+	ClientLocation.NetSerialize(Ar, Map, bOutSuccess);
+
+	if (Ar.IsLoading())
+	{
+		DeltaTime = PackedDeltaTime / DeltaTimeScale;
+		InputVector = FVector(DecompressInputAxis(PackedInputX), DecompressInputAxis(PackedInputY), 0.0f);
+		ControlRotation = FRotator(FRotator::DecompressAxisFromShort(PackedPitch), FRotator::DecompressAxisFromShort(PackedYaw), 0.0f);
+		Flags = static_cast<uint8>(PackedFlags);
+	}
+
+	return true;
+}
+
+FVector FFPNetMove::QuantizeInputVector(const FVector& InputVector)
+{
+	using namespace FPMovementNetQuantize;
+
+	return FVector(DecompressInputAxis(CompressInputAxis(InputVector.X)), DecompressInputAxis(CompressInputAxis(InputVector.Y)), 0.0f);
+}
+
+FRotator FFPNetMove::QuantizeControlRotation(const FRotator& ControlRotation)
+{
+	return FRotator(FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ControlRotation.Pitch)),
+		FRotator::DecompressAxisFromShort(FRotator::CompressAxisToShort(ControlRotation.Yaw)), 0.0f);
+}
+
+bool FFPMoveAdjustment::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar.SerializeIntPacked(MoveId);
+
+	bOutSuccess = true;
+	bool bSuccess = true;
+	Location.NetSerialize(Ar, Map, bSuccess);
+	bOutSuccess &= bSuccess;
+	Velocity.NetSerialize(Ar, Map, bSuccess);
+	bOutSuccess &= bSuccess;
+	InitialJumpVelocity.NetSerialize(Ar, Map, bSuccess);
+	bOutSuccess &= bSuccess;
+	State.NetSerialize(Ar, Map, bSuccess);
+	bOutSuccess &= bSuccess;
+
+	return true;
+}
+
+float FFPSavedMove::GetMaxCombinedDeltaTime()
+{
+	return CVarFPMovementNetCombineMoves.GetValueOnGameThread() != 0 ? CVarFPMovementNetMaxCombinedDeltaTime.GetValueOnGameThread() : 0.0f;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPMovementNetBandwidth
+{
+	/**
+	 * Rough cost of one unreliable RPC on an open actor channel, for the bunch header and function handle.
+	 * Packet and UDP headers are shared with everything else sent that frame and left out.
+	 */
+	static constexpr int32 RpcOverheadBits = 48;
+
+	/** ClientAckGoodMove sends its move id as a plain uint32. */
+	static constexpr int32 AckPayloadBits = 32;
+
+	struct FInputSegment
+	{
+		float Duration;
+		FVector InputVector;
+		float YawRate;
+		uint8 Flags;
+		bool bJumpAtStart;
+	};
+
+	/** A few seconds of scripted play: running, running while looking around, idling, a strafing jump, and looking around while crouched. */
+	static const FInputSegment Script[] =
+	{
+		{ 2.0f, FVector(1.0f, 0.0f, 0.0f), 0.0f, FPMoveFlag_Sprint, false },
+		{ 1.0f, FVector(1.0f, 0.0f, 0.0f), 90.0f, FPMoveFlag_None, false },
+		{ 0.5f, FVector::ZeroVector, 0.0f, FPMoveFlag_None, false },
+		{ 1.5f, FVector(0.0f, 1.0f, 0.0f), 0.0f, FPMoveFlag_None, true },
+		{ 1.0f, FVector::ZeroVector, 45.0f, FPMoveFlag_Crouch, false },
+	};
+
+	struct FSessionResult
+	{
+		int32 NumMovesSent = 0;
+		int64 NumPayloadBits = 0;
+	};
+
+	template<typename StructType>
+	static int32 MeasureBits(StructType Struct)
+	{
+		FNetBitWriter Writer(nullptr, 1024);
+		bool bSuccess = true;
+		Struct.NetSerialize(Writer, nullptr, bSuccess);
+		return static_cast<int32>(Writer.GetNumBits());
+	}
+
+	/** Run the script at Rate frames per second through the same combining rules as ReplicateMoveToServer. */
+	static FSessionResult SimulateSession(float Rate, float MaxCombinedDeltaTime)
+	{
+		const float DeltaTime = 1.0f / Rate;
+		FSessionResult Result;
+
+		FFPSavedMove PendingMove;
+		PendingMove.bSent = true;
+		uint32 MoveId = 0;
+		FRotator ControlRotation = FRotator::ZeroRotator;
+		FVector Location(1000.0f, 1000.0f, 200.0f);
+		FVector Velocity = FVector::ZeroVector;
+
+		auto SendPendingMove = [&Result, &PendingMove]()
+		{
+			if (!PendingMove.bSent)
+			{
+				PendingMove.bSent = true;
+				++Result.NumMovesSent;
+				Result.NumPayloadBits += MeasureBits(PendingMove.ToNetMove());
+			}
+		};
+
+		for (const FInputSegment& Segment : Script)
+		{
+			const int32 NumFrames = FMath::RoundToInt(Segment.Duration * Rate);
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				ControlRotation.Yaw = FRotator::ClampAxis(ControlRotation.Yaw + Segment.YawRate * DeltaTime);
+				const FVector PreviousVelocity = Velocity;
+				Velocity = ControlRotation.RotateVector(Segment.InputVector) * 600.0f;
+				Location += Velocity * DeltaTime;
+
+				FFPSavedMove Move;
+				Move.MoveId = ++MoveId;
+				Move.DeltaTime = DeltaTime;
+				Move.InputVector = FFPNetMove::QuantizeInputVector(Segment.InputVector);
+				Move.ControlRotation = FFPNetMove::QuantizeControlRotation(ControlRotation);
+				Move.Flags = Segment.Flags | (Segment.bJumpAtStart && Frame == 0 ? FPMoveFlag_Jump : FPMoveFlag_None);
+				Move.EndLocation = Location;
+				Move.EndVelocity = Velocity;
+				// A jump segment counts as airborne throughout, so none of it is combined.
+				Move.bLinearInDeltaTime = !Segment.bJumpAtStart && Velocity.Equals(PreviousVelocity, FFPSavedMove::CombineVelocityTolerance);
+
+				if (PendingMove.CanCombineWith(Move, MaxCombinedDeltaTime))
+				{
+					PendingMove.CombineWith(Move);
+				}
+				else
+				{
+					SendPendingMove();
+					PendingMove = Move;
+				}
+
+				if (!PendingMove.ShouldWaitForCombine(DeltaTime, MaxCombinedDeltaTime))
+				{
+					SendPendingMove();
+				}
+			}
+		}
+
+		SendPendingMove();
+		return Result;
+	}
+
+	static void Run()
+	{
+		float SessionDuration = 0.0f;
+		for (const FInputSegment& Segment : Script)
+		{
+			SessionDuration += Segment.Duration;
+		}
+
+		const float MaxCombinedDeltaTime = FFPSavedMove::GetMaxCombinedDeltaTime();
+		UE_LOG(LogFPMovement, Display, TEXT("Movement bandwidth per client over a %.1fs scripted session, moves combined up to %.1f ms, %d bits of RPC overhead per move:"),
+			SessionDuration, MaxCombinedDeltaTime * 1000.0f, RpcOverheadBits);
+
+		static const float Rates[] = { 30.0f, 60.0f, 120.0f };
+		for (const float Rate : Rates)
+		{
+			const FSessionResult Uncombined = SimulateSession(Rate, 0.0f);
+			const FSessionResult Combined = SimulateSession(Rate, MaxCombinedDeltaTime);
+
+			auto UpBytesPerSecond = [SessionDuration](const FSessionResult& Session)
+			{
+				return (Session.NumPayloadBits + Session.NumMovesSent * RpcOverheadBits) / 8.0 / SessionDuration;
+			};
+
+			// Every move the server agrees with is acknowledged.
+			auto DownBytesPerSecond = [SessionDuration](const FSessionResult& Session)
+			{
+				return Session.NumMovesSent * (AckPayloadBits + RpcOverheadBits) / 8.0 / SessionDuration;
+			};
+
+			UE_LOG(LogFPMovement, Display, TEXT("  %3.0f Hz: %.1f bits/move. Uncombined %.1f moves/s, %.0f B/s up, %.0f B/s down. Combined %.1f moves/s, %.0f B/s up, %.0f B/s down."),
+				Rate, Combined.NumMovesSent > 0 ? static_cast<double>(Combined.NumPayloadBits) / Combined.NumMovesSent : 0.0,
+				Uncombined.NumMovesSent / SessionDuration, UpBytesPerSecond(Uncombined), DownBytesPerSecond(Uncombined),
+				Combined.NumMovesSent / SessionDuration, UpBytesPerSecond(Combined), DownBytesPerSecond(Combined));
+		}
+
+		FFPCompactMovementState State;
+		State.Set(EFPMovementMode::Sliding, 0.5f);
+		FFPMoveAdjustment Adjustment;
+		Adjustment.Location = FVector(1000.0f, 1000.0f, 200.0f);
+		Adjustment.Velocity = FVector(600.0f, 0.0f, 0.0f);
+		UE_LOG(LogFPMovement, Display, TEXT("  Mode and crouch state to simulated proxies: %d bits per change. Correction: %d bits."),
+			MeasureBits(State), MeasureBits(Adjustment));
+	}
+
+	static FAutoConsoleCommand BandwidthReportCommand(
+		TEXT("FPMovement.Net.BandwidthReport"),
+		TEXT("Logs the movement bytes per second per client at 30, 60 and 120 Hz, with and without combined moves."),
+		FConsoleCommandDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
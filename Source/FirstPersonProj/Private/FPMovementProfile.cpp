@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementProfile.h"
+
+namespace FPMovementProfile
+{
+	bool bEnabled = false;
+
+	FCounters Counters;
+
+	/** Phase whose scope is innermost, and when it last started or resumed. */
+	static int32 CurrentPhase = INDEX_NONE;
+
+	static uint64 CurrentPhaseStartCycles = 0;
+
+	void Reset()
+	{
+		Counters = FCounters();
+		CurrentPhase = INDEX_NONE;
+	}
+
+	const TCHAR* GetPhaseName(EPhase Phase)
+	{
+		switch (Phase)
+		{
+			case EPhase::Walk: return TEXT("PerformWalkMovement");
+			case EPhase::Slide: return TEXT("PerformSlideMovement");
+			case EPhase::Fall: return TEXT("PerformFallMovement");
+			case EPhase::NavWalk: return TEXT("PerformNavWalkMovement");
+			case EPhase::StepUp: return TEXT("StepUp");
+			default: return TEXT("Unknown");
+		}
+	}
+
+	FPhaseScope::FPhaseScope(EPhase Phase)
+	{
+		if (!bEnabled)
+		{
+			return;
+		}
+
+		// Pause the enclosing phase while this one runs.
+		const uint64 Now = FPlatformTime::Cycles64();
+		if (CurrentPhase != INDEX_NONE)
+		{
+			Counters.PhaseCycles[CurrentPhase] += Now - CurrentPhaseStartCycles;
+		}
+
+		bActive = true;
+		PreviousPhase = CurrentPhase;
+		CurrentPhase = static_cast<int32>(Phase);
+		CurrentPhaseStartCycles = Now;
+		++Counters.PhaseCalls[CurrentPhase];
+	}
+
+	FPhaseScope::~FPhaseScope()
+	{
+		if (!bActive)
+		{
+			return;
+		}
+
+		const uint64 Now = FPlatformTime::Cycles64();
+		Counters.PhaseCycles[CurrentPhase] += Now - CurrentPhaseStartCycles;
+		CurrentPhase = PreviousPhase;
+		CurrentPhaseStartCycles = Now;
+	}
+
+	FModeScope::FModeScope(EFPMovementMode InMode)
+		: Mode(InMode)
+	{
+		if (bEnabled && Mode < FFPMovementModeRegistry::MaxModes)
+		{
+			bActive = true;
+			StartCycles = FPlatformTime::Cycles64();
+			StartSweeps = Counters.Sweeps;
+			StartMoves = Counters.Moves;
+		}
+	}
+
+	FModeScope::~FModeScope()
+	{
+		if (bActive)
+		{
+			Counters.ModeCycles[Mode] += FPlatformTime::Cycles64() - StartCycles;
+			++Counters.ModeTicks[Mode];
+			Counters.ModeSweeps[Mode] += Counters.Sweeps - StartSweeps;
+			Counters.ModeMoves[Mode] += Counters.Moves - StartMoves;
+		}
+	}
+
+	FModeSwitchScope::FModeSwitchScope()
+	{
+		if (bEnabled)
+		{
+			bActive = true;
+			StartCycles = FPlatformTime::Cycles64();
+		}
+	}
+
+	FModeSwitchScope::~FModeSwitchScope()
+	{
+		if (bActive)
+		{
+			Counters.ModeSwitchCycles += FPlatformTime::Cycles64() - StartCycles;
+			++Counters.ModeSwitches;
+		}
+	}
+}
@@ -0,0 +1,635 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementSubsystem.h"
+#include "FPMovementComponent.h"
+#include "FPMovementStats.h"
+#include "FPMovementAsyncCallback.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/GameModeBase.h"
+#include "Kismet/GameplayStatics.h"
+#include "PBDRigidsSolver.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "SignificanceManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Batch Tick"), STAT_FPMovementBatchTick, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Batch Prepare"), STAT_FPMovementBatchPrepare, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Batch Velocity"), STAT_FPMovementBatchVelocity, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Batch Commit"), STAT_FPMovementBatchCommit, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Pawns"), STAT_FPMovementBatchPawns, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Async Physics Produce"), STAT_FPMovementAsyncProduce, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Async Physics Consume"), STAT_FPMovementAsyncConsume, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Physics Pawns"), STAT_FPMovementAsyncPawns, STATGROUP_FPMovement);
+DECLARE_CYCLE_STAT(TEXT("Significance Update"), STAT_FPMovementSignificance, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Full Pawns"), STAT_FPMovementLODFullPawns, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Reduced Pawns"), STAT_FPMovementLODReducedPawns, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LOD Minimal Pawns"), STAT_FPMovementLODMinimalPawns, STATGROUP_FPMovement);
+
+static TAutoConsoleVariable<int32> CVarFPMovementBatched(
+	TEXT("FPMovement.Batched"),
+	0,
+	TEXT("If non-zero, all UFPMovementComponents are ticked in one batched pass by UFPMovementSubsystem in TG_PrePhysics instead of their own tick functions."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementBatchUseSIMD(
+	TEXT("FPMovement.Batch.UseSIMD"),
+	0,
+	TEXT("If non-zero, the batched velocity phase uses the SIMD structure-of-arrays kernels. Otherwise it falls back to the scalar kernels.\n")
+	TEXT("Off by default: the SIMD kernels are only within FPMovementCore::BatchKernelTolerance of the scalar kernels that replay and the server run, so networked pawns would be corrected."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementBatchMinParallel(
+	TEXT("FPMovement.Batch.MinParallel"),
+	16,
+	TEXT("Minimum number of pawns before the batched velocity phase is spread across worker threads."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementLOD(
+	TEXT("FPMovement.LOD"),
+	1,
+	TEXT("If non-zero, pawns are simulated at reduced rates based on their significance to the nearest viewer."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLODReducedDistance(
+	TEXT("FPMovement.LOD.ReducedDistance"),
+	3000.0f,
+	TEXT("Distance in cm to the nearest viewer beyond which a pawn's movement is simulated at the reduced rate."));
+
+static TAutoConsoleVariable<float> CVarFPMovementLODMinimalDistance(
+	TEXT("FPMovement.LOD.MinimalDistance"),
+	8000.0f,
+	TEXT("Distance in cm to the nearest viewer beyond which a pawn's movement is simulated at the minimal rate."));
+
+static TAutoConsoleVariable<int32> CVarFPMovementAsyncPhysics(
+	TEXT("FPMovement.AsyncPhysics"),
+	0,
+	TEXT("If non-zero, the velocity kernels run on the physics thread every physics step, chained from each pawn's state at the end of the frame with its last input.\n")
+	TEXT("The next frame uses a step's result only for a kernel run with exactly its delta time, input and starting state, e.g. fixed substeps as long as the physics step.\n")
+	TEXT("Sweeps and movement mode changes stay on the game thread. Enable 'Tick Physics Async' in the physics settings for a fixed rate."));
+
+static const FName FPMovementSignificanceTag(TEXT("FPMovement"));
+
+void FFPMovementBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem && TickType != LEVELTICK_ViewportsOnly)
+	{
+		Subsystem->TickBatched(DeltaTime);
+	}
+}
+
+FString FFPMovementBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FFPMovementBatchTickFunction");
+}
+
+TStatId UFPMovementSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFPMovementSubsystem, STATGROUP_Tickables);
+}
+
+bool UFPMovementSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UFPMovementSubsystem::IsBatchingEnabled()
+{
+	return CVarFPMovementBatched.GetValueOnGameThread() != 0;
+}
+
+void UFPMovementSubsystem::RegisterComponent(UFPMovementComponent* Component)
+{
+	if (Component && !MovementComponents.Contains(Component))
+	{
+		MovementComponents.Add(Component);
+		if (bBatchingApplied)
+		{
+			DisableComponentTick(Component);
+		}
+
+		if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+		{
+			SignificanceManager->RegisterObject(Component, FPMovementSignificanceTag, &UFPMovementSubsystem::CalculateSignificance,
+				USignificanceManager::EPostSignificanceType::Sequential, &UFPMovementSubsystem::PostSignificanceUpdate);
+		}
+	}
+}
+
+void UFPMovementSubsystem::UnregisterComponent(UFPMovementComponent* Component)
+{
+	// Keep the remaining components in registration order.
+	MovementComponents.Remove(Component);
+	BatchDisabledTickComponents.Remove(Component);
+
+	if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+	{
+		SignificanceManager->UnregisterObject(Component);
+	}
+}
+
+float UFPMovementSubsystem::CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint)
+{
+	// The manager keeps the highest significance over all viewpoints, so the nearest viewer wins.
+	const UFPMovementComponent* Component = CastChecked<UFPMovementComponent>(ObjectInfo->GetObject());
+	return Component->UpdatedComponent ? -FVector::Dist(Component->UpdatedComponent->GetComponentLocation(), Viewpoint.GetLocation()) : 0.0f;
+}
+
+void UFPMovementSubsystem::PostSignificanceUpdate(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+{
+	UFPMovementComponent* Component = CastChecked<UFPMovementComponent>(ObjectInfo->GetObject());
+	const APawn* Pawn = Component->GetPawnOwner();
+	// Player pawns stay at full rate. Their moves are predicted and replayed with exact delta times.
+	if (!Pawn || Pawn->IsPlayerControlled())
+	{
+		Component->SetMovementLOD(EFPMovementLOD::Full);
+		return;
+	}
+
+	const float Distance = -Significance;
+	EFPMovementLOD NewLOD = Distance > CVarFPMovementLODMinimalDistance.GetValueOnGameThread() ? EFPMovementLOD::Minimal
+		: Distance > CVarFPMovementLODReducedDistance.GetValueOnGameThread() ? EFPMovementLOD::Reduced
+		: EFPMovementLOD::Full;
+
+	// Pawns nobody has seen lately drop one more LOD. A dedicated server renders nothing, so only distance counts there.
+	if (NewLOD != EFPMovementLOD::Minimal && Pawn->GetNetMode() != NM_DedicatedServer && !Pawn->WasRecentlyRendered(0.25f))
+	{
+		NewLOD = static_cast<EFPMovementLOD>(static_cast<uint8>(NewLOD) + 1);
+	}
+
+	Component->SetMovementLOD(NewLOD);
+}
+
+void UFPMovementSubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementSignificance);
+
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (!SignificanceManager || !CVarFPMovementLOD.GetValueOnGameThread())
+	{
+		for (UFPMovementComponent* Component : MovementComponents)
+		{
+			if (IsValid(Component))
+			{
+				Component->SetMovementLOD(EFPMovementLOD::Full);
+			}
+		}
+	}
+	else
+	{
+		// Every player's view counts, so a server keeps pawns near any client at full rate.
+		TArray<FTransform, TInlineAllocator<8>> Viewpoints;
+		for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+		{
+			if (const APlayerController* PlayerController = Iterator->Get())
+			{
+				FVector ViewLocation;
+				FRotator ViewRotation;
+				PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+				Viewpoints.Emplace(ViewRotation, ViewLocation);
+			}
+		}
+
+		SignificanceManager->Update(Viewpoints);
+	}
+
+	int32 NumPawnsPerLOD[static_cast<int32>(EFPMovementLOD::Num)] = {};
+	for (const UFPMovementComponent* Component : MovementComponents)
+	{
+		if (IsValid(Component))
+		{
+			++NumPawnsPerLOD[static_cast<int32>(Component->GetMovementLOD())];
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FPMovementLODFullPawns, NumPawnsPerLOD[static_cast<int32>(EFPMovementLOD::Full)]);
+	SET_DWORD_STAT(STAT_FPMovementLODReducedPawns, NumPawnsPerLOD[static_cast<int32>(EFPMovementLOD::Reduced)]);
+	SET_DWORD_STAT(STAT_FPMovementLODMinimalPawns, NumPawnsPerLOD[static_cast<int32>(EFPMovementLOD::Minimal)]);
+}
+
+void UFPMovementSubsystem::DisableComponentTick(UFPMovementComponent* Component)
+{
+	if (Component->IsComponentTickEnabled())
+	{
+		Component->SetComponentTickEnabled(false);
+		BatchDisabledTickComponents.Add(Component);
+	}
+}
+
+void UFPMovementSubsystem::ApplyBatchingMode(bool bBatched)
+{
+	if (bBatched)
+	{
+		for (UFPMovementComponent* Component : MovementComponents)
+		{
+			if (IsValid(Component))
+			{
+				DisableComponentTick(Component);
+			}
+		}
+	}
+	else
+	{
+		for (UFPMovementComponent* Component : BatchDisabledTickComponents)
+		{
+			if (IsValid(Component))
+			{
+				Component->SetComponentTickEnabled(true);
+			}
+		}
+		BatchDisabledTickComponents.Reset();
+	}
+
+	BatchTickFunction.SetTickFunctionEnable(bBatched);
+	bBatchingApplied = bBatched;
+}
+
+void UFPMovementSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Only enabled while batching is applied. ApplyBatchingMode keeps it in sync from here on.
+	BatchTickFunction.Subsystem = this;
+	BatchTickFunction.bCanEverTick = true;
+	BatchTickFunction.TickGroup = TG_PrePhysics;
+	BatchTickFunction.SetTickFunctionEnable(bBatchingApplied);
+	BatchTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void UFPMovementSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateSignificance();
+	UpdateAsyncPhysicsCallback();
+	ConsumeAsyncPhysicsOutputs();
+
+	// Switched here, after all tick groups, so a pawn is never moved by both its own tick function and the batch in the same frame.
+	const bool bBatched = IsBatchingEnabled();
+	if (bBatched != bBatchingApplied)
+	{
+		ApplyBatchingMode(bBatched);
+	}
+
+	ProduceAsyncPhysicsInputs();
+}
+
+void UFPMovementSubsystem::Deinitialize()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.UnRegisterTickFunction();
+	}
+
+	if (AsyncCallback)
+	{
+		if (FPhysScene* PhysScene = GetWorld()->GetPhysicsScene())
+		{
+			PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(AsyncCallback);
+		}
+		AsyncCallback = nullptr;
+	}
+
+	Super::Deinitialize();
+}
+
+void UFPMovementSubsystem::UpdateAsyncPhysicsCallback()
+{
+	const bool bWantsAsyncPhysics = CVarFPMovementAsyncPhysics.GetValueOnGameThread() != 0;
+	if (bWantsAsyncPhysics == (AsyncCallback != nullptr))
+	{
+		return;
+	}
+
+	FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+	if (!PhysScene)
+	{
+		return;
+	}
+
+	Chaos::FPBDRigidsSolver* Solver = PhysScene->GetSolver();
+	if (bWantsAsyncPhysics)
+	{
+		AsyncCallback = Solver->CreateAndRegisterSimCallbackObject_External<FFPMovementAsyncCallback>();
+	}
+	else
+	{
+		Solver->UnregisterAndFreeSimCallbackObject_External(AsyncCallback);
+		AsyncCallback = nullptr;
+	}
+}
+
+void UFPMovementSubsystem::ConsumeAsyncPhysicsOutputs()
+{
+	if (!AsyncCallback)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementAsyncConsume);
+
+	// Outputs come in step order. Every step is handed over, since consecutive steps can stand in for consecutive fixed substeps.
+	while (Chaos::TSimCallbackOutputHandle<FFPMovementAsyncOutput> Output = AsyncCallback->PopOutputData_External())
+	{
+		for (const FFPMovementAsyncOutput::FPawnOutput& PawnOutput : Output->Pawns)
+		{
+			if (UFPMovementComponent* Component = PawnOutput.Component.Get())
+			{
+				Component->AddAsyncKernelResult(PawnOutput.Job);
+			}
+		}
+	}
+}
+
+void UFPMovementSubsystem::ProduceAsyncPhysicsInputs()
+{
+	if (!AsyncCallback)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementAsyncProduce);
+
+	FFPMovementAsyncInput* Input = AsyncCallback->GetProducerInputData_External();
+	Input->Reset();
+	Input->Frame = GFrameCounter;
+	for (UFPMovementComponent* Component : MovementComponents)
+	{
+		if (!IsValid(Component) || !Component->UpdatedComponent || !Component->IsActive())
+		{
+			continue;
+		}
+
+		// The physics thread fills in its own delta time.
+		FFPMovementAsyncInput::FPawnInput PawnInput;
+		if (Component->BuildKernelJob(Component->GetLastInputVector(), 0.0f, PawnInput.Job))
+		{
+			PawnInput.Component = Component;
+			PawnInput.Tunables = Component->GetMovementTunables();
+			Input->Pawns.Add(MoveTemp(PawnInput));
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FPMovementAsyncPawns, Input->Pawns.Num());
+}
+
+void UFPMovementSubsystem::TickBatched(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPMovementBatchTick);
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Work on a copy so components that register or unregister during the commit don't invalidate the iteration.
+	const TArray<TObjectPtr<UFPMovementComponent>> Components = MovementComponents;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FPMovementBatchPrepare);
+
+		BatchEntries.Reset(Components.Num());
+		for (UFPMovementComponent* Component : Components)
+		{
+			if (!IsValid(Component) || !Component->UpdatedComponent || !Component->IsActive())
+			{
+				continue;
+			}
+
+			FBatchEntry& Entry = BatchEntries.AddDefaulted_GetRef();
+			Entry.Component = Component;
+			Entry.InputVector = Component->ConsumeInputVector();
+			Entry.Tunables = Component->GetMovementTunables();
+			// Fixed timestep and reduced LOD components run their kernels with a different delta, so there is nothing to precompute for them.
+			Entry.bHasJob = !Component->UsesFixedTimestep() && Component->GetMovementLOD() == EFPMovementLOD::Full && Component->BuildKernelJob(Entry.InputVector, DeltaTime, Entry.Job);
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FPMovementBatchVelocity);
+
+		if (CVarFPMovementBatchUseSIMD.GetValueOnGameThread() != 0)
+		{
+			RunVelocityPhaseSIMD();
+		}
+		else
+		{
+			RunVelocityPhaseScalar();
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_FPMovementBatchCommit);
+
+		// Sweeps and mode transitions touch the world, so they stay on the game thread in registration order.
+		for (FBatchEntry& Entry : BatchEntries)
+		{
+			if (!IsValid(Entry.Component))
+			{
+				continue;
+			}
+
+			// The component reads the job straight out of BatchEntries, which stays put until the commit loop is done.
+			Entry.Component->SetPrecomputedKernelJob(Entry.bHasJob ? &Entry.Job : nullptr);
+			Entry.Component->TickMovement(DeltaTime, Entry.InputVector);
+			Entry.Component->SetPrecomputedKernelJob(nullptr);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FPMovementBatchPawns, BatchEntries.Num());
+
+	const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	AverageBatchTimeMs = AverageBatchTimeMs > 0.0 ? FMath::Lerp(AverageBatchTimeMs, ElapsedMs, 0.1) : ElapsedMs;
+}
+
+void UFPMovementSubsystem::RunVelocityPhaseScalar()
+{
+	// The kernels only touch the entry they are given, so every pawn can be integrated independently.
+	const EParallelForFlags ParallelForFlags = BatchEntries.Num() < CVarFPMovementBatchMinParallel.GetValueOnGameThread() ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+	ParallelFor(BatchEntries.Num(), [this](int32 Index)
+	{
+		FBatchEntry& Entry = BatchEntries[Index];
+		if (Entry.bHasJob)
+		{
+			FPMovementCore::RunKernel(Entry.Job, Entry.Tunables);
+		}
+	}, ParallelForFlags);
+}
+
+void UFPMovementSubsystem::RunVelocityPhaseSIMD()
+{
+	// Lanes per parallel task. A multiple of the SIMD lane width.
+	constexpr int32 LanesPerTask = 64;
+
+	int32 NumJobsPerKernel[UE_ARRAY_COUNT(KernelBatches)] = {};
+	for (FBatchEntry& Entry : BatchEntries)
+	{
+		if (Entry.bHasJob)
+		{
+			Entry.KernelBatchLane = NumJobsPerKernel[static_cast<int32>(Entry.Job.Kernel)]++;
+		}
+	}
+
+	for (int32 KernelIndex = 0; KernelIndex < UE_ARRAY_COUNT(KernelBatches); ++KernelIndex)
+	{
+		KernelBatches[KernelIndex].Reset(static_cast<EFPMovementKernel>(KernelIndex), NumJobsPerKernel[KernelIndex]);
+	}
+
+	for (const FBatchEntry& Entry : BatchEntries)
+	{
+		if (Entry.bHasJob)
+		{
+			KernelBatches[static_cast<int32>(Entry.Job.Kernel)].Gather(Entry.KernelBatchLane, Entry.Job, Entry.Tunables);
+		}
+	}
+
+	int32 NumTasks = 0;
+	for (FFPMovementKernelBatch& KernelBatch : KernelBatches)
+	{
+		KernelBatch.FinalizeGather();
+		NumTasks += FMath::DivideAndRoundUp(KernelBatch.NumPadded(), LanesPerTask);
+	}
+
+	const EParallelForFlags ParallelForFlags = BatchEntries.Num() < CVarFPMovementBatchMinParallel.GetValueOnGameThread() ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None;
+	ParallelFor(NumTasks, [this](int32 TaskIndex)
+	{
+		for (FFPMovementKernelBatch& KernelBatch : KernelBatches)
+		{
+			const int32 NumKernelTasks = FMath::DivideAndRoundUp(KernelBatch.NumPadded(), LanesPerTask);
+			if (TaskIndex < NumKernelTasks)
+			{
+				FPMovementCore::RunKernelBatch(KernelBatch, TaskIndex * LanesPerTask, (TaskIndex + 1) * LanesPerTask);
+				return;
+			}
+			TaskIndex -= NumKernelTasks;
+		}
+	}, ParallelForFlags);
+
+	for (FBatchEntry& Entry : BatchEntries)
+	{
+		if (Entry.bHasJob)
+		{
+			KernelBatches[static_cast<int32>(Entry.Job.Kernel)].Scatter(Entry.KernelBatchLane, Entry.Job);
+		}
+	}
+}
+
+void UFPMovementSubsystem::TickSerial(float DeltaTime)
+{
+	const TArray<TObjectPtr<UFPMovementComponent>> Components = MovementComponents;
+	for (UFPMovementComponent* Component : Components)
+	{
+		if (IsValid(Component) && Component->UpdatedComponent && Component->IsActive())
+		{
+			Component->TickMovement(DeltaTime, Component->ConsumeInputVector());
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPMovementBatchBenchmark
+{
+	static void Report(const TArray<FString>& Args, UWorld* World)
+	{
+		const UFPMovementSubsystem* Subsystem = World ? World->GetSubsystem<UFPMovementSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			return;
+		}
+
+		UE_LOG(LogFPMovement, Display, TEXT("FPMovement batch: %s, %d registered pawns, %.3f ms/frame"),
+			UFPMovementSubsystem::IsBatchingEnabled() ? TEXT("enabled") : TEXT("disabled"), Subsystem->GetNumRegisteredComponents(), Subsystem->GetAverageBatchTimeMs());
+	}
+
+	static double TimeFrames(UFPMovementSubsystem* Subsystem, const TArray<APawn*>& Pawns, int32 NumFrames, bool bBatched)
+	{
+		constexpr float DeltaTime = 1.0f / 60.0f;
+		FRandomStream RandomStream(0x4650);
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (APawn* Pawn : Pawns)
+			{
+				Pawn->AddMovementInput(FVector(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f), 0.0f));
+			}
+
+			if (bBatched)
+			{
+				Subsystem->TickBatched(DeltaTime);
+			}
+			else
+			{
+				Subsystem->TickSerial(DeltaTime);
+			}
+		}
+
+		return ((FPlatformTime::Seconds() - StartTime) * 1000.0) / NumFrames;
+	}
+
+	/** Spawns increasing numbers of pawns next to the player and compares the serial and batched paths. */
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		UFPMovementSubsystem* Subsystem = World ? World->GetSubsystem<UFPMovementSubsystem>() : nullptr;
+		if (!Subsystem)
+		{
+			UE_LOG(LogFPMovement, Warning, TEXT("FPMovement.Batch.Benchmark needs a game world."));
+			return;
+		}
+
+		TArray<int32> PawnCounts;
+		for (const FString& Arg : Args)
+		{
+			PawnCounts.Add(FMath::Max(1, FCString::Atoi(*Arg)));
+		}
+		if (PawnCounts.IsEmpty())
+		{
+			PawnCounts = { 1, 8, 16, 32, 64, 128 };
+		}
+
+		TSubclassOf<APawn> PawnClass = AFirstPersonProjCharacter::StaticClass();
+		const AGameModeBase* GameMode = World->GetAuthGameMode();
+		if (GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(AFirstPersonProjCharacter::StaticClass()))
+		{
+			PawnClass = GameMode->DefaultPawnClass;
+		}
+
+		const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(World, 0);
+		const FVector Origin = PlayerPawn ? PlayerPawn->GetActorLocation() : FVector::ZeroVector;
+		const int32 NumExistingPawns = Subsystem->GetNumRegisteredComponents();
+		constexpr int32 NumFrames = 120;
+		constexpr float Spacing = 150.0f;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		UE_LOG(LogFPMovement, Display, TEXT("FPMovement.Batch.Benchmark: %d frames per run, %d pawns already registered"), NumFrames, NumExistingPawns);
+		for (const int32 PawnCount : PawnCounts)
+		{
+			TArray<APawn*> Pawns;
+			const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(PawnCount)));
+			for (int32 Index = 0; Index < PawnCount; ++Index)
+			{
+				const FVector Location = Origin + FVector((Index % GridSize) * Spacing, (Index / GridSize) * Spacing, 0.0f);
+				if (APawn* Pawn = World->SpawnActor<APawn>(PawnClass, Location, FRotator::ZeroRotator, SpawnParams))
+				{
+					Pawns.Add(Pawn);
+				}
+			}
+
+			const double SerialMs = TimeFrames(Subsystem, Pawns, NumFrames, false);
+			const double BatchedMs = TimeFrames(Subsystem, Pawns, NumFrames, true);
+			UE_LOG(LogFPMovement, Display, TEXT("  %4d pawns: serial %.3f ms/frame, batched %.3f ms/frame"), Pawns.Num(), SerialMs, BatchedMs);
+
+			for (APawn* Pawn : Pawns)
+			{
+				Pawn->Destroy();
+			}
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ReportCommand(
+		TEXT("FPMovement.Batch.Report"),
+		TEXT("Logs the number of registered pawns and the average batched movement cost per frame."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Report));
+
+	static FAutoConsoleCommandWithWorldAndArgs BenchmarkCommand(
+		TEXT("FPMovement.Batch.Benchmark"),
+		TEXT("Spawns pawns next to the player and logs serial vs batched movement ms/frame. Usage: FPMovement.Batch.Benchmark [PawnCount ...]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementTelemetry.h"
+#include "FPMovementComponent.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<bool> CVarFPMovementTelemetry(
+	TEXT("FPMovement.Telemetry"),
+	false,
+	TEXT("Record every movement update of every movement component into a ring buffer that can be dumped with FPMovement.Telemetry.Dump."));
+
+static TAutoConsoleVariable<float> CVarFPMovementTelemetryHitchMs(
+	TEXT("FPMovement.Telemetry.HitchMs"),
+	0.0f,
+	TEXT("While telemetry is on, dump it automatically after a frame longer than this many milliseconds. 0 to disable."));
+
+static TAutoConsoleVariable<float> CVarFPMovementTelemetryHitchCooldown(
+	TEXT("FPMovement.Telemetry.HitchCooldown"),
+	30.0f,
+	TEXT("Minimum seconds between automatic hitch dumps."));
+
+namespace FPMovementTelemetryFile
+{
+	static constexpr uint32 Magic = 0x544D5046; // "FPMT"
+	static constexpr uint32 Version = 1;
+}
+
+FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryRecord& Record)
+{
+	Ar << Record.Time;
+	Ar << Record.Velocity;
+	Ar << Record.FloorNormal;
+	Ar << Record.Delta;
+	Ar << Record.DeltaTime;
+	Ar << Record.Mode;
+
+	uint8 Flags = static_cast<uint8>(Record.Flags);
+	Ar << Flags;
+	Record.Flags = static_cast<EFPMovementTelemetryFlags>(Flags);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryStream& Stream)
+{
+	Ar << Stream.Name;
+	Ar << Stream.Records;
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryDump& Dump)
+{
+	uint32 Magic = FPMovementTelemetryFile::Magic;
+	uint32 Version = FPMovementTelemetryFile::Version;
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != FPMovementTelemetryFile::Magic || Version != FPMovementTelemetryFile::Version)
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Dump.Reason;
+	Ar << Dump.MapName;
+	Ar << Dump.Streams;
+	return Ar;
+}
+
+void FFPMovementTelemetryRing::Push(const FFPMovementTelemetryRecord& Record)
+{
+	const uint64 Index = NumPushed.load(std::memory_order_relaxed);
+	Records[Index & (Capacity - 1)] = Record;
+	NumPushed.store(Index + 1, std::memory_order_release);
+}
+
+void FFPMovementTelemetryRing::Snapshot(TArray<FFPMovementTelemetryRecord>& OutRecords) const
+{
+	const uint64 End = NumPushed.load(std::memory_order_acquire);
+	const uint64 Begin = End > Capacity ? End - Capacity : 0;
+
+	OutRecords.Reset(static_cast<int32>(End - Begin));
+	for (uint64 Index = Begin; Index < End; ++Index)
+	{
+		OutRecords.Add(Records[Index & (Capacity - 1)]);
+	}
+
+	// The writer may have started on record NumPushed, overwriting record NumPushed - Capacity, while we were copying.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 FirstIntact = NumPushed.load(std::memory_order_relaxed) + 1;
+	if (FirstIntact > Begin + Capacity)
+	{
+		const uint64 NumTorn = FMath::Min(FirstIntact - Capacity - Begin, End - Begin);
+		OutRecords.RemoveAt(0, static_cast<int32>(NumTorn));
+	}
+}
+
+bool FFPMovementTelemetryDump::SaveToFile(const FString& Path) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Writer << const_cast<FFPMovementTelemetryDump&>(*this);
+	return !Writer.IsError() && FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool FFPMovementTelemetryDump::LoadFromFile(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	Reader << *this;
+	return !Reader.IsError();
+}
+
+FString FFPMovementTelemetryDump::GetDumpDir()
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MovementTelemetry"));
+}
+
+namespace FPMovementTelemetry
+{
+	bool IsEnabled()
+	{
+		return CVarFPMovementTelemetry.GetValueOnGameThread();
+	}
+
+	FString DumpWorld(UWorld* World, const FString& Reason)
+	{
+		if (!World)
+		{
+			return FString();
+		}
+
+		FFPMovementTelemetryDump Dump;
+		Dump.Reason = Reason;
+		Dump.MapName = UWorld::RemovePIEPrefix(World->GetMapName());
+
+		for (const UFPMovementComponent* Component : TObjectRange<UFPMovementComponent>())
+		{
+			const FFPMovementTelemetryRing* Ring = Component->GetTelemetry();
+			if (Ring && Component->GetWorld() == World)
+			{
+				FFPMovementTelemetryStream& Stream = Dump.Streams.AddDefaulted_GetRef();
+				Stream.Name = GetNameSafe(Component->GetOwner());
+				Ring->Snapshot(Stream.Records);
+			}
+		}
+
+		if (Dump.Streams.IsEmpty())
+		{
+			UE_LOG(LogFPMovement, Warning, TEXT("No movement telemetry to dump. Is FPMovement.Telemetry on?"));
+			return FString();
+		}
+
+		const FString Path = FPaths::Combine(FFPMovementTelemetryDump::GetDumpDir(),
+			FString::Printf(TEXT("%s-%s.fpmt"), *Reason, *FDateTime::Now().ToString()));
+		if (!Dump.SaveToFile(Path))
+		{
+			UE_LOG(LogFPMovement, Error, TEXT("Couldn't write movement telemetry to %s"), *Path);
+			return FString();
+		}
+
+		UE_LOG(LogFPMovement, Display, TEXT("Dumped movement telemetry of %d components to %s"), Dump.Streams.Num(), *Path);
+		return Path;
+	}
+
+	void CheckForHitch(UWorld* World)
+	{
+		static uint64 LastCheckedFrame = 0;
+		static double LastHitchDumpTime = -DBL_MAX;
+
+		const float HitchMs = CVarFPMovementTelemetryHitchMs.GetValueOnGameThread();
+		if (HitchMs <= 0.0f || LastCheckedFrame == GFrameCounter)
+		{
+			return;
+		}
+		LastCheckedFrame = GFrameCounter;
+
+		const double Now = FPlatformTime::Seconds();
+		if (FApp::GetDeltaTime() * 1000.0 > HitchMs && Now - LastHitchDumpTime >= CVarFPMovementTelemetryHitchCooldown.GetValueOnGameThread())
+		{
+			LastHitchDumpTime = Now;
+			DumpWorld(World, TEXT("Hitch"));
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPMovementTelemetryCommands
+{
+	static void Dump(UWorld* World)
+	{
+		FPMovementTelemetry::DumpWorld(World, TEXT("Manual"));
+	}
+
+	static FAutoConsoleCommandWithWorld DumpCommand(
+		TEXT("FPMovement.Telemetry.Dump"),
+		TEXT("Write the movement telemetry of every movement component in the world to Saved/MovementTelemetry. Convert it with -run=FPMovementTelemetry."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&Dump));
+}
+
+#endif // !UE_BUILD_SHIPPING
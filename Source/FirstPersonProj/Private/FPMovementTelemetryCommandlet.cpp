@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementTelemetryCommandlet.h"
+#include "FPMovementComponent.h"
+#include "FPMovementTelemetry.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+
+UFPMovementTelemetryCommandlet::UFPMovementTelemetryCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFPMovementTelemetryCommandlet::Main(const FString& Params)
+{
+	FString InPath;
+	FString OutPath;
+	FParse::Value(*Params, TEXT("In="), InPath);
+	FParse::Value(*Params, TEXT("Out="), OutPath);
+
+	if (!InPath.IsEmpty())
+	{
+		return ConvertToCsv(InPath, OutPath.IsEmpty() ? FPaths::ChangeExtension(InPath, TEXT("csv")) : OutPath) ? 0 : 1;
+	}
+
+	TArray<FString> DumpFiles;
+	IFileManager::Get().FindFiles(DumpFiles, *FFPMovementTelemetryDump::GetDumpDir(), TEXT("fpmt"));
+	if (DumpFiles.IsEmpty())
+	{
+		UE_LOG(LogFPMovement, Warning, TEXT("No movement telemetry dumps in %s"), *FFPMovementTelemetryDump::GetDumpDir());
+		return 0;
+	}
+
+	int32 NumFailed = 0;
+	for (const FString& DumpFile : DumpFiles)
+	{
+		const FString DumpPath = FPaths::Combine(FFPMovementTelemetryDump::GetDumpDir(), DumpFile);
+		NumFailed += ConvertToCsv(DumpPath, FPaths::ChangeExtension(DumpPath, TEXT("csv"))) ? 0 : 1;
+	}
+	return NumFailed > 0 ? 1 : 0;
+}
+
+bool UFPMovementTelemetryCommandlet::ConvertToCsv(const FString& InPath, const FString& OutPath)
+{
+	FFPMovementTelemetryDump Dump;
+	if (!Dump.LoadFromFile(InPath))
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("Couldn't read movement telemetry dump %s"), *InPath);
+		return false;
+	}
+
+	const UEnum* ModeEnum = StaticEnum<EFPMovementMode>();
+
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Stream,Time,DeltaTime,Mode,VelocityX,VelocityY,VelocityZ,Speed2D,FloorNormalX,FloorNormalY,FloorNormalZ,DeltaX,DeltaY,DeltaZ,BlockingHit,SteppedUp,OnWalkableFloor,ModeChanged"));
+	for (const FFPMovementTelemetryStream& Stream : Dump.Streams)
+	{
+		for (const FFPMovementTelemetryRecord& Record : Stream.Records)
+		{
+			Lines.Add(FString::Printf(TEXT("%s,%.4f,%.5f,%s,%.2f,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.3f,%.3f,%.3f,%d,%d,%d,%d"),
+				*Stream.Name, Record.Time, Record.DeltaTime, *ModeEnum->GetNameStringByValue(Record.Mode),
+				Record.Velocity.X, Record.Velocity.Y, Record.Velocity.Z, Record.Velocity.Size2D(),
+				Record.FloorNormal.X, Record.FloorNormal.Y, Record.FloorNormal.Z,
+				Record.Delta.X, Record.Delta.Y, Record.Delta.Z,
+				EnumHasAnyFlags(Record.Flags, EFPMovementTelemetryFlags::BlockingHit) ? 1 : 0,
+				EnumHasAnyFlags(Record.Flags, EFPMovementTelemetryFlags::SteppedUp) ? 1 : 0,
+				EnumHasAnyFlags(Record.Flags, EFPMovementTelemetryFlags::OnWalkableFloor) ? 1 : 0,
+				EnumHasAnyFlags(Record.Flags, EFPMovementTelemetryFlags::ModeChanged) ? 1 : 0));
+		}
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *OutPath))
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("Couldn't write %s"), *OutPath);
+		return false;
+	}
+
+	UE_LOG(LogFPMovement, Display, TEXT("Wrote %d records from %d streams (%s, %s) to %s"),
+		Lines.Num() - 1, Dump.Streams.Num(), *Dump.Reason, *Dump.MapName, *OutPath);
+	return true;
+}
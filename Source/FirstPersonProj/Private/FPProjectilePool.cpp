@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPProjectilePool.h"
+#include "FirstPersonProj/FirstPersonProjProjectile.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+DEFINE_LOG_CATEGORY(LogFPProjectilePool);
+
+static TAutoConsoleVariable<bool> CVarFPProjectilePoolEnabled(
+	TEXT("FPProjectilePool.Enabled"),
+	true,
+	TEXT("Reuse fired projectiles instead of spawning a new one per shot and destroying it when it expires."));
+
+DECLARE_STATS_GROUP(TEXT("FPProjectilePool"), STATGROUP_FPProjectilePool, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Acquire"), STAT_FPProjectilePoolAcquire, STATGROUP_FPProjectilePool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Fired"), STAT_FPProjectilePoolFired, STATGROUP_FPProjectilePool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Spawned"), STAT_FPProjectilePoolSpawned, STATGROUP_FPProjectilePool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Reused"), STAT_FPProjectilePoolReused, STATGROUP_FPProjectilePool);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles Returned"), STAT_FPProjectilePoolReturned, STATGROUP_FPProjectilePool);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Pooled Projectiles"), STAT_FPProjectilePoolActive, STATGROUP_FPProjectilePool);
+
+bool UFPProjectilePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFPProjectilePoolSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreGarbageCollectHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UFPProjectilePoolSubsystem::OnPreGarbageCollect);
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UFPProjectilePoolSubsystem::OnPostGarbageCollect);
+}
+
+void UFPProjectilePoolSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGarbageCollectHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+
+	Super::Deinitialize();
+}
+
+void UFPProjectilePoolSubsystem::OnPreGarbageCollect()
+{
+	GCStartCycles = FPlatformTime::Cycles64();
+	bGCWithPoolEnabled = CVarFPProjectilePoolEnabled.GetValueOnGameThread();
+}
+
+void UFPProjectilePoolSubsystem::OnPostGarbageCollect()
+{
+	if (GCStartCycles == 0)
+	{
+		return;
+	}
+
+	++NumGCs[bGCWithPoolEnabled];
+	GCCycles[bGCWithPoolEnabled] += FPlatformTime::Cycles64() - GCStartCycles;
+	GCStartCycles = 0;
+}
+
+void UFPProjectilePoolSubsystem::Prewarm(TSubclassOf<AFirstPersonProjProjectile> Class, int32 Count)
+{
+	if (!Class || !CVarFPProjectilePoolEnabled.GetValueOnGameThread())
+	{
+		return;
+	}
+
+	TArray<TObjectPtr<AFirstPersonProjProjectile>>& FreeList = FreeLists.FindOrAdd(Class).Projectiles;
+	while (FreeList.Num() < Count)
+	{
+		AFirstPersonProjProjectile* Projectile = SpawnProjectile(Class, FVector::ZeroVector, FRotator::ZeroRotator, nullptr, nullptr, true);
+		if (!Projectile)
+		{
+			break;
+		}
+
+		Projectile->ReturnToPool();
+		FreeList.Add(Projectile);
+	}
+}
+
+AFirstPersonProjProjectile* UFPProjectilePoolSubsystem::Acquire(TSubclassOf<AFirstPersonProjProjectile> Class, const FVector& Location, const FRotator& Rotation, AActor* Owner, APawn* Instigator)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FPProjectilePoolAcquire);
+	INC_DWORD_STAT(STAT_FPProjectilePoolFired);
+	++NumFired;
+
+	const bool bPoolEnabled = CVarFPProjectilePoolEnabled.GetValueOnGameThread();
+	FFPProjectileFreeList* FreeList = bPoolEnabled ? FreeLists.Find(Class) : nullptr;
+
+	// Projectiles can be destroyed while pooled, e.g. by streaming out their level.
+	while (FreeList && !FreeList->Projectiles.IsEmpty())
+	{
+		AFirstPersonProjProjectile* Projectile = FreeList->Projectiles.Pop(false);
+		if (IsValid(Projectile))
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Projectile->SetOwner(Owner);
+			Projectile->SetInstigator(Instigator);
+			Projectile->FireFromPool(Location, Rotation);
+			ReuseCycles += FPlatformTime::Cycles64() - StartCycles;
+
+			++NumReused;
+			++NumActive;
+			INC_DWORD_STAT(STAT_FPProjectilePoolReused);
+			INC_DWORD_STAT(STAT_FPProjectilePoolActive);
+			return Projectile;
+		}
+	}
+
+	AFirstPersonProjProjectile* Projectile = SpawnProjectile(Class, Location, Rotation, Owner, Instigator, bPoolEnabled);
+	if (Projectile && bPoolEnabled)
+	{
+		++NumActive;
+		INC_DWORD_STAT(STAT_FPProjectilePoolActive);
+	}
+	return Projectile;
+}
+
+void UFPProjectilePoolSubsystem::Release(AFirstPersonProjProjectile* Projectile)
+{
+	Projectile->ReturnToPool();
+	FreeLists.FindOrAdd(Projectile->GetClass()).Projectiles.Add(Projectile);
+
+	++NumReleased;
+	NumActive = FMath::Max(NumActive - 1, 0);
+	INC_DWORD_STAT(STAT_FPProjectilePoolReturned);
+	DEC_DWORD_STAT(STAT_FPProjectilePoolActive);
+}
+
+AFirstPersonProjProjectile* UFPProjectilePoolSubsystem::SpawnProjectile(TSubclassOf<AFirstPersonProjProjectile> Class, const FVector& Location, const FRotator& Rotation, AActor* Owner, APawn* Instigator, bool bPooled)
+{
+	FActorSpawnParameters ActorSpawnParams;
+	ActorSpawnParams.Owner = Owner;
+	ActorSpawnParams.Instigator = Instigator;
+	// Pooled projectiles are prewarmed out of the way and moved to the muzzle when fired, so only unpooled ones care where they spawn.
+	ActorSpawnParams.SpawnCollisionHandlingOverride = bPooled ? ESpawnActorCollisionHandlingMethod::AlwaysSpawn : ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	AFirstPersonProjProjectile* Projectile = GetWorld()->SpawnActor<AFirstPersonProjProjectile>(Class, Location, Rotation, ActorSpawnParams);
+	SpawnCycles += FPlatformTime::Cycles64() - StartCycles;
+
+	if (Projectile)
+	{
+		++NumSpawned;
+		INC_DWORD_STAT(STAT_FPProjectilePoolSpawned);
+		if (bPooled)
+		{
+			Projectile->SetPool(this);
+		}
+		else
+		{
+			++NumSpawnedUnpooled;
+		}
+	}
+	return Projectile;
+}
+
+void UFPProjectilePoolSubsystem::LogReport() const
+{
+	int32 NumPooled = 0;
+	for (const TPair<TObjectPtr<UClass>, FFPProjectileFreeList>& Pair : FreeLists)
+	{
+		NumPooled += Pair.Value.Projectiles.Num();
+	}
+
+	UE_LOG(LogFPProjectilePool, Display, TEXT("Projectile pool%s: %d waiting, %d in flight"),
+		CVarFPProjectilePoolEnabled.GetValueOnGameThread() ? TEXT("") : TEXT(" (disabled by FPProjectilePool.Enabled)"), NumPooled, NumActive);
+	UE_LOG(LogFPProjectilePool, Display, TEXT("  %llu shots: %llu reused a pooled projectile, %llu spawned one"), NumFired, NumReused, NumFired - NumReused);
+	UE_LOG(LogFPProjectilePool, Display, TEXT("  %llu spawns (prewarm included) at %.1f us each, %llu reuses at %.1f us each"),
+		NumSpawned, NumSpawned > 0 ? FPlatformTime::ToMilliseconds64(SpawnCycles) * 1000.0 / NumSpawned : 0.0,
+		NumReused, NumReused > 0 ? FPlatformTime::ToMilliseconds64(ReuseCycles) * 1000.0 / NumReused : 0.0);
+	UE_LOG(LogFPProjectilePool, Display, TEXT("  %llu returned to the pool instead of being destroyed, %llu spawned unpooled to be destroyed"),
+		NumReleased, NumSpawnedUnpooled);
+
+	// Garbage collection is global, so this is everything it collected, not just projectiles. Compare sustained-fire runs of similar length.
+	const uint64 ShotsPerState[2] = { NumSpawnedUnpooled, NumFired - NumSpawnedUnpooled };
+	for (const bool bPoolEnabled : { true, false })
+	{
+		const double GCMilliseconds = FPlatformTime::ToMilliseconds64(GCCycles[bPoolEnabled]);
+		UE_LOG(LogFPProjectilePool, Display, TEXT("  Pool %s: %llu shots, %llu garbage collections in %.2f ms, %.2f ms each, %.2f ms per 1000 shots"),
+			bPoolEnabled ? TEXT("on") : TEXT("off"), ShotsPerState[bPoolEnabled], NumGCs[bPoolEnabled], GCMilliseconds,
+			NumGCs[bPoolEnabled] > 0 ? GCMilliseconds / NumGCs[bPoolEnabled] : 0.0,
+			ShotsPerState[bPoolEnabled] > 0 ? GCMilliseconds * 1000.0 / ShotsPerState[bPoolEnabled] : 0.0);
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPProjectilePoolCommands
+{
+	static void Report(UWorld* World)
+	{
+		if (const UFPProjectilePoolSubsystem* Subsystem = World ? World->GetSubsystem<UFPProjectilePoolSubsystem>() : nullptr)
+		{
+			Subsystem->LogReport();
+		}
+	}
+
+	static FAutoConsoleCommandWithWorld ReportCommand(
+		TEXT("FPProjectilePool.Report"),
+		TEXT("Log how many shots reused a pooled projectile, what spawning and reusing cost, and the garbage collection time measured with the pool on and off. Fire continuously with FPProjectilePool.Enabled 1, then 0, and compare."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&Report));
+}
+
+#endif // !UE_BUILD_SHIPPING
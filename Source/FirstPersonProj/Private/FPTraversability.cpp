@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPTraversability.h"
+#include "FPMovementComponent.h"
+#include "FPMovementStats.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/PackageName.h"
+
+static TAutoConsoleVariable<bool> CVarFPMovementTraversability(
+	TEXT("FPMovement.Traversability"),
+	true,
+	TEXT("Resolve steps up onto static geometry from the map's traversability bake instead of sweeping, when the map has one."));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked StepUps"), STAT_FPMovementBakedStepUps, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked StepUp Fallbacks"), STAT_FPMovementBakedStepUpFallbacks, STATGROUP_FPMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("StepUp Sweeps Saved (Estimated)"), STAT_FPMovementStepUpSweepsSaved, STATGROUP_FPMovement);
+
+static_assert(sizeof(FFPTraversabilitySurface) == 8, "FFPTraversabilitySurface is bulk serialized.");
+
+void UFPTraversabilityData::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	CellStarts.BulkSerialize(Ar);
+	Surfaces.BulkSerialize(Ar);
+}
+
+TArrayView<const FFPTraversabilitySurface> UFPTraversabilityData::GetSurfaces(const FVector& Location) const
+{
+	const int32 CellX = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+	const int32 CellY = FMath::FloorToInt((Location.Y - Origin.Y) / CellSize);
+	if (CellX < 0 || CellX >= NumCellsX || CellY < 0 || CellY >= NumCellsY || CellStarts.Num() != GetNumCells() + 1)
+	{
+		return TArrayView<const FFPTraversabilitySurface>();
+	}
+
+	const int32 Index = GetCellIndex(CellX, CellY);
+	return MakeArrayView(Surfaces.GetData() + CellStarts[Index], CellStarts[Index + 1] - CellStarts[Index]);
+}
+
+FVector UFPTraversabilityData::GetCellCenter(const FVector& Location) const
+{
+	return FVector(
+		Origin.X + (FMath::FloorToDouble((Location.X - Origin.X) / CellSize) + 0.5) * CellSize,
+		Origin.Y + (FMath::FloorToDouble((Location.Y - Origin.Y) / CellSize) + 0.5) * CellSize,
+		Location.Z);
+}
+
+void UFPTraversabilityData::Bake(UWorld* World, const FBox& Bounds, const UPrimitiveComponent& Capsule, float InCellSize, int32 MaxSurfacesPerCell)
+{
+	// How far below a hit the next trace starts, to get out of the thing that was hit.
+	constexpr float SkipDistance = 10.0f;
+	const int32 MaxTracesPerCell = MaxSurfacesPerCell * 16;
+
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	Origin = FVector(Bounds.Min.X, Bounds.Min.Y, 0.0f);
+	NumCellsX = FMath::Max(1, FMath::CeilToInt(Bounds.GetSize().X / CellSize));
+	NumCellsY = FMath::Max(1, FMath::CeilToInt(Bounds.GetSize().Y / CellSize));
+
+	CellStarts.Reset(GetNumCells() + 1);
+	Surfaces.Reset();
+
+	// Simple collision, through the capsule's channel and responses, which is what the capsule collides with.
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FPTraversabilityBake), false);
+	FCollisionResponseParams ResponseParams;
+	Capsule.InitSweepCollisionParams(QueryParams, ResponseParams);
+	const ECollisionChannel TraceChannel = Capsule.GetCollisionObjectType();
+	const float TopZ = Bounds.Max.Z + 1.0f;
+	const float BottomZ = Bounds.Min.Z - 1.0f;
+
+	for (int32 CellY = 0; CellY < NumCellsY; ++CellY)
+	{
+		for (int32 CellX = 0; CellX < NumCellsX; ++CellX)
+		{
+			CellStarts.Add(Surfaces.Num());
+
+			const double X = Origin.X + (CellX + 0.5) * CellSize;
+			const double Y = Origin.Y + (CellY + 0.5) * CellSize;
+			float StartZ = TopZ;
+			int32 NumSurfaces = 0;
+
+			for (int32 Trace = 0; Trace < MaxTracesPerCell && NumSurfaces < MaxSurfacesPerCell && StartZ > BottomZ; ++Trace)
+			{
+				FHitResult Hit;
+				if (!World->LineTraceSingleByChannel(Hit, FVector(X, Y, StartZ), FVector(X, Y, BottomZ), TraceChannel, QueryParams, ResponseParams))
+				{
+					break;
+				}
+
+				if (Hit.bStartPenetrating)
+				{
+					StartZ -= SkipDistance;
+					continue;
+				}
+
+				const UPrimitiveComponent* HitComponent = Hit.GetComponent();
+				if (HitComponent && HitComponent->Mobility == EComponentMobility::Static && Hit.ImpactNormal.Z > 0.0f)
+				{
+					FFPTraversabilitySurface& Surface = Surfaces.AddDefaulted_GetRef();
+					Surface.Z = Hit.ImpactPoint.Z;
+					Surface.NormalZ = static_cast<uint8>(FMath::Clamp(FMath::FloorToInt(Hit.ImpactNormal.Z * 255.0f), 0, 255));
+
+					// Anything above the surface that the trace came down through, or started inside of.
+					FHitResult CeilingHit;
+					const FVector CeilingStart(X, Y, Surface.Z + 0.1f);
+					Surface.Clearance = World->LineTraceSingleByChannel(CeilingHit, CeilingStart, CeilingStart + FVector(0.0f, 0.0f, MAX_uint16), TraceChannel, QueryParams, ResponseParams)
+						? static_cast<uint16>(FMath::FloorToInt(CeilingHit.Distance))
+						: MAX_uint16;
+
+					++NumSurfaces;
+				}
+
+				StartZ = Hit.ImpactPoint.Z - SkipDistance;
+			}
+		}
+	}
+
+	CellStarts.Add(Surfaces.Num());
+}
+
+FString UFPTraversabilityData::GetAssetPath(const UWorld* World)
+{
+	const FString MapName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(World->GetOutermost()->GetName()));
+	return FString::Printf(TEXT("/Game/Traversability/%s_Traversability"), *MapName);
+}
+
+FBox UFPTraversabilityData::GetStaticCollisionBounds(UWorld* World, const UPrimitiveComponent& Capsule)
+{
+	const ECollisionChannel CapsuleChannel = Capsule.GetCollisionObjectType();
+	FBox Bounds(ForceInit);
+	for (const AActor* Actor : TActorRange<AActor>(World))
+	{
+		Actor->ForEachComponent<UPrimitiveComponent>(false, [&Bounds, &Capsule, CapsuleChannel](const UPrimitiveComponent* Primitive)
+		{
+			if (Primitive->Mobility == EComponentMobility::Static && Primitive->IsCollisionEnabled()
+				&& Primitive->GetCollisionResponseToChannel(CapsuleChannel) == ECR_Block && Capsule.GetCollisionResponseToChannel(Primitive->GetCollisionObjectType()) == ECR_Block)
+			{
+				Bounds += Primitive->Bounds.GetBox();
+			}
+		});
+	}
+	return Bounds;
+}
+
+bool UFPTraversabilitySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UFPTraversabilitySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	BeginPlayTime = InWorld.GetTimeSeconds();
+
+	const FString PackagePath = UFPTraversabilityData::GetAssetPath(&InWorld);
+	if (!FPackageName::DoesPackageExist(PackagePath))
+	{
+		return;
+	}
+
+	Data = LoadObject<UFPTraversabilityData>(nullptr, *FString::Printf(TEXT("%s.%s"), *PackagePath, *FPackageName::GetShortName(PackagePath)));
+	if (Data)
+	{
+		UE_LOG(LogFPMovement, Log, TEXT("Loaded traversability bake %s: %d cells, %d surfaces, %.1f KB"),
+			*PackagePath, Data->GetNumCells(), Data->GetNumSurfaces(), Data->GetDataSize() / 1024.0);
+	}
+}
+
+const UFPTraversabilityData* UFPTraversabilitySubsystem::GetData() const
+{
+	return CVarFPMovementTraversability.GetValueOnGameThread() ? Data : nullptr;
+}
+
+void UFPTraversabilitySubsystem::RecordStepUp(bool bResolvedFromBake)
+{
+	if (bResolvedFromBake)
+	{
+		++NumBakedStepUps;
+		INC_DWORD_STAT(STAT_FPMovementBakedStepUps);
+		INC_DWORD_STAT_BY(STAT_FPMovementStepUpSweepsSaved, SweepsSavedPerStepUp);
+	}
+	else
+	{
+		++NumFallbackStepUps;
+		INC_DWORD_STAT(STAT_FPMovementBakedStepUpFallbacks);
+	}
+}
+
+void UFPTraversabilitySubsystem::LogReport() const
+{
+	if (!Data)
+	{
+		UE_LOG(LogFPMovement, Display, TEXT("No traversability bake for this map. Bake one with -run=FPTraversabilityBake -Map=%s"), *GetWorld()->GetOutermost()->GetName());
+		return;
+	}
+
+	const double Seconds = FMath::Max(GetWorld()->GetTimeSeconds() - BeginPlayTime, UE_SMALL_NUMBER);
+	const uint64 SweepsSaved = NumBakedStepUps * SweepsSavedPerStepUp;
+	UE_LOG(LogFPMovement, Display, TEXT("Traversability bake: %d cells of %.0fcm, %d surfaces, %.1f KB%s"),
+		Data->GetNumCells(), Data->GetCellSize(), Data->GetNumSurfaces(), Data->GetDataSize() / 1024.0, GetData() ? TEXT("") : TEXT(" (disabled by FPMovement.Traversability)"));
+	UE_LOG(LogFPMovement, Display, TEXT("  %llu step ups resolved from the bake, %llu fell back to sweeping (%.1f%% resolved)"),
+		NumBakedStepUps, NumFallbackStepUps, 100.0 * NumBakedStepUps / FMath::Max<uint64>(NumBakedStepUps + NumFallbackStepUps, 1));
+	UE_LOG(LogFPMovement, Display, TEXT("  ~%llu sweeps saved in %.1fs, %.1f per second (estimated at %d per baked step up, each traded for an overlap test and a line trace)"),
+		SweepsSaved, Seconds, SweepsSaved / Seconds, SweepsSavedPerStepUp);
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPTraversabilityCommands
+{
+	static void Report(UWorld* World)
+	{
+		if (const UFPTraversabilitySubsystem* Subsystem = World ? World->GetSubsystem<UFPTraversabilitySubsystem>() : nullptr)
+		{
+			Subsystem->LogReport();
+		}
+	}
+
+	static FAutoConsoleCommandWithWorld ReportCommand(
+		TEXT("FPMovement.Traversability.Report"),
+		TEXT("Log the map's traversability bake, how many step ups it resolved, and an estimate of the sweeps it saved per second."),
+		FConsoleCommandWithWorldDelegate::CreateStatic(&Report));
+}
+
+#endif // !UE_BUILD_SHIPPING
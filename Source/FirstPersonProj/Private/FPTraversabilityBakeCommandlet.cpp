@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPTraversabilityBakeCommandlet.h"
+#include "FPMovementComponent.h"
+#include "FPTraversability.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "FirstPersonProj/FirstPersonProjGameMode.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/SavePackage.h"
+
+UFPTraversabilityBakeCommandlet::UFPTraversabilityBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFPTraversabilityBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString MapPath = TEXT("/Game/FirstPerson/Maps/FirstPersonMap");
+	float CellSize = 20.0f;
+	FParse::Value(*Params, TEXT("Map="), MapPath);
+	FParse::Value(*Params, TEXT("CellSize="), CellSize);
+
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPath, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("Couldn't load map %s"), *MapPath);
+		return 1;
+	}
+
+	// Only needs collision: no physics simulation, navigation or audio.
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.RequiresHitProxies(false)
+			.ShouldSimulatePhysics(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true));
+	}
+	World->PersistentLevel->UpdateModelComponents();
+	World->UpdateWorldComponents(true, false);
+
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		StreamingLevel->SetShouldBeLoaded(true);
+		StreamingLevel->SetShouldBeVisible(true);
+	}
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	// Bake what the players' capsule collides with.
+	TSubclassOf<APawn> PawnClass = GetDefault<AFirstPersonProjGameMode>()->DefaultPawnClass;
+	if (!PawnClass || !PawnClass->IsChildOf(AFirstPersonProjCharacter::StaticClass()))
+	{
+		PawnClass = AFirstPersonProjCharacter::StaticClass();
+	}
+	const UCapsuleComponent& Capsule = *PawnClass->GetDefaultObject<AFirstPersonProjCharacter>()->GetCapsuleComponent();
+
+	const FBox Bounds = UFPTraversabilityData::GetStaticCollisionBounds(World, Capsule);
+	if (!Bounds.IsValid)
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("%s has no static collision to bake"), *MapPath);
+		World->RemoveFromRoot();
+		return 1;
+	}
+
+	const FString PackagePath = UFPTraversabilityData::GetAssetPath(World);
+	const FString AssetName = FPackageName::GetShortName(PackagePath);
+	UPackage* Package = CreatePackage(*PackagePath);
+	Package->FullyLoad();
+
+	UFPTraversabilityData* Data = FindObject<UFPTraversabilityData>(Package, *AssetName);
+	if (!Data)
+	{
+		Data = NewObject<UFPTraversabilityData>(Package, *AssetName, RF_Public | RF_Standalone);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	Data->Bake(World, Bounds, Capsule, CellSize);
+	const double BakeTime = FPlatformTime::Seconds() - StartTime;
+	Data->MarkPackageDirty();
+
+	World->RemoveFromRoot();
+
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackagePath, FPackageName::GetAssetPackageExtension());
+	if (!UPackage::SavePackage(Package, Data, *Filename, SaveArgs))
+	{
+		UE_LOG(LogFPMovement, Error, TEXT("Couldn't save %s"), *Filename);
+		return 1;
+	}
+
+	UE_LOG(LogFPMovement, Display, TEXT("Baked %s in %.1fs: %d cells of %.0fcm, %d surfaces, %.1f KB, saved to %s"),
+		*MapPath, BakeTime, Data->GetNumCells(), Data->GetCellSize(), Data->GetNumSurfaces(), Data->GetDataSize() / 1024.0, *Filename);
+	return 0;
+#else
+	UE_LOG(LogFPMovement, Error, TEXT("FPTraversabilityBake needs an editor build."));
+	return 1;
+#endif // WITH_EDITOR
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPViewmodel.h"
+#include "Math/RandomStream.h"
+
+DEFINE_LOG_CATEGORY(LogFPViewmodel);
+
+FFPViewmodelInputs FFPViewmodelInputs::Make(const FTransform& ActorToWorld, const FVector& CameraLocation, const FRotator& CameraRotation, const FVector& MeshTranslation, const FQuat& MeshRotation)
+{
+	const FQuat ActorQuat = ActorToWorld.GetRotation();
+
+	FFPViewmodelInputs Inputs;
+	Inputs.CameraLocation = ActorQuat.UnrotateVector(CameraLocation - ActorToWorld.GetLocation());
+	Inputs.CameraYaw = ActorQuat.Inverse() * FRotator(0.0f, CameraRotation.Yaw, 0.0f).Quaternion();
+	Inputs.CameraPitch = CameraRotation.Pitch;
+	Inputs.MeshTranslation = MeshTranslation;
+	Inputs.MeshRotation = MeshRotation;
+	return Inputs;
+}
+
+bool FFPViewmodelInputs::Equals(const FFPViewmodelInputs& Other) const
+{
+	return CameraPitch == Other.CameraPitch
+		&& CameraLocation.Equals(Other.CameraLocation, UE_KINDA_SMALL_NUMBER)
+		&& MeshTranslation.Equals(Other.MeshTranslation, UE_KINDA_SMALL_NUMBER)
+		&& CameraYaw.Equals(Other.CameraYaw, UE_KINDA_SMALL_NUMBER)
+		&& MeshRotation.Equals(Other.MeshRotation, UE_KINDA_SMALL_NUMBER);
+}
+
+FTransform FFPViewmodelSolver::Solve(const FFPViewmodelInputs& Inputs)
+{
+	// The camera's pitch, as a rotation of the pawn's local space around the camera.
+	const FQuat Pitch = Inputs.CameraYaw * FRotator(Inputs.CameraPitch, 0.0f, 0.0f).Quaternion() * Inputs.CameraYaw.Inverse();
+
+	return FTransform(
+		Pitch * Inputs.MeshRotation,
+		Inputs.CameraLocation + Pitch.RotateVector(Inputs.MeshTranslation - Inputs.CameraLocation));
+}
+
+FTransform FFPViewmodelSolver::SolveWithMatrices(const FTransform& ActorToWorld, const FVector& CameraLocation, const FRotator& CameraRotation, const FVector& MeshTranslation, const FQuat& MeshRotation)
+{
+	const FMatrix DefaultMeshLS = FRotationTranslationMatrix(MeshRotation.Rotator(), MeshTranslation);
+	const FMatrix LocalToWorld = ActorToWorld.ToMatrixNoScale();
+
+	const FRotator RotCameraPitch(CameraRotation.Pitch, 0.0f, 0.0f);
+	const FRotator RotCameraYaw(0.0f, CameraRotation.Yaw, 0.0f);
+
+	const FMatrix LeveledCameraLS = FRotationTranslationMatrix(RotCameraYaw, CameraLocation) * LocalToWorld.Inverse();
+	const FMatrix PitchedCameraLS = FRotationMatrix(RotCameraPitch) * LeveledCameraLS;
+
+	const FMatrix MeshRelativeToCamera = DefaultMeshLS * LeveledCameraLS.Inverse();
+	const FMatrix PitchedMesh = MeshRelativeToCamera * PitchedCameraLS;
+
+	return FTransform(PitchedMesh.Rotator(), PitchedMesh.GetOrigin());
+}
+
+bool FFPViewmodelSolver::Update(const FFPViewmodelInputs& Inputs, FTransform& OutRelativeTransform)
+{
+	if (bHasLastInputs && Inputs.Equals(LastInputs))
+	{
+		return false;
+	}
+
+	LastInputs = Inputs;
+	bHasLastInputs = true;
+	OutRelativeTransform = Solve(Inputs);
+	return true;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPViewmodelCommands
+{
+	struct FBenchmarkCase
+	{
+		FTransform ActorToWorld;
+		FVector CameraLocation;
+		FRotator CameraRotation;
+		FVector MeshTranslation;
+		FQuat MeshRotation;
+	};
+
+	static double CyclesToNs(uint64 Cycles)
+	{
+		return FPlatformTime::ToSeconds64(Cycles) * 1e9;
+	}
+
+	/** Poses the arms for random camera poses with the old matrix path and the new one, and logs the cost of each and how far apart they are. */
+	static void Benchmark(const TArray<FString>& Args)
+	{
+		const int32 NumCases = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+		// Poses a standing or crouching pawn's camera can be in.
+		FRandomStream Random(0x5EED);
+		TArray<FBenchmarkCase> Cases;
+		Cases.SetNum(NumCases);
+		for (FBenchmarkCase& Case : Cases)
+		{
+			const FRotator ActorRotation(0.0f, Random.FRandRange(-180.0f, 180.0f), 0.0f);
+			Case.ActorToWorld = FTransform(ActorRotation, Random.GetUnitVector() * Random.FRandRange(0.0f, 100000.0f));
+			Case.CameraLocation = Case.ActorToWorld.TransformPosition(FVector(0.0f, 0.0f, Random.FRandRange(40.0f, 64.0f)));
+			Case.CameraRotation = FRotator(Random.FRandRange(-89.0f, 89.0f), ActorRotation.Yaw + Random.FRandRange(-1.0f, 1.0f), 0.0f);
+			Case.MeshTranslation = FVector(-30.0f, 0.0f, -150.0f - Random.FRandRange(0.0f, 48.0f));
+			Case.MeshRotation = FRotator(0.9f, -19.19f, 5.2f).Quaternion();
+		}
+
+		// Keeps the results alive, so the optimizer can't drop the work.
+		FVector Checksum = FVector::ZeroVector;
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (const FBenchmarkCase& Case : Cases)
+		{
+			Checksum += FFPViewmodelSolver::SolveWithMatrices(Case.ActorToWorld, Case.CameraLocation, Case.CameraRotation, Case.MeshTranslation, Case.MeshRotation).GetLocation();
+		}
+		const uint64 MatrixCycles = FPlatformTime::Cycles64() - StartCycles;
+
+		StartCycles = FPlatformTime::Cycles64();
+		for (const FBenchmarkCase& Case : Cases)
+		{
+			Checksum += FFPViewmodelSolver::Solve(FFPViewmodelInputs::Make(Case.ActorToWorld, Case.CameraLocation, Case.CameraRotation, Case.MeshTranslation, Case.MeshRotation)).GetLocation();
+		}
+		const uint64 SolveCycles = FPlatformTime::Cycles64() - StartCycles;
+
+		// A camera that isn't moving relative to the pawn, as when standing still or running straight without looking around.
+		FFPViewmodelSolver Solver;
+		FTransform Unchanged;
+		const FBenchmarkCase& Still = Cases[0];
+		int32 NumSolves = 0;
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < NumCases; ++Index)
+		{
+			NumSolves += Solver.Update(FFPViewmodelInputs::Make(Still.ActorToWorld, Still.CameraLocation, Still.CameraRotation, Still.MeshTranslation, Still.MeshRotation), Unchanged) ? 1 : 0;
+		}
+		const uint64 UnchangedCycles = FPlatformTime::Cycles64() - StartCycles;
+
+		double MaxLocationError = 0.0;
+		double MaxAngleError = 0.0;
+		for (const FBenchmarkCase& Case : Cases)
+		{
+			const FTransform Old = FFPViewmodelSolver::SolveWithMatrices(Case.ActorToWorld, Case.CameraLocation, Case.CameraRotation, Case.MeshTranslation, Case.MeshRotation);
+			const FTransform New = FFPViewmodelSolver::Solve(FFPViewmodelInputs::Make(Case.ActorToWorld, Case.CameraLocation, Case.CameraRotation, Case.MeshTranslation, Case.MeshRotation));
+			MaxLocationError = FMath::Max(MaxLocationError, FVector::Dist(Old.GetLocation(), New.GetLocation()));
+			MaxAngleError = FMath::Max(MaxAngleError, FMath::RadiansToDegrees(Old.GetRotation().AngularDistance(New.GetRotation())));
+		}
+
+		UE_LOG(LogFPViewmodel, Display, TEXT("FPViewmodel.Benchmark: %d camera poses"), NumCases);
+		UE_LOG(LogFPViewmodel, Display, TEXT("  matrices:          %6.1f ns/pose"), CyclesToNs(MatrixCycles) / NumCases);
+		UE_LOG(LogFPViewmodel, Display, TEXT("  quaternions:       %6.1f ns/pose"), CyclesToNs(SolveCycles) / NumCases);
+		UE_LOG(LogFPViewmodel, Display, TEXT("  unchanged inputs:  %6.1f ns/pose, %d solves"), CyclesToNs(UnchangedCycles) / NumCases, NumSolves);
+		UE_LOG(LogFPViewmodel, Display, TEXT("  max difference:    %.4f cm, %.4f degrees (checksum %s)"), MaxLocationError, MaxAngleError, *Checksum.ToString());
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("FPViewmodel.Benchmark"),
+		TEXT("Time posing the first person arms with the old matrix path against the quaternion solver, and check they agree. Usage: FPViewmodel.Benchmark [Poses=100000]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Benchmark));
+}
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,333 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementProfile.h"
+#include "FPMovementTestWorld.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "FirstPersonProj/FirstPersonProjGameMode.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FPMovementBenchmarkTest
+{
+	using namespace FPMovementProfile;
+
+	/** Geometry in front of the pawn, built from the LevelPrototyping meshes on a flat floor. */
+	enum class ECourse : uint8
+	{
+		Flat,
+		Ramp,
+		Stairs,
+		Curve,
+		Num
+	};
+
+	struct FScenario
+	{
+		const TCHAR* Name;
+
+		ECourse Course;
+
+		bool bMoveForward;
+
+		bool bSprint;
+
+		/** Tick crouch is pressed on, or INDEX_NONE. */
+		int32 CrouchTick;
+
+		/** Ticks between jump presses, or 0. */
+		int32 JumpInterval;
+
+		/** Height above the floor the pawn starts at. */
+		float StartHeight;
+
+		/** Phase the scenario must run at least once, or it didn't exercise what it is named after. */
+		EPhase ExpectedPhase;
+	};
+
+	static const FScenario Scenarios[] =
+	{
+		{ TEXT("Walk"), ECourse::Flat, true, false, INDEX_NONE, 0, 0.0f, EPhase::Walk },
+		{ TEXT("Sprint"), ECourse::Flat, true, true, INDEX_NONE, 0, 0.0f, EPhase::Walk },
+		{ TEXT("Crouch"), ECourse::Flat, true, false, 0, 0, 0.0f, EPhase::Walk },
+		{ TEXT("Slide"), ECourse::Flat, true, true, 60, 0, 0.0f, EPhase::Slide },
+		{ TEXT("Jump"), ECourse::Flat, true, false, INDEX_NONE, 45, 0.0f, EPhase::Fall },
+		{ TEXT("Fall"), ECourse::Flat, false, false, INDEX_NONE, 0, 2000.0f, EPhase::Fall },
+		{ TEXT("Ramp"), ECourse::Ramp, true, false, INDEX_NONE, 0, 0.0f, EPhase::Walk },
+		{ TEXT("Stairs"), ECourse::Stairs, true, false, INDEX_NONE, 0, 0.0f, EPhase::StepUp },
+		{ TEXT("Curve"), ECourse::Curve, true, false, INDEX_NONE, 0, 0.0f, EPhase::Walk },
+	};
+
+	constexpr int32 NumTicks = 600;
+
+	constexpr int32 NumRuns = 3;
+
+	/** Each course gets its own lane along Y. */
+	static constexpr float CourseSpacing = 5000.0f;
+
+	static FVector GetCourseOrigin(ECourse Course)
+	{
+		return FVector(0.0f, static_cast<float>(Course) * CourseSpacing, 0.0f);
+	}
+
+	/** Returns false if a mesh the courses are built from couldn't be loaded. */
+	static bool BuildCourses(const FFPMovementTestWorld& TestWorld)
+	{
+		UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Game/LevelPrototyping/Meshes/SM_Cube.SM_Cube"));
+		UStaticMesh* Ramp = LoadObject<UStaticMesh>(nullptr, TEXT("/Game/LevelPrototyping/Meshes/SM_Ramp.SM_Ramp"));
+		UStaticMesh* QuarterCylinder = LoadObject<UStaticMesh>(nullptr, TEXT("/Game/LevelPrototyping/Meshes/SM_QuarterCylinder.SM_QuarterCylinder"));
+		if (!Cube || !Ramp || !QuarterCylinder)
+		{
+			return false;
+		}
+
+		for (int32 CourseIndex = 0; CourseIndex < static_cast<int32>(ECourse::Num); ++CourseIndex)
+		{
+			const ECourse Course = static_cast<ECourse>(CourseIndex);
+			const FVector Origin = GetCourseOrigin(Course);
+
+			// Long enough to sprint on for the whole run.
+			TestWorld.SpawnBlock(Cube, Origin + FVector(4000.0f, 0.0f, -50.0f), FVector(10000.0f, 1200.0f, 100.0f));
+
+			switch (Course)
+			{
+				case ECourse::Ramp:
+					TestWorld.SpawnBlock(Ramp, Origin + FVector(900.0f, 0.0f, 100.0f), FVector(800.0f, 600.0f, 200.0f));
+					break;
+				case ECourse::Stairs:
+				{
+					// 20cm steps, well under MaxStepHeight, up to a landing the pawn walks off.
+					constexpr int32 NumSteps = 8;
+					constexpr float StepRise = 20.0f;
+					constexpr float StepDepth = 50.0f;
+					for (int32 Step = 0; Step < NumSteps; ++Step)
+					{
+						const float Height = (Step + 1) * StepRise;
+						TestWorld.SpawnBlock(Cube, Origin + FVector(500.0f + (Step + 0.5f) * StepDepth, 0.0f, Height * 0.5f), FVector(StepDepth, 600.0f, Height));
+					}
+					TestWorld.SpawnBlock(Cube, Origin + FVector(500.0f + NumSteps * StepDepth + 300.0f, 0.0f, NumSteps * StepRise * 0.5f), FVector(600.0f, 600.0f, NumSteps * StepRise));
+					break;
+				}
+				case ECourse::Curve:
+					TestWorld.SpawnBlock(QuarterCylinder, Origin + FVector(900.0f, 0.0f, 150.0f), FVector(600.0f, 600.0f, 300.0f));
+					break;
+				default:
+					break;
+			}
+		}
+
+		return true;
+	}
+
+	static double CyclesToNs(uint64 Cycles)
+	{
+		return Cycles * FPlatformTime::GetSecondsPerCycle64() * 1000000000.0;
+	}
+
+	/** Run one scenario on a fresh pawn and return its counters. */
+	static FCounters RunScenario(UWorld* World, TSubclassOf<APawn> PawnClass, const FScenario& Scenario)
+	{
+		constexpr float DeltaTime = 1.0f / 60.0f;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		const FVector StartLocation = GetCourseOrigin(Scenario.Course) + FVector(0.0f, 0.0f, 100.0f + Scenario.StartHeight);
+		AFirstPersonProjCharacter* Pawn = World->SpawnActor<AFirstPersonProjCharacter>(PawnClass, StartLocation, FRotator::ZeroRotator, SpawnParams);
+		UFPMovementComponent* MoveComp = Pawn ? Cast<UFPMovementComponent>(Pawn->GetMovementComponent()) : nullptr;
+		if (!MoveComp)
+		{
+			if (Pawn)
+			{
+				Pawn->Destroy();
+			}
+			return FCounters();
+		}
+
+		Reset();
+		bEnabled = true;
+
+		for (int32 Tick = 0; Tick < NumTicks; ++Tick)
+		{
+			if (Scenario.bMoveForward)
+			{
+				Pawn->AddMovementInput(Pawn->GetActorForwardVector());
+			}
+			MoveComp->SetWantsToSprint(Scenario.bSprint);
+			MoveComp->SetWantsToCrouch(Scenario.CrouchTick != INDEX_NONE && Tick >= Scenario.CrouchTick);
+			if (Scenario.JumpInterval > 0 && Tick % Scenario.JumpInterval == 0)
+			{
+				Pawn->SetJumpInputPending(true);
+			}
+
+			MoveComp->TickMovement(DeltaTime, MoveComp->ConsumeInputVector());
+		}
+
+		bEnabled = false;
+		Pawn->Destroy();
+		return Counters;
+	}
+
+	static uint64 GetTotalCycles(const FCounters& Run)
+	{
+		uint64 TotalCycles = 0;
+		for (const uint64 Cycles : Run.ModeCycles)
+		{
+			TotalCycles += Cycles;
+		}
+		return TotalCycles;
+	}
+
+	static uint64 GetTotalTicks(const FCounters& Run)
+	{
+		uint64 TotalTicks = 0;
+		for (const uint64 Ticks : Run.ModeTicks)
+		{
+			TotalTicks += Ticks;
+		}
+		return TotalTicks;
+	}
+
+	static void Accumulate(FCounters& Total, const FCounters& Run)
+	{
+		for (int32 Phase = 0; Phase < static_cast<int32>(EPhase::Num); ++Phase)
+		{
+			Total.PhaseCycles[Phase] += Run.PhaseCycles[Phase];
+			Total.PhaseCalls[Phase] += Run.PhaseCalls[Phase];
+		}
+		for (int32 Mode = 0; Mode < FFPMovementModeRegistry::MaxModes; ++Mode)
+		{
+			Total.ModeCycles[Mode] += Run.ModeCycles[Mode];
+			Total.ModeTicks[Mode] += Run.ModeTicks[Mode];
+			Total.ModeSweeps[Mode] += Run.ModeSweeps[Mode];
+			Total.ModeMoves[Mode] += Run.ModeMoves[Mode];
+		}
+		Total.ModeSwitchCycles += Run.ModeSwitchCycles;
+		Total.ModeSwitches += Run.ModeSwitches;
+		Total.Queries += Run.Queries;
+		Total.Sweeps += Run.Sweeps;
+		Total.Moves += Run.Moves;
+		Total.SlideIterations += Run.SlideIterations;
+	}
+
+	/** Add a run's numbers to the test report, as lines for people and as telemetry for tracking them across builds. */
+	static void RecordCounters(FAutomationTestBase& Test, const TCHAR* Name, const FCounters& Run)
+	{
+		const uint64 Ticks = GetTotalTicks(Run);
+		if (Ticks == 0)
+		{
+			return;
+		}
+
+		FString Modes;
+		FString ModeQueries;
+		for (int32 Mode = 0; Mode < FFPMovementModeRegistry::MaxModes; ++Mode)
+		{
+			if (Run.ModeTicks[Mode] > 0)
+			{
+				const TCHAR* ModeName = FFPMovementModeRegistry::GetName(Mode);
+				const double SweepsPerModeTick = static_cast<double>(Run.ModeSweeps[Mode]) / Run.ModeTicks[Mode];
+				const double MovesPerModeTick = static_cast<double>(Run.ModeMoves[Mode]) / Run.ModeTicks[Mode];
+				Modes += FString::Printf(TEXT(" %s %.0f ns x%llu,"), ModeName, CyclesToNs(Run.ModeCycles[Mode]) / Run.ModeTicks[Mode], Run.ModeTicks[Mode]);
+				ModeQueries += FString::Printf(TEXT(" %s %.2f sweeps %.2f moves,"), ModeName, SweepsPerModeTick, MovesPerModeTick);
+
+				Test.AddTelemetryData(FString::Printf(TEXT("%sSweepsPerTick"), ModeName), SweepsPerModeTick, Name);
+				Test.AddTelemetryData(FString::Printf(TEXT("%sMovesPerTick"), ModeName), MovesPerModeTick, Name);
+			}
+		}
+
+		FString Phases;
+		for (int32 Phase = 0; Phase < static_cast<int32>(EPhase::Num); ++Phase)
+		{
+			if (Run.PhaseCalls[Phase] > 0)
+			{
+				Phases += FString::Printf(TEXT(" %s %.0f ns x%llu,"), GetPhaseName(static_cast<EPhase>(Phase)),
+					CyclesToNs(Run.PhaseCycles[Phase]) / Run.PhaseCalls[Phase], Run.PhaseCalls[Phase]);
+			}
+		}
+
+		const double NsPerTick = CyclesToNs(GetTotalCycles(Run)) / Ticks;
+		const double QueriesPerTick = static_cast<double>(Run.Queries) / Ticks;
+		const double SweepsPerTick = static_cast<double>(Run.Sweeps) / Ticks;
+		const double MovesPerTick = static_cast<double>(Run.Moves) / Ticks;
+
+		Test.AddInfo(FString::Printf(TEXT("%-8s %6.0f ns/tick, %.2f queries/tick (%.2f sweeps), %.2f moves/tick."), Name, NsPerTick, QueriesPerTick, SweepsPerTick, MovesPerTick));
+		Test.AddInfo(FString::Printf(TEXT("         by mode:%s"), *Modes.LeftChop(1)));
+		Test.AddInfo(FString::Printf(TEXT("         per tick by mode:%s"), *ModeQueries.LeftChop(1)));
+		Test.AddInfo(FString::Printf(TEXT("         self time:%s"), *Phases.LeftChop(1)));
+		Test.AddInfo(FString::Printf(TEXT("         mode switches: %llu, %.0f ns each"),
+			Run.ModeSwitches, Run.ModeSwitches > 0 ? CyclesToNs(Run.ModeSwitchCycles) / Run.ModeSwitches : 0.0));
+
+		Test.AddTelemetryData(TEXT("NsPerTick"), NsPerTick, Name);
+		Test.AddTelemetryData(TEXT("QueriesPerTick"), QueriesPerTick, Name);
+		Test.AddTelemetryData(TEXT("SweepsPerTick"), SweepsPerTick, Name);
+		Test.AddTelemetryData(TEXT("MovesPerTick"), MovesPerTick, Name);
+
+		const uint64 SlideCalls = Run.PhaseCalls[static_cast<int32>(EPhase::Slide)];
+		if (SlideCalls > 0)
+		{
+			const double SlideIterationsPerCall = static_cast<double>(Run.SlideIterations) / SlideCalls;
+			Test.AddInfo(FString::Printf(TEXT("         slide iterations: %.2f per PerformSlideMovement"), SlideIterationsPerCall));
+			Test.AddTelemetryData(TEXT("SlideIterationsPerCall"), SlideIterationsPerCall, Name);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementBenchmarkTest, "FirstPersonProj.Movement.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Drives a pawn through walk, sprint, crouch, slide, jump, fall, ramp, stairs and curve scenarios in a world of its own.
+ * Records ns/tick, sweeps and moves per tick by movement mode, self time per movement function, queries per tick and slide iterations
+ * per slide from the fastest of a few runs, and fails if a scenario doesn't run the movement it is named after.
+ */
+bool FFPMovementBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementBenchmarkTest;
+
+	FFPMovementTestWorld TestWorld;
+	TestWorld.BeginPlay();
+	UWorld* World = TestWorld.GetWorld();
+
+	if (!TestTrue(TEXT("LevelPrototyping meshes load"), BuildCourses(TestWorld)))
+	{
+		return false;
+	}
+
+	// The pawn players get, with its tuned movement settings.
+	TSubclassOf<APawn> PawnClass = AFirstPersonProjCharacter::StaticClass();
+	const TSubclassOf<APawn> DefaultPawnClass = GetDefault<AFirstPersonProjGameMode>()->DefaultPawnClass;
+	if (DefaultPawnClass && DefaultPawnClass->IsChildOf(AFirstPersonProjCharacter::StaticClass()))
+	{
+		PawnClass = DefaultPawnClass;
+	}
+
+	AddInfo(FString::Printf(TEXT("%d ticks at 60 Hz per scenario, fastest of %d runs"), NumTicks, NumRuns));
+
+	FCounters Total;
+	for (const FScenario& Scenario : Scenarios)
+	{
+		FCounters Best;
+		uint64 BestCycles = MAX_uint64;
+		for (int32 RunIndex = 0; RunIndex < NumRuns; ++RunIndex)
+		{
+			const FCounters Run = RunScenario(World, PawnClass, Scenario);
+			const uint64 RunCycles = GetTotalCycles(Run);
+			if (RunCycles < BestCycles)
+			{
+				Best = Run;
+				BestCycles = RunCycles;
+			}
+		}
+
+		TestTrue(FString::Printf(TEXT("%s ran movement ticks"), Scenario.Name), GetTotalTicks(Best) > 0);
+		TestTrue(FString::Printf(TEXT("%s ran %s"), Scenario.Name, GetPhaseName(Scenario.ExpectedPhase)), Best.PhaseCalls[static_cast<int32>(Scenario.ExpectedPhase)] > 0);
+
+		RecordCounters(*this, Scenario.Name, Best);
+		Accumulate(Total, Best);
+	}
+
+	RecordCounters(*this, TEXT("All"), Total);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/** A game world of its own for a movement test, with a world context so subsystems and timers work. Destroyed with this object. */
+class FFPMovementTestWorld
+{
+public:
+
+	FFPMovementTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+	}
+
+	~FFPMovementTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	UE_NONCOPYABLE(FFPMovementTestWorld);
+
+	UWorld* GetWorld() const { return World; }
+
+	/** Start play. Anything that has to be registered before play starts, like a navmesh, is spawned before calling this. */
+	void BeginPlay()
+	{
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+	}
+
+	/** Spawn Mesh scaled to fill a box of Size centered on Center. Static by default, like level geometry, so the floor cache treats it the same. */
+	AStaticMeshActor* SpawnBlock(UStaticMesh* Mesh, const FVector& Center, const FVector& Size, EComponentMobility::Type Mobility = EComponentMobility::Static) const
+	{
+		if (!Mesh)
+		{
+			return nullptr;
+		}
+
+		const FBox LocalBox = Mesh->GetBoundingBox();
+		const FVector Scale = Size / LocalBox.GetSize().ComponentMax(FVector(1.0f));
+		const FTransform Transform(FQuat::Identity, Center - LocalBox.GetCenter() * Scale, Scale);
+
+		AStaticMeshActor* Actor = World->SpawnActorDeferred<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform);
+		Actor->GetStaticMeshComponent()->SetMobility(Mobility);
+		Actor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+		Actor->FinishSpawning(Transform);
+		return Actor;
+	}
+
+private:
+
+	UWorld* World = nullptr;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
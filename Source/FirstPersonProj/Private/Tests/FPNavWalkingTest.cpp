@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementComponent.h"
+#include "FPMovementTestWorld.h"
+#include "FirstPersonProj/FirstPersonProjCharacter.h"
+#include "Components/BrushComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Misc/AutomationTest.h"
+#include "NavigationSystem.h"
+#include "NavMesh/NavMeshBoundsVolume.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "PhysicsEngine/BodySetup.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FPNavWalkingTest
+{
+	constexpr float DeltaTime = 1.0f / 60.0f;
+
+	/**
+	 * A navmesh that can be built in a game world. Navmeshes are built in the editor and static at runtime by default,
+	 * and a game world has no generator for those.
+	 */
+	static void SpawnDynamicNavMesh(UWorld* World)
+	{
+		ARecastNavMesh* NavMesh = World->SpawnActorDeferred<ARecastNavMesh>(ARecastNavMesh::StaticClass(), FTransform::Identity);
+		const FEnumProperty* RuntimeGeneration = CastField<FEnumProperty>(ANavigationData::StaticClass()->FindPropertyByName(TEXT("RuntimeGeneration")));
+		RuntimeGeneration->GetUnderlyingProperty()->SetIntPropertyValue(RuntimeGeneration->ContainerPtrToValuePtr<void>(NavMesh), static_cast<int64>(ERuntimeGenerationType::Dynamic));
+		NavMesh->FinishSpawning(FTransform::Identity);
+	}
+
+	/** Navmesh bounds volumes get their bounds from a brush, which can't be built outside the editor. A box body gives the same bounds. */
+	static void SpawnNavMeshBounds(UWorld* World, const FVector& Center, const FVector& Size)
+	{
+		ANavMeshBoundsVolume* Volume = World->SpawnActor<ANavMeshBoundsVolume>(Center, FRotator::ZeroRotator);
+		UBrushComponent* BrushComponent = Volume->GetBrushComponent();
+		BrushComponent->BrushBodySetup = NewObject<UBodySetup>(BrushComponent);
+		BrushComponent->BrushBodySetup->AggGeom.BoxElems.Add(FKBoxElem(Size.X, Size.Y, Size.Z));
+		BrushComponent->UpdateBounds();
+	}
+
+	static void TickPawn(AFirstPersonProjCharacter* Pawn, UFPMovementComponent* MoveComp)
+	{
+		Pawn->AddMovementInput(FVector::ForwardVector);
+		MoveComp->TickMovement(DeltaTime, MoveComp->ConsumeInputVector());
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPNavWalkingTest, "FirstPersonProj.Movement.NavWalking", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+/**
+ * Builds a navmesh over a floor in a world of its own, and walks an AI controlled pawn across it.
+ * The pawn has to switch to NavWalking, follow the navmesh, and hand over to Walking at a dynamic obstacle instead of passing through it.
+ */
+bool FFPNavWalkingTest::RunTest(const FString& Parameters)
+{
+	using namespace FPNavWalkingTest;
+
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Game/LevelPrototyping/Meshes/SM_Cube.SM_Cube"));
+	if (!TestNotNull(TEXT("LevelPrototyping cube loads"), Cube))
+	{
+		return false;
+	}
+
+	FFPMovementTestWorld TestWorld;
+	UWorld* World = TestWorld.GetWorld();
+
+	// The navmesh has to be registered before play starts, so the navigation octree is built for it.
+	SpawnDynamicNavMesh(World);
+	TestWorld.SpawnBlock(Cube, FVector(0.0f, 0.0f, -50.0f), FVector(4000.0f, 1000.0f, 100.0f));
+	SpawnNavMeshBounds(World, FVector::ZeroVector, FVector(4200.0f, 1200.0f, 600.0f));
+
+	TestWorld.BeginPlay();
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if (!TestNotNull(TEXT("World has a navigation system"), NavSys))
+	{
+		return false;
+	}
+	NavSys->Build();
+
+	FNavLocation NavFloor;
+	if (!TestTrue(TEXT("Navmesh covers the floor"), NavSys->ProjectPointToNavigation(FVector::ZeroVector, NavFloor, FVector(50.0f, 50.0f, 100.0f))))
+	{
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AFirstPersonProjCharacter* Pawn = World->SpawnActor<AFirstPersonProjCharacter>(AFirstPersonProjCharacter::StaticClass(), FVector(-1500.0f, 0.0f, 100.0f), FRotator::ZeroRotator, SpawnParams);
+	UFPMovementComponent* MoveComp = Pawn ? Cast<UFPMovementComponent>(Pawn->GetMovementComponent()) : nullptr;
+	if (!TestNotNull(TEXT("Pawn spawns with a UFPMovementComponent"), MoveComp))
+	{
+		return false;
+	}
+
+	// AI controlled, and without overlap events so NavWalking doesn't sweep.
+	Pawn->SpawnDefaultController();
+	if (!TestNotNull(TEXT("Pawn has an AI controller"), Pawn->GetController()))
+	{
+		return false;
+	}
+	Pawn->GetCapsuleComponent()->SetGenerateOverlapEvents(false);
+
+	bool bNavWalked = false;
+	for (int32 Tick = 0; Tick < 60; ++Tick)
+	{
+		TickPawn(Pawn, MoveComp);
+		bNavWalked |= MoveComp->GetMovementMode() == EFPMovementMode::NavWalking;
+	}
+
+	TestTrue(TEXT("Pawn NavWalks on the navmesh"), bNavWalked);
+	TestTrue(TEXT("Pawn is still NavWalking"), MoveComp->GetMovementMode() == EFPMovementMode::NavWalking);
+	TestTrue(TEXT("Pawn moved forward"), Pawn->GetActorLocation().X > -1400.0f);
+
+	// Something the navmesh doesn't know about, like a physics prop, right in front of the pawn.
+	const float ObstacleMinX = Pawn->GetActorLocation().X + 100.0f;
+	AStaticMeshActor* Obstacle = TestWorld.SpawnBlock(Cube, FVector(ObstacleMinX + 100.0f, 0.0f, 100.0f), FVector(200.0f, 1000.0f, 200.0f), EComponentMobility::Movable);
+	Obstacle->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAllDynamic_ProfileName);
+	Obstacle->GetStaticMeshComponent()->SetCanEverAffectNavigation(false);
+
+	for (int32 Tick = 0; Tick < 60; ++Tick)
+	{
+		TickPawn(Pawn, MoveComp);
+	}
+
+	TestTrue(TEXT("Pawn stopped NavWalking at the obstacle"), MoveComp->GetMovementMode() != EFPMovementMode::NavWalking);
+	TestTrue(TEXT("Pawn didn't pass into the obstacle"), Pawn->GetActorLocation().X + Pawn->GetCapsuleComponent()->GetScaledCapsuleRadius() <= ObstacleMinX + 1.0f);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
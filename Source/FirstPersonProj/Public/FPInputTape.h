@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPInputTape.generated.h"
+
+class AFirstPersonProjCharacter;
+
+/** Character input handlers recorded on an input tape. */
+enum class EFPInputTapeEvent : uint8
+{
+	Move,
+	Look,
+	Jump,
+	CrouchPressed,
+	CrouchReleased,
+	SprintPressed,
+	SprintReleased,
+	Num
+};
+
+/** Everything the character's input handlers received during one frame. */
+struct FFPInputTapeFrame
+{
+	/** Seconds since recording started, at the start of this frame. */
+	float Timestamp = 0.0f;
+
+	float DeltaTime = 0.0f;
+
+	/** One bit per EFPInputTapeEvent that fired this frame. */
+	uint8 EventMask = 0;
+
+	/** Only written to the tape on frames with a Move or Look event. */
+	FVector2f MoveValue = FVector2f::ZeroVector;
+
+	FVector2f LookValue = FVector2f::ZeroVector;
+
+	bool HasEvent(EFPInputTapeEvent Event) const { return (EventMask & (1 << static_cast<uint8>(Event))) != 0; }
+
+	void AddEvent(EFPInputTapeEvent Event) { EventMask |= 1 << static_cast<uint8>(Event); }
+
+	friend FArchive& operator<<(FArchive& Ar, FFPInputTapeFrame& Frame);
+};
+
+/** A recorded play session: where the pawn started, every frame's input, and where the pawn ended up. */
+struct FIRSTPERSONPROJ_API FFPInputTape
+{
+	FString MapName;
+
+	FVector StartLocation = FVector::ZeroVector;
+
+	FRotator StartRotation = FRotator::ZeroRotator;
+
+	FRotator StartControlRotation = FRotator::ZeroRotator;
+
+	FVector StartVelocity = FVector::ZeroVector;
+
+	bool bStartWantsToCrouch = false;
+
+	bool bStartWantsToSprint = false;
+
+	TArray<FFPInputTapeFrame> Frames;
+
+	/** Where the pawn was when recording stopped. A deterministic replay ends in the same place. */
+	FVector EndLocation = FVector::ZeroVector;
+
+	float GetDuration() const { return Frames.IsEmpty() ? 0.0f : Frames.Last().Timestamp + Frames.Last().DeltaTime; }
+
+	bool SaveToFile(const FString& Path) const;
+
+	bool LoadFromFile(const FString& Path);
+
+	/** Saved/InputTapes/<Name>.fptape */
+	static FString GetTapePath(const FString& Name);
+
+	friend FArchive& operator<<(FArchive& Ar, FFPInputTape& Tape);
+};
+
+/**
+ * Records the local player's input into an FFPInputTape, and replays tapes with the recorded frame deltas.
+ * Replays drive the engine with a fixed timestep per frame, so every replay of a tape simulates the same frames.
+ * Headless replay for profiling, which quits when the tape ends:
+ *     FirstPersonProj /Game/FirstPerson/Maps/FirstPersonMap -game -nullrhi -nosound -unattended -FPInputTape=<Name>
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPInputTapeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Start recording Pawn's input from the next frame. */
+	bool StartRecording(AFirstPersonProjCharacter* Pawn);
+
+	/** Stop recording and write the tape to Path. */
+	bool StopRecording(const FString& Path);
+
+	/** Put Pawn back where the tape started and feed it the tape's input, one recorded frame per engine frame. */
+	bool StartReplay(const FFPInputTape& InTape, AFirstPersonProjCharacter* Pawn, bool bInQuitWhenDone);
+
+	void StopReplay();
+
+	bool IsRecording() const { return Mode == EMode::Recording; }
+
+	bool IsReplaying() const { return Mode == EMode::Replaying; }
+
+	/** Called by the character's input handlers. Adds the input to the frame being recorded if Pawn is being recorded. */
+	static void RecordInput(const AFirstPersonProjCharacter* Pawn, EFPInputTapeEvent Event, const FVector2D& Value = FVector2D::ZeroVector);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Opens the next recorded frame, or feeds the next replayed one, before anything in the world ticks. */
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	void FeedReplayFrame(const FFPInputTapeFrame& Frame);
+
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		Replaying,
+	};
+
+	EMode Mode = EMode::Idle;
+
+	FFPInputTape Tape;
+
+	TWeakObjectPtr<AFirstPersonProjCharacter> TapePawn;
+
+	/** Index of the next frame to replay. */
+	int32 ReplayFrame = 0;
+
+	/** Engine frame the replay started on. Its first frame is fed on the frame after, which runs with the tape's first delta. */
+	uint64 ReplayStartFrameCounter = 0;
+
+	double ReplayStartWallTime = 0.0;
+
+	bool bQuitWhenDone = false;
+
+	/** Fixed timestep settings to put back when a replay ends. */
+	bool bPreviousUseFixedTimeStep = false;
+
+	double PreviousFixedDeltaTime = 0.0;
+
+	/** Tape named on the command line with -FPInputTape=, started as soon as the first player has a pawn. */
+	FString PendingReplayName;
+
+	FDelegateHandle WorldTickStartHandle;
+};
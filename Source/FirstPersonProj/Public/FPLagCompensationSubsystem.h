@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPLagCompensationSubsystem.generated.h"
+
+class AFirstPersonProjCharacter;
+
+/** A capsule pose at one point in time. Single precision so a sample fits in one cache line. */
+struct FFPCapsuleSample
+{
+	FVector3f Location = FVector3f::ZeroVector;
+
+	FQuat4f Rotation = FQuat4f::Identity;
+
+	/** Scaled half height, smaller while crouched. */
+	float HalfHeight = 0.0f;
+
+	float Radius = 0.0f;
+};
+
+static_assert(sizeof(FFPCapsuleSample) <= PLATFORM_CACHE_LINE_SIZE, "FFPCapsuleSample should fit in one cache line.");
+
+/**
+ * Fixed-size capsule histories for many pawns, all in one contiguous block.
+ * Each slot is a ring of Capacity samples ordered by time. Lookups binary search the slot's timestamps.
+ */
+class FIRSTPERSONPROJ_API FFPCapsuleHistory
+{
+public:
+
+	static constexpr int32 Capacity = 64;
+
+	/** Reserve a slot with an empty history. */
+	int32 AddSlot();
+
+	void RemoveSlot(int32 Slot);
+
+	/** Add a sample to a slot, dropping its oldest one if full. Samples older than the newest one are ignored. */
+	void Push(int32 Slot, double Time, const FFPCapsuleSample& Sample);
+
+	/**
+	 * Pose of a slot at Time, interpolated between the two samples around it. Times outside the history clamp to its ends.
+	 * O(log Capacity). Returns false if the slot has no samples.
+	 */
+	bool Sample(int32 Slot, double Time, FFPCapsuleSample& OutSample) const;
+
+	int32 GetNumSamples(int32 Slot) const { return Slots[Slot].Count; }
+
+private:
+
+	/** Index of the newest sample at or before Time, oldest first. -1 if every sample is newer. */
+	int32 FindSample(int32 Slot, double Time) const;
+
+	/** Position in Times and Samples of a slot's Index-th oldest sample. */
+	int32 GetSampleOffset(int32 Slot, int32 Index) const
+	{
+		return Slot * Capacity + (Slots[Slot].First + Index) % Capacity;
+	}
+
+	struct FSlot
+	{
+		/** Ring position of the oldest sample. */
+		int32 First = 0;
+
+		int32 Count = 0;
+	};
+
+	TArray<FSlot> Slots;
+
+	TArray<int32> FreeSlots;
+
+	/** Slot N owns [N * Capacity, (N + 1) * Capacity). Times are kept apart from the poses so the search only touches timestamps. */
+	TArray<double> Times;
+
+	TArray<FFPCapsuleSample> Samples;
+};
+
+/** A pawn's capsule rebuilt at a past time, to test shots against instead of moving the real capsule. */
+struct FFPRewoundCapsule
+{
+	AFirstPersonProjCharacter* Pawn = nullptr;
+
+	FFPCapsuleSample Capsule;
+};
+
+/** A validated shot hit a pawn: the shooter, the pawn hit, and where along the shot it was hit. */
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FFPOnShotHit, AFirstPersonProjCharacter* /*Shooter*/, AFirstPersonProjCharacter* /*HitPawn*/, const FVector& /*HitLocation*/);
+
+/**
+ * Server-side lag compensation. Records the capsule of every AFirstPersonProjCharacter each server tick,
+ * and rebuilds them at the time a client fired so its shots can be validated against what it saw.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterPawn(AFirstPersonProjCharacter* Pawn);
+
+	void UnregisterPawn(AFirstPersonProjCharacter* Pawn);
+
+	int32 GetNumRegisteredPawns() const { return Pawns.Num(); }
+
+	/** Time samples are stamped with. */
+	double GetServerTime() const;
+
+	/**
+	 * When the world looked to Shooter the way it did when they fired: now minus half their round trip time, the age of the
+	 * positions they were shown, and FPMovement.LagCompensation.InterpDelay. At most FPMovement.LagCompensation.MaxRewindTime ago.
+	 */
+	double GetRewindTime(const AController* Shooter) const;
+
+	/** Capsule of Pawn at Time. Returns false if the pawn isn't registered or has no history yet. */
+	bool GetCapsuleAtTime(const AFirstPersonProjCharacter* Pawn, double Time, FFPRewoundCapsule& OutCapsule) const;
+
+	/** Capsules of every registered pawn at Time. */
+	void RewindAll(double Time, TArray<FFPRewoundCapsule>& OutCapsules) const;
+
+	/**
+	 * Closest pawn whose capsule at Time the segment from Start to End passes through, ignoring IgnoredActor.
+	 * The segment stops at the first world geometry it hits, so shots don't pass through walls.
+	 * OutHitLocation is the point on the segment nearest the capsule's axis.
+	 */
+	AFirstPersonProjCharacter* ValidateShot(double Time, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FVector& OutHitLocation) const;
+
+	/**
+	 * Validate a shot Shooter fired from Start along Direction, up to FPMovement.LagCompensation.MaxShotRange, against the capsules
+	 * as they were at GetRewindTime. Broadcasts OnShotHit and returns the pawn if it hit one.
+	 */
+	AFirstPersonProjCharacter* ValidateFire(AFirstPersonProjCharacter* Shooter, const FVector& Start, const FVector& Direction);
+
+	/** Broadcast by ValidateFire for every shot that hit a pawn. */
+	FFPOnShotHit OnShotHit;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Record the current capsule of every registered pawn at Time. */
+	void RecordSamples(double Time);
+
+	struct FPawnEntry
+	{
+		TWeakObjectPtr<AFirstPersonProjCharacter> Pawn;
+
+		int32 Slot = INDEX_NONE;
+	};
+
+	TArray<FPawnEntry> Pawns;
+
+	FFPCapsuleHistory History;
+};
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackInput.h"
+#include "Chaos/SimCallbackObject.h"
+#include "FPMovementCore.h"
+
+class UFPMovementComponent;
+
+/** Kernel jobs marshalled from the game thread to the physics thread. */
+struct FFPMovementAsyncInput : public Chaos::FSimCallbackInput
+{
+	struct FPawnInput
+	{
+		/** Only passed back to the game thread. Never dereferenced on the physics thread. */
+		TWeakObjectPtr<UFPMovementComponent> Component;
+
+		FFPMovementKernelJob Job;
+
+		FFPMovementTunables Tunables;
+	};
+
+	TArray<FPawnInput> Pawns;
+
+	/** Game thread frame the input was produced on. Physics steps consuming the same frame's input are chained. */
+	uint64 Frame = 0;
+
+	void Reset()
+	{
+		Pawns.Reset();
+	}
+};
+
+/** Kernel results marshalled from the physics thread back to the game thread. */
+struct FFPMovementAsyncOutput : public Chaos::FSimCallbackOutput
+{
+	struct FPawnOutput
+	{
+		TWeakObjectPtr<UFPMovementComponent> Component;
+
+		FFPMovementKernelJob Job;
+	};
+
+	TArray<FPawnOutput> Pawns;
+
+	void Reset()
+	{
+		Pawns.Reset();
+	}
+};
+
+/**
+ * Runs the FPMovementCore velocity kernels on the physics thread, once per physics step with the physics delta time.
+ * With async physics enabled in the project settings that is a fixed rate, independent of the game thread frame rate.
+ * The first step for a frame's input starts from the state in that input, and every later step continues from the one before,
+ * so the outputs match consecutive fixed substeps on the game thread with the same input.
+ */
+class FFPMovementAsyncCallback : public Chaos::TSimCallbackObject<FFPMovementAsyncInput, FFPMovementAsyncOutput>
+{
+private:
+
+	virtual void OnPreSimulate_Internal() override;
+
+	/** Frame of the input the last step consumed. */
+	uint64 ChainedFrame = 0;
+
+	/** Each pawn's state after the last step, in the order of that input's pawns. */
+	TArray<FFPMovementState> ChainedStates;
+};
@@ -4,10 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PawnMovementComponent.h"
-#include "CharacterMovementComponentAsync.h"
+#include "WorldCollision.h"
+#include "FPMovementCore.h"
+#include "FPMovementModes.h"
+#include "FPMovementNetworking.h"
+#include "FPMovementTelemetry.h"
 #include "FPMovementComponent.generated.h"
 
 class AFirstPersonProjCharacter;
+class UFPTraversabilitySubsystem;
+class ANavigationData;
+struct FNavLocation;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPMovement, Log, All);
 
 /** Movement modes for first person character */
 UENUM(BlueprintType)
@@ -35,6 +44,18 @@ enum EFPMovementMode : int
 	MAX		UMETA(Hidden),
 };
 
+/** How often a pawn's movement is simulated, picked from its significance to the nearest viewer. */
+enum class EFPMovementLOD : uint8
+{
+	/** Simulated every frame. */
+	Full,
+	/** Simulated at a reduced rate with larger steps. */
+	Reduced,
+	/** Simulated rarely with large steps. For far away or unseen pawns. */
+	Minimal,
+	Num
+};
+
 /**
  * Custom first person movement component
  */
@@ -53,14 +74,22 @@ public:
 
 	virtual void InitializeComponent() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif // WITH_EDITOR
 
 	AFirstPersonProjCharacter* GetFPPOwner() const;
 
+protected:
+
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = nullptr, ETeleportType Teleport = ETeleportType::None) override;
+
 public:
 
 	/** Get the max angle in degrees of a walkable surface for the character. */
@@ -93,9 +122,9 @@ private:
 	 * Actor's current movement mode (walking, falling, etc).
 	 *    - walking:  Walking on a surface, under the effects of friction, and able to "step up" barriers. Vertical velocity is zero.
 	 *    - falling:  Falling under the effects of gravity, after jumping or walking off the edge of a surface.
-	 *    - custom:   User-defined custom movement mode, including many possible sub-modes.
-	 * This is automatically replicated through the Character owner and for client-server movement functions.
-	 * @see SetMovementMode(), CustomMovementMode
+	 *    - others:   Modes registered at runtime with FFPMovementModeRegistry.
+	 * Replicated to simulated proxies through ReplicatedState. The owning client predicts it, and the server corrects it through ClientAdjustPosition.
+	 * @see SetMovementMode(), FFPMovementModeRegistry
 	 */
 	UPROPERTY(Transient)
 	TEnumAsByte<enum EFPMovementMode> MovementMode;
@@ -106,9 +135,70 @@ protected:
 	AFirstPersonProjCharacter* CachedOwnerChar = nullptr;
 
 
-protected:
+public:
 
-	void PerformMovement(const float DeltaTime);
+	/**
+	 * Advance movement by a frame. Runs one update with the frame's delta, or fixed size substeps when bUseFixedTimestep is set.
+	 * An autonomous proxy also saves the move and sends it to the server. Simulated proxies, and pawns the server simulates for a remote client, don't move here.
+	 */
+	void TickMovement(const float DeltaTime, const FVector& InputVector);
+
+	/** Run one movement update for the current movement mode. */
+	void PerformMovement(const float DeltaTime, const FVector& InputVector);
+
+	/** Rotate the pawn to face ControlRotation at the start of the next movement tick, within its scoped update. */
+	void DeferFaceRotation(const FRotator& ControlRotation) { PendingFaceRotation = ControlRotation; }
+
+	EFPMovementLOD GetMovementLOD() const { return MovementLOD; }
+
+	/** Change the movement LOD. Ignored for less significant LODs while the pawn is held at full rate after a promotion. */
+	void SetMovementLOD(EFPMovementLOD NewLOD);
+
+	/** Go back to simulating every frame right away, and stay there for a while (FPMovement.LOD.PromotionHoldTime). */
+	void PromoteMovementLOD();
+
+	/** Returns true if movement is simulated in fixed size substeps. */
+	bool UsesFixedTimestep() const { return bUseFixedTimestep; }
+
+	/** Length of one fixed substep for this pawn, in seconds. */
+	float GetFixedTimestep() const;
+
+	/**
+	 * World space offset from the capsule to where it should be drawn, interpolated between the last two fixed substeps.
+	 * Zero when not using a fixed timestep.
+	 */
+	FVector GetVisualInterpolationOffset() const { return VisualInterpolationOffset; }
+
+	/** Build the velocity kernel job the current movement mode would run. Returns false if the mode has no velocity kernel. */
+	bool BuildKernelJob(const FVector& InputVector, float DeltaTime, FFPMovementKernelJob& OutJob) const;
+
+	/**
+	 * Hand over a kernel job that was computed ahead of time (e.g. by UFPMovementSubsystem), or null to clear it.
+	 * The next kernel run uses its result if its inputs still match, and recomputes otherwise.
+	 * The job is not copied. It has to stay alive until the next movement update ends, or be cleared.
+	 */
+	void SetPrecomputedKernelJob(const FFPMovementKernelJob* Job);
+
+	/** Gather the settings used by the velocity kernels in FPMovementCore. */
+	FFPMovementTunables GetMovementTunables() const;
+
+	/**
+	 * Hand over a kernel job the physics thread ran for one physics step, chained from this component's state at the end of the previous frame.
+	 * Kernel runs in the next movement update use it only if it has exactly their inputs: delta time, input and starting state.
+	 * Call once per physics step, in step order.
+	 */
+	void AddAsyncKernelResult(const FFPMovementKernelJob& Job);
+
+	/** Input vector of the last TickMovement. */
+	const FVector& GetLastInputVector() const { return LastInputVector; }
+
+	/** Recent movement updates, recorded while FPMovement.Telemetry is on. Null until the first one is recorded. */
+	const FFPMovementTelemetryRing* GetTelemetry() const { return Telemetry.Get(); }
+
+	/** The movable primitive the pawn is standing on and carried along by, if any. */
+	UPrimitiveComponent* GetMovementBase() const { return MovementBase.Get(); }
+
+protected:
 
 	void PerformWalkMovement(const float DeltaTime, const FVector& InputVector);
 
@@ -116,6 +206,180 @@ protected:
 
 	void PerformFallMovement(const float DeltaTime, const FVector& InputVector);
 
+	/** Walking without floor sweeps: the capsule follows the navmesh, and only sweeps if it generates overlap events. */
+	void PerformNavWalkMovement(const float DeltaTime, const FVector& InputVector);
+
+	/** Snapshot of the component state read and written by the velocity kernels. */
+	FFPMovementState GetMovementState() const;
+
+	/** Copy kernel results back onto the component. */
+	void ApplyMovementState(const FFPMovementState& State);
+
+	FFPMovementKernelJob MakeKernelJob(EFPMovementKernel Kernel, const FVector& InputVector, float DeltaTime) const;
+
+	/**
+	 * Run a velocity kernel, reusing the precomputed job or a physics thread step if one has exactly the same inputs, and apply the result.
+	 * Returns the slope acceleration reported by the slide kernel.
+	 */
+	FVector RunVelocityKernel(EFPMovementKernel Kernel, const FVector& InputVector, float DeltaTime);
+
+	/**
+	 * If true, movement is simulated in substeps of FixedTimestep seconds, carrying leftover time over to the next frame.
+	 * The capsule's visual position is interpolated between substeps, so rendering stays smooth at any frame rate.
+	 */
+	UPROPERTY(Category = "Character Movement: Fixed Timestep", EditAnywhere, BlueprintReadOnly)
+	bool bUseFixedTimestep = false;
+
+	/** Length of one substep when bUseFixedTimestep is set. */
+	UPROPERTY(Category = "Character Movement: Fixed Timestep", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0.001", UIMin = "0.001", ForceUnits = "s", EditCondition = "bUseFixedTimestep"))
+	float FixedTimestep = 1.0f / 60.0f;
+
+	/** If greater than zero, length of one substep for pawns the server simulates without a local controller. Lets the server run its simulation at a lower rate. */
+	UPROPERTY(Category = "Character Movement: Fixed Timestep", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s", EditCondition = "bUseFixedTimestep"))
+	float ServerFixedTimestep = 0.0f;
+
+	/** Maximum substeps in one frame. Time beyond that is dropped, so a hitch can't make the next frames more expensive. */
+	UPROPERTY(Category = "Character Movement: Fixed Timestep", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "1", UIMin = "1", EditCondition = "bUseFixedTimestep"))
+	int32 MaxSubsteps = 4;
+
+	/** Rotate the pawn like APawn::FaceRotation would, to the last rotation passed to DeferFaceRotation. */
+	void ApplyPendingFaceRotation();
+
+	/** Rotate the pawn like APawn::FaceRotation would, to ControlRotation. */
+	void ApplyFaceRotation(const FRotator& ControlRotation);
+
+	TOptional<FRotator> PendingFaceRotation;
+
+	/** Simulation time not yet consumed by a fixed substep. */
+	float TimestepAccumulator = 0.0f;
+
+	/** Capsule location before the last fixed substep. */
+	FVector PreviousSubstepLocation = FVector::ZeroVector;
+
+	FVector VisualInterpolationOffset = FVector::ZeroVector;
+
+	/** Compute VisualInterpolationOffset from the last two substeps and hand it to the owner. */
+	void UpdateVisualInterpolation(float StepAlpha);
+
+	EFPMovementLOD MovementLOD = EFPMovementLOD::Full;
+
+	/** Frame time not simulated yet because of the movement LOD. */
+	float LODAccumulatedTime = 0.0f;
+
+	/** Time left before a promoted pawn may be demoted again. */
+	float LODPromotionTimeRemaining = 0.0f;
+
+	/**
+	 * Accumulate frame time for the movement LOD. Returns true if movement should be simulated this frame, with OutDeltaTime set to the time to simulate.
+	 * Input promotes the pawn to full rate first.
+	 */
+	bool ConsumeLODTime(float DeltaTime, const FVector& InputVector, float& OutDeltaTime);
+
+	/** Simulate movement for a frame, honoring the movement LOD and fixed timestep settings. */
+	void SimulateMovement(const float FrameDeltaTime, const FVector& InputVector);
+
+	/** Simulate DeltaTime of movement, in fixed substeps when bUseFixedTimestep is set. The part of SimulateMovement a replay runs. */
+	void SimulateMovementSteps(const float DeltaTime, const FVector& InputVector);
+
+	/** Kernel job computed ahead of time, owned by whoever provided it. Only valid for the movement update it was provided for. */
+	const FFPMovementKernelJob* PrecomputedKernelJob = nullptr;
+
+	/** Kernel jobs run on the physics thread, in step order. Only valid for the next movement update. */
+	TArray<FFPMovementKernelJob, TInlineAllocator<4>> AsyncKernelResults;
+
+	FVector LastInputVector = FVector::ZeroVector;
+
+	/** Push a telemetry record for the PerformMovement that started in StartMode at StartLocation. */
+	void RecordTelemetry(float DeltaTime, EFPMovementMode StartMode, const FVector& StartLocation);
+
+	TUniquePtr<FFPMovementTelemetryRing> Telemetry;
+
+	/** Raised during the current PerformMovement, for its telemetry record. */
+	EFPMovementTelemetryFlags PendingTelemetryFlags = EFPMovementTelemetryFlags::None;
+
+public:
+
+	// Networking
+
+	/** Simulate a client's move on the server, then acknowledge it or send back a correction. */
+	UFUNCTION(Server, Unreliable)
+	void ServerMove(const FFPNetMove& Move);
+
+	/** ServerMove that also carries the oldest move the server hasn't acknowledged yet, which is simulated first if it never arrived. */
+	UFUNCTION(Server, Unreliable)
+	void ServerMoveWithOld(const FFPNetMove& OldMove, const FFPNetMove& NewMove);
+
+	/** The server ended up where the client did for every move up to MoveId. */
+	UFUNCTION(Client, Unreliable)
+	void ClientAckGoodMove(uint32 MoveId);
+
+	/** The server ended up somewhere else. Snap to its state and replay the moves it hasn't seen yet. */
+	UFUNCTION(Client, Unreliable)
+	void ClientAdjustPosition(const FFPMoveAdjustment& Adjustment);
+
+protected:
+
+	/**
+	 * Predict a move locally and save it. It is sent to the server right away, or held back while the next moves can be combined into it.
+	 * @see FPMovement.Net.MaxCombinedDeltaTime
+	 */
+	void ReplicateMoveToServer(const float DeltaTime, const FVector& InputVector);
+
+	/** Send the newest saved move if it hasn't been sent yet. */
+	void SendPendingMove();
+
+	/** Simulate a client move on the server unless it is older than the last one simulated, then acknowledge or correct it if bRespond is set. */
+	void ServerSimulateMove(const FFPNetMove& Move, bool bRespond);
+
+	/**
+	 * Re-simulate every unacknowledged saved move from the current state, each with the control rotation and time it was made with.
+	 * Replays skip the movement LOD and the pending face rotation, which belong to the frame being ticked, not to the saved move.
+	 */
+	void ReplaySavedMoves();
+
+	/** Timestamp of the saved move being replayed. Unset outside of ReplaySavedMoves. */
+	TOptional<float> ReplayTimeSeconds;
+
+	/** World time for the movement being simulated: the saved move's time during a replay, the current world time otherwise. */
+	float GetMovementTimeSeconds() const;
+
+	/** Button state for the next move, as EFPMoveFlags. */
+	uint8 GetMoveFlags() const;
+
+	/** Restore button state from EFPMoveFlags. */
+	void ApplyMoveFlags(uint8 Flags);
+
+	/** Set CrouchFrac, resizing the capsule if that crosses the crouched threshold. */
+	void ApplyCrouchFrac(float NewCrouchFrac);
+
+	/** Match the capsule and eye height to CrouchFrac after it changed from a value where IsCrouching() was bWasCrouched. */
+	void UpdateCrouchedCapsule(bool bWasCrouched);
+
+	/** Copy MovementMode and CrouchFrac into ReplicatedState. Only dirties it when the packed values change. */
+	void UpdateReplicatedState();
+
+	UFUNCTION()
+	void OnRep_ReplicatedState();
+
+	/** MovementMode and CrouchFrac for simulated proxies, packed into one bitfield. The owning client predicts these itself. */
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedState)
+	FFPCompactMovementState ReplicatedState;
+
+	/** Moves predicted by this client that the server hasn't acknowledged yet. */
+	FFPSavedMoveBuffer SavedMoves;
+
+	/** Id of the last move this client made. */
+	uint32 ClientMoveId = 0;
+
+	/** Blocking hits of swept moves so far. Compared before and after a move to tell whether it hit anything. */
+	uint32 NumBlockingHits = 0;
+
+	/** Id of the last client move the server simulated. */
+	uint32 ServerLastMoveId = 0;
+
+	/** Id of the newest move the server acknowledged or corrected. Acks and corrections for older moves arrive late and are dropped. */
+	uint32 ClientLastAckedMoveId = 0;
+
 protected:
 
 	// Walk/Ground movement
@@ -190,11 +454,94 @@ protected:
 
 	void SetIsSprinting(bool bNewIsSprinting);
 
+	/** Start or stop sprinting depending on whether the pawn wants to and can. */
+	void UpdateSprinting(const FVector& InputVector);
+
 	void StartGroundMovement();
 
 	void OnGroundMovementStopped();
 
-	void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult) const;
+	/**
+	 * Find the floor below the capsule. While the pawn stays close to where the floor was last swept on a static primitive, the cached floor is reused instead.
+	 *
+	 * @param CapsuleLocation		Location of the capsule to find the floor for.
+	 * @param OutFloorResult		[Out] The floor found.
+	 * @param DownwardSweepResult	If non-null, a downward sweep that ended at CapsuleLocation. Used as the floor without another sweep when it already hit a walkable surface.
+	 */
+	void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, const FHitResult* DownwardSweepResult = nullptr) const;
+
+	/** Sweep (and line trace if needed) for the floor, without looking at the floor cache. */
+	void ComputeFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult) const;
+
+	/** Extra reach of the floor checks for the current movement mode, in cm. */
+	float GetFloorHeightCheckAdjust() const;
+
+	/** Rebuild the floor at CapsuleLocation from the floor cache. Returns false if the cached floor can't be trusted there. */
+	bool TryReuseCachedFloor(const FVector& CapsuleLocation, const FVector2f& CapsuleSize, float HeightCheckAdjust, FFindFloorResult& OutFloorResult) const;
+
+	/**
+	 * Move a floor found at FromLocation to ToLocation, treating the floor as the plane of its hit.
+	 * Returns false if the floor would end up out of reach of a floor sweep from ToLocation.
+	 */
+	bool ProjectFloorResult(const FFindFloorResult& FloorResult, const FVector& FromLocation, const FVector& ToLocation, FFindFloorResult& OutFloorResult) const;
+
+	/**
+	 * Remember a floor found by ComputeFloor so later FindFloor calls nearby can reuse it.
+	 *
+	 * @param HeightCheckAdjust	GetFloorHeightCheckAdjust() when the floor was found.
+	 */
+	void UpdateFloorCache(const FVector& CapsuleLocation, const FVector2f& CapsuleSize, float HeightCheckAdjust, const FFindFloorResult& FloorResult) const;
+
+	/** Drop the cached floor, e.g. after a teleport. */
+	void InvalidateFloorCache();
+
+	/** Last floor found by ComputeFloor, keyed on the floor primitive, its transform, the capsule that found it and how far it looked. */
+	struct FFloorCache
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> FloorComponent;
+		FTransform FloorTransform;
+		FVector CapsuleLocation = FVector::ZeroVector;
+		/** Scaled capsule radius and half height. */
+		FVector2f CapsuleSize = FVector2f::ZeroVector;
+		float HeightCheckAdjust = 0.0f;
+		FFindFloorResult FloorResult;
+		bool bValid = false;
+	};
+
+	mutable FFloorCache FloorCache;
+
+	/** Returns true if floor and headroom checks should go through async scene queries (FPMovement.AsyncQueries). */
+	static bool UseAsyncQueries();
+
+	/**
+	 * Find the floor at the end of a walk move. With async queries enabled, the floor swept asynchronously at the end of the previous move is used
+	 * if it is still valid here, falling back to FindFloor otherwise, and a new async sweep is queued for the next move.
+	 */
+	void FindFloorDeferred(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult);
+
+	/** An async scene query queued by this component, and where the capsule was when it was queued. */
+	struct FPendingAsyncQuery
+	{
+		FTraceHandle Handle;
+		FVector CapsuleLocation = FVector::ZeroVector;
+		/** Scaled capsule radius and half height when the query was queued. */
+		FVector2f CapsuleSize = FVector2f::ZeroVector;
+
+		void Reset() { Handle = FTraceHandle(); }
+	};
+
+	/**
+	 * Fetch the result of a pending async sweep queued at most one frame ago, and clear the pending query.
+	 * Returns false if the result isn't available, or the capsule changed size or moved too far since it was queued.
+	 */
+	bool ConsumeAsyncSweep(FPendingAsyncQuery& PendingQuery, const FVector& CapsuleLocation, const FVector2f& CapsuleSize, FHitResult& OutHit) const;
+
+	/** Queue an async capsule sweep from Start to End with the same shape and collision settings as the synchronous queries. */
+	void QueueAsyncSweep(FPendingAsyncQuery& PendingQuery, const FVector& Start, const FVector& End, const FVector2f& CapsuleSize, const FCollisionShape& Shape) const;
+
+	mutable FPendingAsyncQuery PendingFloorQuery;
+
+	mutable FPendingAsyncQuery PendingHeadroomQuery;
 
 	bool IsWalkableSurface(const FHitResult& FloorHitResult) const;
 
@@ -215,6 +562,69 @@ protected:
 	 */
 	virtual bool StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult& Hit, FStepDownResult* OutStepDownResult = NULL);
 
+	/**
+	 * Step up onto static geometry using the map's traversability bake, with one overlap test in place of StepUp's sweeps.
+	 * Returns false, having done nothing, unless the bake shows a flat walkable step top under the capsule at the end of Delta with room for the capsule.
+	 */
+	bool TryBakedStepUp(const FVector& Delta, const FHitResult& Hit, float PawnRadius, float PawnHalfHeight, float PawnFloorPointZ, FStepDownResult* OutStepDownResult);
+
+	UPROPERTY(Transient)
+	UFPTraversabilitySubsystem* TraversabilitySubsystem = nullptr;
+
+	// NavMesh movement
+
+	/** Use NavWalking instead of Walking on the navmesh while controlled by AI. Saves the floor sweeps of every move. */
+	UPROPERTY(Category = "Character Movement: NavMesh Movement", EditAnywhere, BlueprintReadWrite)
+	bool bNavWalkWhenAIControlled = true;
+
+	/** Seconds between line traces correcting the navmesh's approximate height to the real floor while NavWalking. */
+	UPROPERTY(Category = "Character Movement: NavMesh Movement", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s"))
+	float NavWalkingFloorTraceInterval = 0.2f;
+
+	/** Seconds to keep Walking after leaving the navmesh or running into an obstacle, before trying NavWalking again. */
+	UPROPERTY(Category = "Character Movement: NavMesh Movement", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0", ForceUnits = "s"))
+	float NavWalkingRetryDelay = 1.0f;
+
+	bool ShouldNavWalk() const;
+
+	/** Switch from Walking to NavWalking if the pawn should and is standing on static geometry covered by the navmesh. */
+	void TryStartNavWalking();
+
+	/** Leave NavWalking for Walking, or Falling if there is no floor, and hand RemainingTime to the new mode. */
+	void StopNavWalking(float RemainingTime);
+
+	/** Project the bottom of a capsule at CapsuleLocation onto the navmesh. */
+	bool FindNavFloor(const FVector& CapsuleLocation, float PawnHalfHeight, FNavLocation& OutNavFloor) const;
+
+	const ANavigationData* GetNavData() const;
+
+	mutable TWeakObjectPtr<const ANavigationData> CachedNavData;
+
+	/** Real floor height minus navmesh height, as of the last floor trace. */
+	float NavFloorZOffset = 0.0f;
+
+	float NextNavFloorTraceTime = 0.0f;
+
+	float NavWalkingRetryTime = 0.0f;
+
+	// Based movement
+
+	/** Movable primitive the pawn is standing on. Null on static floors, which never move and need no tracking. Weak, as it can be destroyed under the pawn. */
+	UPROPERTY(Transient)
+	TWeakObjectPtr<UPrimitiveComponent> MovementBase;
+
+	/** Owner of MovementBase, whose tick this component's tick depends on too. */
+	TWeakObjectPtr<AActor> MovementBaseOwner;
+
+	/** Base on the floor the update ended on, and remember where the base is for the next update. */
+	void UpdateMovementBase();
+
+	/** Change the base, moving the tick prerequisites on the old base over to the new one. Also clears a base that was destroyed. */
+	void SetMovementBase(UPrimitiveComponent* NewBase);
+
+	/** Carry the pawn along with its base's movement since the last update. Swept, so the base can't carry the pawn into anything. */
+	void UpdateBasedMovement();
+
 	/**
 	 * Determine whether we should try to find a valid landing spot after an impact with an invalid one (based on the Hit result).
 	 * For example, landing on the lower portion of the capsule on the edge of geometry may be a walkable surface, but could have reported an unwalkable impact normal.
@@ -283,6 +693,8 @@ public:
 
 	void SetWantsToSprint(bool bWantsToSprint);
 
+	bool GetWantsToSprint() const { return bWantsToSprint; }
+
 	virtual bool IsFalling() const override;
 
 	virtual bool IsMovingOnGround() const override;
@@ -320,6 +732,8 @@ public:
 
 	void SetWantsToCrouch(bool bWantsToCrouch);
 
+	bool GetWantsToCrouch() const { return bWantsToCrouch; }
+
 	UFUNCTION(BlueprintPure)
 	bool CanCrouch() const;
 
@@ -360,6 +774,10 @@ protected:
 	UPROPERTY(Category = "Character Movement: Sliding", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
 	float SlideSpeedThreshold = 50.0f;
 
+	/** Moves in one slide tick. Each one past the first follows a surface or wall the previous one ran into. */
+	UPROPERTY(Category = "Character Movement: Sliding", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxSlideIterations = 3;
+
 	/**
 	 * Max angle in degrees of a walkable surface. Any greater than this and it is too steep to be walkable.
 	 */
@@ -397,11 +815,37 @@ public:
 
 	bool IsSliding() const;
 
-protected:
+	EFPMovementMode GetMovementMode() const { return MovementMode; }
 
+	/** Leave the current movement mode and enter NewMovementMode, which may be a mode registered with FFPMovementModeRegistry. */
 	void SetMovementMode(EFPMovementMode NewMovementMode);
 
+	/** State of the current movement mode. Zeroed whenever a mode is entered. */
+	template<typename T>
+	T& GetModeState() { return ModeState.As<T>(); }
+
+	/**
+	 * Called by a mode's tick after it changed the movement mode, to have the new mode run for the RemainingTime it didn't use.
+	 * PerformMovement runs it once the tick returns, so modes never call into each other.
+	 */
+	void HandOffRemainingTime(float RemainingTime) { PendingRemainingTime = RemainingTime; }
+
+protected:
+
+	/** Mode ticks run in one update, counting those handed the remaining time. Time left over after the last one is dropped. */
+	UPROPERTY(Category = "Character Movement (General Settings)", EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "1", UIMin = "1"))
+	int32 MaxModeIterations = 4;
+
+	/** Time handed to the next mode by HandOffRemainingTime during the current mode tick. */
+	float PendingRemainingTime = 0.0f;
+
+	/** Runs the registered exit and enter functions of the modes involved. */
 	void OnMovementModeChanged(EFPMovementMode OldMovementMode, EFPMovementMode NewMovementMode);
+
+	FFPMovementModeState ModeState;
+
+	/** Registers the built in modes, which call into the protected Perform*Movement functions. */
+	friend class FFPBuiltinMovementModes;
 	
 public:
 
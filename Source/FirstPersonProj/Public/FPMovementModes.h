@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UFPMovementComponent;
+
+/**
+ * Scratch state owned by the active movement mode, so that new modes don't add members to UFPMovementComponent.
+ * Zeroed before the mode's Enter is called.
+ */
+struct FFPMovementModeState
+{
+	static constexpr int32 Size = 32;
+
+	alignas(16) uint8 Bytes[Size] = {};
+
+	template<typename T>
+	T& As()
+	{
+		static_assert(sizeof(T) <= Size && alignof(T) <= 16, "Movement mode state doesn't fit in FFPMovementModeState.");
+		static_assert(TIsTriviallyDestructible<T>::Value, "Movement mode state is zeroed, never destroyed.");
+		return *reinterpret_cast<T*>(Bytes);
+	}
+
+	void Reset() { FMemory::Memzero(Bytes); }
+};
+
+/** What a movement mode does. Every function is optional. */
+struct FFPMovementModeFunctions
+{
+	/** Move the component for DeltaTime. May change mode and hand the rest of DeltaTime to the new mode with UFPMovementComponent::HandOffRemainingTime. */
+	using FTickFunction = void (*)(UFPMovementComponent& Component, float DeltaTime, const FVector& InputVector);
+
+	/** Enter gets the mode being left, Exit the mode being entered. */
+	using FTransitionFunction = void (*)(UFPMovementComponent& Component, uint8 OtherMode);
+
+	const TCHAR* Name = nullptr;
+
+	FTickFunction Tick = nullptr;
+
+	FTransitionFunction Enter = nullptr;
+
+	FTransitionFunction Exit = nullptr;
+
+	bool IsRegistered() const { return Tick != nullptr; }
+};
+
+/**
+ * Flat table of movement modes, indexed by movement mode. The EFPMovementMode modes are built in.
+ * Others are registered at runtime in the free indices after EFPMovementMode::MAX, e.g. by a game feature adding a ladder or wall run mode,
+ * and entered with UFPMovementComponent::SetMovementMode.
+ */
+class FIRSTPERSONPROJ_API FFPMovementModeRegistry
+{
+public:
+
+	/** Modes are replicated in FFPCompactMovementState::MovementModeBits bits. */
+	static constexpr int32 MaxModes = 8;
+
+	/** Register a mode in the first free index. Returns the index, or INDEX_NONE if the table is full. */
+	static int32 Register(const FFPMovementModeFunctions& Functions);
+
+	/** Free a registered mode's index. Built in modes can't be unregistered. */
+	static void Unregister(int32 Mode);
+
+	static const FFPMovementModeFunctions& Get(int32 Mode)
+	{
+		check(Mode >= 0 && Mode < MaxModes);
+		return Modes[Mode];
+	}
+
+	static const TCHAR* GetName(int32 Mode);
+
+private:
+
+	static FFPMovementModeFunctions Modes[MaxModes];
+};
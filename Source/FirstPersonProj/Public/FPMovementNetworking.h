@@ -0,0 +1,303 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Engine/NetSerialization.h"
+#include "FPMovementNetworking.generated.h"
+
+/** Button state captured with each move. */
+enum EFPMoveFlags : uint8
+{
+	FPMoveFlag_None = 0,
+	FPMoveFlag_Jump = 1 << 0,
+	FPMoveFlag_Sprint = 1 << 1,
+	FPMoveFlag_Crouch = 1 << 2,
+};
+
+/**
+ * Movement mode and crouch state packed into 11 bits: 3 for the EFPMovementMode and 8 for CrouchFrac.
+ * Replicated to simulated proxies and sent with corrections.
+ */
+USTRUCT()
+struct FFPCompactMovementState
+{
+	GENERATED_BODY()
+
+	/** Bits MovementMode is sent in. FFPMovementModeRegistry::MaxModes is tied to this. */
+	static constexpr int32 MovementModeBits = 3;
+
+	/** EFPMovementMode */
+	UPROPERTY()
+	uint8 MovementMode = 0;
+
+	/** CrouchFrac scaled to [0, 255]. */
+	UPROPERTY()
+	uint8 QuantizedCrouchFrac = 0;
+
+	void Set(uint8 InMovementMode, float CrouchFrac)
+	{
+		check(InMovementMode < (1 << MovementModeBits));
+		MovementMode = InMovementMode;
+		QuantizedCrouchFrac = static_cast<uint8>(FMath::RoundToInt(FMath::Clamp(CrouchFrac, 0.0f, 1.0f) * 255.0f));
+	}
+
+	float GetCrouchFrac() const { return QuantizedCrouchFrac / 255.0f; }
+
+	bool operator==(const FFPCompactMovementState& Other) const { return MovementMode == Other.MovementMode && QuantizedCrouchFrac == Other.QuantizedCrouchFrac; }
+
+	bool operator!=(const FFPCompactMovementState& Other) const { return !(*this == Other); }
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FFPCompactMovementState> : public TStructOpsTypeTraitsBase2<FFPCompactMovementState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * One client move, sent to the server to be simulated there. Bit-packed by NetSerialize:
+ * acceleration is quantized to 8 bits per horizontal axis, control rotation to 16 bits of yaw and pitch, delta time to 0.1ms, and the flags take 3 bits.
+ * Consecutive moves with the same input that walked at a constant velocity can be combined into one with the sum of their delta times.
+ */
+USTRUCT()
+struct FFPNetMove
+{
+	GENERATED_BODY()
+
+	/** Increases by one for every move a client makes. */
+	UPROPERTY()
+	uint32 MoveId = 0;
+
+	UPROPERTY()
+	float DeltaTime = 0.0f;
+
+	/** Horizontal acceleration input. Z is not sent. */
+	UPROPERTY()
+	FVector InputVector = FVector::ZeroVector;
+
+	/** Only yaw and pitch are sent. */
+	UPROPERTY()
+	FRotator ControlRotation = FRotator::ZeroRotator;
+
+	/** EFPMoveFlags */
+	UPROPERTY()
+	uint8 Flags = FPMoveFlag_None;
+
+	/** Where the move ended on the client, so the server can tell if it needs a correction. */
+	UPROPERTY()
+	FVector_NetQuantize100 ClientLocation = FVector::ZeroVector;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** Round an input vector the way NetSerialize does, so the client predicts with exactly what the server will get. */
+	static FVector QuantizeInputVector(const FVector& InputVector);
+
+	/** Round a control rotation the way NetSerialize does. */
+	static FRotator QuantizeControlRotation(const FRotator& ControlRotation);
+};
+
+template<>
+struct TStructOpsTypeTraits<FFPNetMove> : public TStructOpsTypeTraitsBase2<FFPNetMove>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** Authoritative state the server sends back when a client move ended somewhere else. */
+USTRUCT()
+struct FFPMoveAdjustment
+{
+	GENERATED_BODY()
+
+	/** The move this state is the result of. */
+	UPROPERTY()
+	uint32 MoveId = 0;
+
+	UPROPERTY()
+	FVector_NetQuantize100 Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Velocity = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantize10 InitialJumpVelocity = FVector::ZeroVector;
+
+	UPROPERTY()
+	FFPCompactMovementState State;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FFPMoveAdjustment> : public TStructOpsTypeTraitsBase2<FFPMoveAdjustment>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/** A move the client predicted and keeps until the server acknowledges it. */
+struct FFPSavedMove
+{
+	uint32 MoveId = 0;
+
+	float DeltaTime = 0.0f;
+
+	FVector InputVector = FVector::ZeroVector;
+
+	FRotator ControlRotation = FRotator::ZeroRotator;
+
+	/** EFPMoveFlags */
+	uint8 Flags = FPMoveFlag_None;
+
+	/** Fixed timestep accumulator before the move, so a replay substeps the same way. */
+	float StartTimestepAccumulator = 0.0f;
+
+	/** World time when the move was predicted, so a replay measures the jump grace period the same way. */
+	float Timestamp = 0.0f;
+
+	/** State after the move. */
+	FVector EndLocation = FVector::ZeroVector;
+
+	FVector EndVelocity = FVector::ZeroVector;
+
+	/**
+	 * True if the move walked at a constant velocity without hitting anything or changing mode.
+	 * Simulating such a move in one step or in several ends in the same place, so it can be combined.
+	 */
+	bool bLinearInDeltaTime = false;
+
+	/** True once the move went out in a ServerMove. A move still waiting to be sent can absorb the next one. */
+	bool bSent = false;
+
+	/** Largest difference in cm/s between the velocities of two moves that still counts as the same constant velocity. */
+	static constexpr float CombineVelocityTolerance = 1.0f;
+
+	/**
+	 * Returns true if Other could be merged into this move and sent as one, with a combined delta time of at most MaxDeltaTime.
+	 * The server simulates a combined move as a single step, so both moves have to be linear in delta time with the same velocity.
+	 */
+	bool CanCombineWith(const FFPSavedMove& Other, float MaxDeltaTime) const
+	{
+		// Jumps are edges, so a move with one is never stretched over several frames.
+		return !bSent && bLinearInDeltaTime && Other.bLinearInDeltaTime && EndVelocity.Equals(Other.EndVelocity, CombineVelocityTolerance)
+			&& ((Flags | Other.Flags) & FPMoveFlag_Jump) == 0 && Flags == Other.Flags
+			&& InputVector == Other.InputVector && ControlRotation == Other.ControlRotation
+			&& DeltaTime + Other.DeltaTime <= MaxDeltaTime;
+	}
+
+	/** Returns true if this move should be held back for one more move of FrameDeltaTime to be combined into it. */
+	bool ShouldWaitForCombine(float FrameDeltaTime, float MaxDeltaTime) const
+	{
+		return bLinearInDeltaTime && (Flags & FPMoveFlag_Jump) == 0 && DeltaTime + FrameDeltaTime <= MaxDeltaTime;
+	}
+
+	/** Longest combined move from FPMovement.Net.MaxCombinedDeltaTime, or zero when FPMovement.Net.CombineMoves is off. */
+	static float GetMaxCombinedDeltaTime();
+
+	/** Extend this move by Other, which happened right after it. */
+	void CombineWith(const FFPSavedMove& Other)
+	{
+		MoveId = Other.MoveId;
+		DeltaTime += Other.DeltaTime;
+		EndLocation = Other.EndLocation;
+		EndVelocity = Other.EndVelocity;
+	}
+
+	FFPNetMove ToNetMove() const
+	{
+		FFPNetMove NetMove;
+		NetMove.MoveId = MoveId;
+		NetMove.DeltaTime = DeltaTime;
+		NetMove.InputVector = InputVector;
+		NetMove.ControlRotation = ControlRotation;
+		NetMove.Flags = Flags;
+		NetMove.ClientLocation = EndLocation;
+		return NetMove;
+	}
+};
+
+/**
+ * Fixed capacity ring buffer of saved moves, oldest first. Never allocates.
+ * When full, pushing drops the oldest move. A correction can then only replay the moves that are left.
+ */
+class FFPSavedMoveBuffer
+{
+public:
+
+	static constexpr int32 Capacity = 128;
+
+	int32 Num() const { return Count; }
+
+	bool IsEmpty() const { return Count == 0; }
+
+	bool IsFull() const { return Count == Capacity; }
+
+	/** The newest move. The buffer must not be empty. */
+	FFPSavedMove& Last()
+	{
+		return (*this)[Count - 1];
+	}
+
+	/** Add a move at the end, dropping the oldest one if full, and return it for filling in. */
+	FFPSavedMove& Push()
+	{
+		if (IsFull())
+		{
+			First = (First + 1) % Capacity;
+			--Count;
+		}
+
+		FFPSavedMove& Move = Moves[(First + Count) % Capacity];
+		Move = FFPSavedMove();
+		++Count;
+		return Move;
+	}
+
+	/** Drop every move up to and including MoveId. */
+	void Acknowledge(uint32 MoveId)
+	{
+		while (Count > 0 && Moves[First].MoveId <= MoveId)
+		{
+			First = (First + 1) % Capacity;
+			--Count;
+		}
+	}
+
+	void Reset()
+	{
+		First = 0;
+		Count = 0;
+	}
+
+	/** Index 0 is the oldest move. */
+	FFPSavedMove& operator[](int32 Index)
+	{
+		check(Index >= 0 && Index < Count);
+		return Moves[(First + Index) % Capacity];
+	}
+
+	const FFPSavedMove& operator[](int32 Index) const
+	{
+		check(Index >= 0 && Index < Count);
+		return Moves[(First + Index) % Capacity];
+	}
+
+private:
+
+	TStaticArray<FFPSavedMove, Capacity> Moves;
+
+	int32 First = 0;
+
+	int32 Count = 0;
+};
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FPMovementComponent.h"
+
+/**
+ * Per-phase timings and query counts for the FirstPersonProj.Movement.Benchmark automation test. Game thread only.
+ * Costs a branch per scope unless a benchmark is running.
+ */
+namespace FPMovementProfile
+{
+	/** Movement functions timed on their own. */
+	enum class EPhase : uint8
+	{
+		Walk,
+		Slide,
+		Fall,
+		NavWalk,
+		StepUp,
+		Num
+	};
+
+	struct FCounters
+	{
+		/** Self time of each phase, not counting phases nested in it, e.g. StepUp within Walk. */
+		uint64 PhaseCycles[static_cast<int32>(EPhase::Num)] = {};
+
+		uint64 PhaseCalls[static_cast<int32>(EPhase::Num)] = {};
+
+		/** Whole PerformMovement calls, by the movement mode they started in. */
+		uint64 ModeCycles[FFPMovementModeRegistry::MaxModes] = {};
+
+		uint64 ModeTicks[FFPMovementModeRegistry::MaxModes] = {};
+
+		/** Sweeps and capsule moves made during the PerformMovement calls of each mode. */
+		uint64 ModeSweeps[FFPMovementModeRegistry::MaxModes] = {};
+
+		uint64 ModeMoves[FFPMovementModeRegistry::MaxModes] = {};
+
+		/** OnMovementModeChanged calls, running the exit and enter functions of the modes. */
+		uint64 ModeSwitchCycles = 0;
+
+		uint64 ModeSwitches = 0;
+
+		/** Sweeps and line traces, including async ones. Moves of the capsule are counted separately. */
+		uint64 Queries = 0;
+
+		/** The sweeps among Queries. */
+		uint64 Sweeps = 0;
+
+		/** Calls to MoveUpdatedComponent, which sweeps the capsule unless teleporting. */
+		uint64 Moves = 0;
+
+		/** Iterations of the slide integrator, each accelerating along the surface and making one move. */
+		uint64 SlideIterations = 0;
+	};
+
+	extern FIRSTPERSONPROJ_API bool bEnabled;
+
+	extern FIRSTPERSONPROJ_API FCounters Counters;
+
+	FIRSTPERSONPROJ_API void Reset();
+
+	FIRSTPERSONPROJ_API const TCHAR* GetPhaseName(EPhase Phase);
+
+	/** Adds its lifetime to a phase, minus any phase scopes opened inside it. */
+	struct FIRSTPERSONPROJ_API FPhaseScope
+	{
+		explicit FPhaseScope(EPhase Phase);
+
+		~FPhaseScope();
+
+	private:
+
+		int32 PreviousPhase = INDEX_NONE;
+
+		bool bActive = false;
+	};
+
+	/** Adds its lifetime, and the sweeps and moves made in it, to the movement mode it was opened in. */
+	struct FIRSTPERSONPROJ_API FModeScope
+	{
+		explicit FModeScope(EFPMovementMode Mode);
+
+		~FModeScope();
+
+	private:
+
+		uint64 StartCycles = 0;
+
+		uint64 StartSweeps = 0;
+
+		uint64 StartMoves = 0;
+
+		EFPMovementMode Mode;
+
+		bool bActive = false;
+	};
+
+	/** Adds its lifetime to the mode switch counters. */
+	struct FIRSTPERSONPROJ_API FModeSwitchScope
+	{
+		FModeSwitchScope();
+
+		~FModeSwitchScope();
+
+	private:
+
+		uint64 StartCycles = 0;
+
+		bool bActive = false;
+	};
+
+	inline void CountQuery()
+	{
+		Counters.Queries += bEnabled ? 1 : 0;
+	}
+
+	inline void CountSweep()
+	{
+		Counters.Queries += bEnabled ? 1 : 0;
+		Counters.Sweeps += bEnabled ? 1 : 0;
+	}
+
+	inline void CountMove()
+	{
+		Counters.Moves += bEnabled ? 1 : 0;
+	}
+
+	inline void CountSlideIteration()
+	{
+		Counters.SlideIterations += bEnabled ? 1 : 0;
+	}
+}
@@ -0,0 +1,9 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** Stat group for the first person movement pipeline. Shown with "stat FPMovement". */
+DECLARE_STATS_GROUP(TEXT("FPMovement"), STATGROUP_FPMovement, STATCAT_Advanced);
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "FPMovementCore.h"
+#include "FPMovementCoreBatch.h"
+#include "SignificanceManager.h"
+#include "FPMovementSubsystem.generated.h"
+
+class UFPMovementComponent;
+class UFPMovementSubsystem;
+class FFPMovementAsyncCallback;
+
+/** Runs UFPMovementSubsystem's batched movement in TG_PrePhysics, where the components' own tick functions would have run. */
+USTRUCT()
+struct FFPMovementBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UFPMovementSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FFPMovementBatchTickFunction> : public TStructOpsTypeTraitsBase2<FFPMovementBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks every registered UFPMovementComponent in one batched pass when FPMovement.Batched is enabled, from a tick function in TG_PrePhysics.
+ * Also drives the significance manager every frame, which picks each pawn's movement LOD.
+ * The velocity phase runs for all pawns in parallel, then sweeps and mode transitions are committed in registration order.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPMovementSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	void RegisterComponent(UFPMovementComponent* Component);
+
+	void UnregisterComponent(UFPMovementComponent* Component);
+
+	/** Returns true if registered components are ticked by this subsystem instead of their own tick functions. */
+	static bool IsBatchingEnabled();
+
+	/** Move every registered component once using the batched path. */
+	void TickBatched(float DeltaTime);
+
+	/** Move every registered component once using the per-component path, for comparison. */
+	void TickSerial(float DeltaTime);
+
+	int32 GetNumRegisteredComponents() const { return MovementComponents.Num(); }
+
+	/** Average game thread cost of TickBatched over the last few frames, in milliseconds. */
+	double GetAverageBatchTimeMs() const { return AverageBatchTimeMs; }
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Update the significance of every registered pawn from the players' viewpoints, which picks their movement LOD. */
+	void UpdateSignificance();
+
+	static float CalculateSignificance(USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& Viewpoint);
+
+	static void PostSignificanceUpdate(USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal);
+
+	/** Register or unregister the physics thread callback to match FPMovement.AsyncPhysics. */
+	void UpdateAsyncPhysicsCallback();
+
+	/** Hand the kernel results computed on the physics thread to their components. */
+	void ConsumeAsyncPhysicsOutputs();
+
+	/** Send every component's post-move state and input to the physics thread for the next step. */
+	void ProduceAsyncPhysicsInputs();
+
+	/** Runs the velocity kernels on the physics thread. Owned by the physics solver, null when async physics is off. */
+	FFPMovementAsyncCallback* AsyncCallback = nullptr;
+
+	/**
+	 * Enable or disable the components' own tick functions to match the batching setting, and the batch tick function to the opposite.
+	 * Components whose tick was already disabled are left alone, and stay disabled when batching is turned off.
+	 */
+	void ApplyBatchingMode(bool bBatched);
+
+	/** Stop a component's own tick function while it is batched, remembering to restart it when batching is turned off. */
+	void DisableComponentTick(UFPMovementComponent* Component);
+
+	FFPMovementBatchTickFunction BatchTickFunction;
+
+	/** Components whose own tick function was disabled by ApplyBatchingMode or RegisterComponent. */
+	UPROPERTY(Transient)
+	TSet<TObjectPtr<UFPMovementComponent>> BatchDisabledTickComponents;
+
+	/** Components in registration order. Commits happen in this order so results are deterministic. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFPMovementComponent>> MovementComponents;
+
+	/** Per frame scratch data, kept around to avoid reallocating every frame. */
+	struct FBatchEntry
+	{
+		UFPMovementComponent* Component = nullptr;
+		FVector InputVector = FVector::ZeroVector;
+		FFPMovementTunables Tunables;
+		FFPMovementKernelJob Job;
+		bool bHasJob = false;
+
+		/** Lane of this entry in the SIMD batch for its kernel. */
+		int32 KernelBatchLane = INDEX_NONE;
+	};
+
+	TArray<FBatchEntry> BatchEntries;
+
+	/** Run the velocity phase with the SIMD batch kernels, one structure-of-arrays batch per kernel. */
+	void RunVelocityPhaseSIMD();
+
+	/** Run the velocity phase with the scalar kernels. */
+	void RunVelocityPhaseScalar();
+
+	/** Structure-of-arrays batches indexed by EFPMovementKernel. */
+	FFPMovementKernelBatch KernelBatches[3];
+
+	bool bBatchingApplied = false;
+
+	double AverageBatchTimeMs = 0.0;
+};
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+class UWorld;
+
+/** What happened during the move an FFPMovementTelemetryRecord describes. */
+enum class EFPMovementTelemetryFlags : uint8
+{
+	None = 0,
+
+	/** A swept move of the capsule was blocked. */
+	BlockingHit = 1 << 0,
+
+	SteppedUp = 1 << 1,
+
+	/** Standing on a walkable floor at the end of the move. */
+	OnWalkableFloor = 1 << 2,
+
+	/** The movement mode at the end of the move differs from the one it started in. */
+	ModeChanged = 1 << 3,
+};
+ENUM_CLASS_FLAGS(EFPMovementTelemetryFlags);
+
+/** One PerformMovement call. */
+struct FFPMovementTelemetryRecord
+{
+	/** World time when the move started. */
+	double Time = 0.0;
+
+	/** Velocity at the end of the move. */
+	FVector3f Velocity = FVector3f::ZeroVector;
+
+	/** Zero when not on a floor. */
+	FVector3f FloorNormal = FVector3f::ZeroVector;
+
+	/** How far the capsule moved. */
+	FVector3f Delta = FVector3f::ZeroVector;
+
+	float DeltaTime = 0.0f;
+
+	/** EFPMovementMode the move started in. */
+	uint8 Mode = 0;
+
+	EFPMovementTelemetryFlags Flags = EFPMovementTelemetryFlags::None;
+
+	friend FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryRecord& Record);
+};
+
+/**
+ * The most recent telemetry records of one movement component.
+ * The game thread is the only writer. Snapshot may be called from any thread without a lock: it copies the newest records,
+ * then drops any the writer could have overwritten while they were being copied.
+ */
+class FIRSTPERSONPROJ_API FFPMovementTelemetryRing
+{
+public:
+
+	/** Power of two. About 8 seconds of movement at 60 Hz. */
+	static constexpr uint32 Capacity = 512;
+
+	void Push(const FFPMovementTelemetryRecord& Record);
+
+	/** Copy the records still in the ring, oldest first. */
+	void Snapshot(TArray<FFPMovementTelemetryRecord>& OutRecords) const;
+
+	uint64 GetNumPushed() const { return NumPushed.load(std::memory_order_acquire); }
+
+private:
+
+	FFPMovementTelemetryRecord Records[Capacity];
+
+	std::atomic<uint64> NumPushed = 0;
+};
+
+/** Telemetry of one component, as written to a dump. */
+struct FFPMovementTelemetryStream
+{
+	/** Name of the component's owner. */
+	FString Name;
+
+	TArray<FFPMovementTelemetryRecord> Records;
+
+	friend FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryStream& Stream);
+};
+
+/** Every stream in a world at the time of the dump. Convert to CSV with -run=FPMovementTelemetry. */
+struct FIRSTPERSONPROJ_API FFPMovementTelemetryDump
+{
+	/** Why the dump was written, e.g. "Manual" or "Hitch". */
+	FString Reason;
+
+	FString MapName;
+
+	TArray<FFPMovementTelemetryStream> Streams;
+
+	bool SaveToFile(const FString& Path) const;
+
+	bool LoadFromFile(const FString& Path);
+
+	/** Saved/MovementTelemetry/ */
+	static FString GetDumpDir();
+
+	friend FArchive& operator<<(FArchive& Ar, FFPMovementTelemetryDump& Dump);
+};
+
+namespace FPMovementTelemetry
+{
+	/** FPMovement.Telemetry */
+	FIRSTPERSONPROJ_API bool IsEnabled();
+
+	/** Write the telemetry of every movement component in World to the dump dir. Returns the file written, or an empty string. */
+	FIRSTPERSONPROJ_API FString DumpWorld(UWorld* World, const FString& Reason);
+
+	/** Dump World if the last frame took longer than FPMovement.Telemetry.HitchMs. Checks once per frame however often it is called. */
+	void CheckForHitch(UWorld* World);
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FPMovementTelemetryCommandlet.generated.h"
+
+/**
+ * Converts movement telemetry dumps to CSV, one row per record.
+ *     UnrealEditor-Cmd FirstPersonProj.uproject -run=FPMovementTelemetry -In=<Dump.fpmt> [-Out=<File.csv>]
+ * With no -In, converts every dump in Saved/MovementTelemetry. Out defaults to the dump path with a .csv extension.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPMovementTelemetryCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UFPMovementTelemetryCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+	static bool ConvertToCsv(const FString& InPath, const FString& OutPath);
+};
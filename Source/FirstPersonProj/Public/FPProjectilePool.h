@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPProjectilePool.generated.h"
+
+class AFirstPersonProjProjectile;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPProjectilePool, Log, All);
+
+/** Projectiles of one class waiting in the pool. */
+USTRUCT()
+struct FFPProjectileFreeList
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AFirstPersonProjProjectile>> Projectiles;
+};
+
+/**
+ * Keeps fired projectiles around instead of destroying them, and fires them again instead of spawning new ones.
+ * A projectile goes back to the pool when it hits a physics body or its life span runs out. Weapons prewarm the pool for their projectile class.
+ * With FPProjectilePool.Enabled off, every shot spawns and every projectile is destroyed, for comparison.
+ * Garbage collections are timed separately with the pool on and off, so a sustained-fire run of each can be compared in the report.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Spawn projectiles of Class into the pool until Count of them are waiting. */
+	void Prewarm(TSubclassOf<AFirstPersonProjProjectile> Class, int32 Count);
+
+	/** Fire a projectile of Class from Location, reusing a pooled one if there is one. Returns null if a new one was needed and couldn't spawn there. */
+	AFirstPersonProjProjectile* Acquire(TSubclassOf<AFirstPersonProjProjectile> Class, const FVector& Location, const FRotator& Rotation, AActor* Owner, APawn* Instigator);
+
+	/** Put a projectile fired by Acquire back in the pool. */
+	void Release(AFirstPersonProjProjectile* Projectile);
+
+	void LogReport() const;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Spawn a projectile, timing it for the report. */
+	AFirstPersonProjProjectile* SpawnProjectile(TSubclassOf<AFirstPersonProjProjectile> Class, const FVector& Location, const FRotator& Rotation, AActor* Owner, APawn* Instigator, bool bPooled);
+
+	void OnPreGarbageCollect();
+
+	void OnPostGarbageCollect();
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FFPProjectileFreeList> FreeLists;
+
+	int32 NumActive = 0;
+
+	uint64 NumFired = 0;
+
+	uint64 NumReused = 0;
+
+	uint64 NumReleased = 0;
+
+	uint64 NumSpawned = 0;
+
+	/** Spawned while FPProjectilePool.Enabled was off, and destroyed as before. */
+	uint64 NumSpawnedUnpooled = 0;
+
+	uint64 SpawnCycles = 0;
+
+	uint64 ReuseCycles = 0;
+
+	FDelegateHandle PreGarbageCollectHandle;
+
+	FDelegateHandle PostGarbageCollectHandle;
+
+	uint64 GCStartCycles = 0;
+
+	/** Whether FPProjectilePool.Enabled was on when the current garbage collection started. */
+	bool bGCWithPoolEnabled = false;
+
+	/** Garbage collections and the time they took, indexed by whether FPProjectilePool.Enabled was on. */
+	uint64 NumGCs[2] = {};
+
+	uint64 GCCycles[2] = {};
+};
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPTraversability.generated.h"
+
+/** Top of a piece of static collision in a grid cell. */
+struct FFPTraversabilitySurface
+{
+	float Z = 0.0f;
+
+	/** Free height above the surface in cm, up to the next static collision or the bake's clearance cap. */
+	uint16 Clearance = 0;
+
+	/** Surface normal Z, 0-255. */
+	uint8 NormalZ = 0;
+
+	uint8 Padding = 0;
+
+	float GetNormalZ() const { return NormalZ / 255.0f; }
+
+	float GetTopOfClearance() const { return Z + Clearance; }
+
+	friend FArchive& operator<<(FArchive& Ar, FFPTraversabilitySurface& Surface)
+	{
+		return Ar << Surface.Z << Surface.Clearance << Surface.NormalZ << Surface.Padding;
+	}
+};
+
+/**
+ * Walkable tops of a level's static collision, sampled on a 2D grid, so StepUp can resolve static steps without sweeping.
+ * A step edge is wherever neighbouring cells' surfaces differ in height. Baked by -run=FPTraversabilityBake into
+ * /Game/Traversability/<Map>_Traversability, which UFPTraversabilitySubsystem loads for the map.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPTraversabilityData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Serialize(FArchive& Ar) override;
+
+	/** Surfaces in the cell containing Location, highest first. Empty outside the baked bounds. */
+	TArrayView<const FFPTraversabilitySurface> GetSurfaces(const FVector& Location) const;
+
+	/** Center of the cell containing Location. */
+	FVector GetCellCenter(const FVector& Location) const;
+
+	float GetCellSize() const { return CellSize; }
+
+	int32 GetNumCells() const { return NumCellsX * NumCellsY; }
+
+	int32 GetNumSurfaces() const { return Surfaces.Num(); }
+
+	SIZE_T GetDataSize() const { return CellStarts.GetAllocatedSize() + Surfaces.GetAllocatedSize(); }
+
+	/**
+	 * Trace World's static collision within Bounds down every cell, and keep the tops of everything hit, up to MaxSurfacesPerCell per cell.
+	 * Traces use Capsule's collision channel and responses, so the bake sees what the capsule collides with.
+	 */
+	void Bake(UWorld* World, const FBox& Bounds, const UPrimitiveComponent& Capsule, float InCellSize, int32 MaxSurfacesPerCell = 4);
+
+	/** Where the bake of World is saved and loaded from. */
+	static FString GetAssetPath(const UWorld* World);
+
+	/** Union of the bounds of the static primitives in World that block Capsule. */
+	static FBox GetStaticCollisionBounds(UWorld* World, const UPrimitiveComponent& Capsule);
+
+protected:
+
+	int32 GetCellIndex(int32 CellX, int32 CellY) const { return CellY * NumCellsX + CellX; }
+
+	/** Min corner of the grid. */
+	UPROPERTY(VisibleAnywhere, Category = "Traversability")
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, Category = "Traversability")
+	float CellSize = 20.0f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Traversability")
+	int32 NumCellsX = 0;
+
+	UPROPERTY(VisibleAnywhere, Category = "Traversability")
+	int32 NumCellsY = 0;
+
+	/** Surfaces of cell N are Surfaces[CellStarts[N], CellStarts[N + 1]). Bulk serialized in Serialize. */
+	TArray<int32> CellStarts;
+
+	TArray<FFPTraversabilitySurface> Surfaces;
+};
+
+/** Loads the map's traversability bake, and counts what it saves. */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPTraversabilitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** The bake, or null if the map has none or FPMovement.Traversability is off. */
+	const UFPTraversabilityData* GetData() const;
+
+	/** Called by StepUp when it tried the bake, with whether the bake resolved the step. */
+	void RecordStepUp(bool bResolvedFromBake);
+
+	void LogReport() const;
+
+	/**
+	 * Estimate of the sweeps a baked step up saves: the up and down sweeps of the regular StepUp, which the baked one replaces with
+	 * an overlap test and a line trace. Not measured, since the skipped StepUp never runs, and it can make more queries than that.
+	 */
+	static constexpr int32 SweepsSavedPerStepUp = 2;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	UPROPERTY(Transient)
+	UFPTraversabilityData* Data = nullptr;
+
+	uint64 NumBakedStepUps = 0;
+
+	uint64 NumFallbackStepUps = 0;
+
+	double BeginPlayTime = 0.0;
+};
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FPTraversabilityBakeCommandlet.generated.h"
+
+/**
+ * Bakes a map's static collision into a UFPTraversabilityData asset.
+ *     UnrealEditor-Cmd FirstPersonProj.uproject -run=FPTraversabilityBake [-Map=/Game/FirstPerson/Maps/FirstPersonMap] [-CellSize=20]
+ * Rebake whenever the map's static geometry changes.
+ */
+UCLASS()
+class FIRSTPERSONPROJ_API UFPTraversabilityBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	UFPTraversabilityBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPViewmodel, Log, All);
+
+/** What the first person arms' pose depends on, all relative to the pawn. */
+struct FFPViewmodelInputs
+{
+	FVector CameraLocation = FVector::ZeroVector;
+
+	/** Camera yaw relative to the pawn, without its pitch. */
+	FQuat CameraYaw = FQuat::Identity;
+
+	float CameraPitch = 0.0f;
+
+	/** Rest pose of the arms relative to the pawn, lowered by crouching. */
+	FVector MeshTranslation = FVector::ZeroVector;
+
+	FQuat MeshRotation = FQuat::Identity;
+
+	/** Inputs from the camera's world pose and the pawn's. */
+	static FFPViewmodelInputs Make(const FTransform& ActorToWorld, const FVector& CameraLocation, const FRotator& CameraRotation, const FVector& MeshTranslation, const FQuat& MeshRotation);
+
+	bool Equals(const FFPViewmodelInputs& Other) const;
+};
+
+/**
+ * Poses the first person arms so they pitch with the camera around the camera's position, working in quaternions.
+ * Only solves again when the inputs change, so a still camera costs a comparison.
+ */
+struct FIRSTPERSONPROJ_API FFPViewmodelSolver
+{
+	/** Arms transform relative to the pawn. */
+	static FTransform Solve(const FFPViewmodelInputs& Inputs);
+
+	/** The same pose built from matrices, as OnCameraUpdate used to. For FPViewmodel.Benchmark. */
+	static FTransform SolveWithMatrices(const FTransform& ActorToWorld, const FVector& CameraLocation, const FRotator& CameraRotation, const FVector& MeshTranslation, const FQuat& MeshRotation);
+
+	/** Solve if Inputs differ from the last update's. Returns false, leaving OutRelativeTransform alone, if the pose is unchanged. */
+	bool Update(const FFPViewmodelInputs& Inputs, FTransform& OutRelativeTransform);
+
+private:
+
+	FFPViewmodelInputs LastInputs;
+
+	bool bHasLastInputs = false;
+};
@@ -4,6 +4,7 @@
 #include "TP_WeaponComponent.h"
 #include "FirstPersonProjCharacter.h"
 #include "FirstPersonProjProjectile.h"
+#include "FPProjectilePool.h"
 #include "GameFramework/PlayerController.h"
 #include "Camera/PlayerCameraManager.h"
 #include "Kismet/GameplayStatics.h"
@@ -35,13 +36,24 @@ void UTP_WeaponComponent::Fire()
 			const FRotator SpawnRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
 			// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
 			const FVector SpawnLocation = GetOwner()->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
+
+			// The projectile below is only what this client sees. The server decides what the shot hit.
+			Character->ServerFire(SpawnRotation.Vector());
 	
-			//Set Spawn Collision Handling Override
-			FActorSpawnParameters ActorSpawnParams;
-			ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
-	
-			// Spawn the projectile at the muzzle
-			World->SpawnActor<AFirstPersonProjProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+			// Fire a pooled projectile from the muzzle, or spawn one if none is waiting
+			if (UFPProjectilePoolSubsystem* ProjectilePool = World->GetSubsystem<UFPProjectilePoolSubsystem>())
+			{
+				ProjectilePool->Acquire(ProjectileClass, SpawnLocation, SpawnRotation, GetOwner(), Character);
+			}
+			else
+			{
+				//Set Spawn Collision Handling Override
+				FActorSpawnParameters ActorSpawnParams;
+				ActorSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButDontSpawnIfColliding;
+
+				// Spawn the projectile at the muzzle
+				World->SpawnActor<AFirstPersonProjProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, ActorSpawnParams);
+			}
 		}
 	}
 	
@@ -78,6 +90,11 @@ void UTP_WeaponComponent::AttachWeapon(AFirstPersonProjCharacter* TargetCharacte
 	// switch bHasRifle so the animation blueprint can switch to another animation set
 	Character->SetHasRifle(true);
 
+	if (UFPProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UFPProjectilePoolSubsystem>())
+	{
+		ProjectilePool->Prewarm(ProjectileClass, NumPrewarmedProjectiles);
+	}
+
 	// Set up action bindings
 	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
@@ -26,6 +26,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
 	UAnimMontage* FireAnimation;
 
+	/** Projectiles of ProjectileClass spawned into the world's projectile pool when the weapon is attached, so firing doesn't spawn. */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(ClampMin = "0", UIMin = "0"))
+	int32 NumPrewarmedProjectiles = 32;
+
 	/** Gun muzzle's offset from the characters location */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
 	FVector MuzzleOffset;
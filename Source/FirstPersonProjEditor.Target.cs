@@ -10,6 +10,6 @@ public class FirstPersonProjEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
-		ExtraModuleNames.Add("FirstPersonProj");
+		ExtraModuleNames.AddRange(new string[] { "FirstPersonProj", "FirstPersonProjMovementCore" });
 	}
 }
@@ -0,0 +1,318 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementCore.h"
+#include "FPMovementCoreBatch.h"
+
+DEFINE_LOG_CATEGORY(LogFPMovementCore);
+
+void FPMovementCore::CalculateGroundVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FVector& InputVector, float DeltaTime)
+{
+	FVector& Velocity = State.Velocity;
+	if (InputVector.IsNearlyZero() && Velocity.IsNearlyZero())
+	{
+		return;
+	}
+
+	const float PreviousVelocity2D = Velocity.Size2D();
+	const float CurrentMaxGroundSpeed = FMath::Lerp(State.bIsSprinting ? Tunables.MaxSprintSpeed : Tunables.MaxWalkSpeed, Tunables.MaxSpeedCrouched, State.CrouchFrac);
+	const FVector TargetVelocity = InputVector.GetSafeNormal2D() * CurrentMaxGroundSpeed;
+	FVector AccelerationVec = TargetVelocity - Velocity;
+	const bool bIsDecelerating = InputVector.IsNearlyZero() || TargetVelocity.SizeSquared2D() < (PreviousVelocity2D * PreviousVelocity2D);
+
+	if (AccelerationVec.IsNearlyZero())
+	{
+		return;
+	}
+
+	float AccelerationToUse = Tunables.WalkAcceleration;
+	if (bIsDecelerating)
+	{
+		AccelerationToUse = Tunables.BrakingDecelerationWalking;
+	}
+	else
+	{
+		Velocity = Velocity - (Velocity - AccelerationVec.GetSafeNormal2D() * Velocity.Size2D()) * DeltaTime;
+		AccelerationVec = TargetVelocity - Velocity;
+	}
+	AccelerationToUse *= DeltaTime;
+
+	// Prevent new velocity from exceeding desired velocity.
+	FVector VelocityDelta = (AccelerationVec.GetSafeNormal2D() * AccelerationToUse);
+	if (VelocityDelta.SizeSquared2D() > AccelerationVec.SizeSquared2D())
+	{
+		VelocityDelta *= AccelerationVec.Size2D() / VelocityDelta.Size2D();
+	}
+	Velocity += VelocityDelta;
+}
+
+void FPMovementCore::CalculateFallVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FFPFallContext& Context, const FVector& InputVector, float DeltaTime)
+{
+	FVector& Velocity = State.Velocity;
+	const FVector& ForwardVector = Context.ForwardVector;
+	const FVector& RightVector = Context.RightVector;
+	const FVector LateralInputVector = InputVector.ProjectOnTo(RightVector);
+
+	FVector ForwardVelocity = Velocity.ProjectOnToNormal(ForwardVector);
+	FVector LateralVelocity = Velocity.ProjectOnToNormal(RightVector);
+
+	float MaxForwardAirVelocity = FMath::Min(Tunables.MaxAirSpeed, FMath::Max(State.InitialJumpVelocity.Size2D(), Tunables.MaxAirSpeed * .20f));
+	FVector TargetForwardVelocity = InputVector.IsNearlyZero() ? ForwardVelocity : InputVector.ProjectOnToNormal(ForwardVector) * MaxForwardAirVelocity;
+
+	FVector InputLateralTargetVelocity = LateralInputVector * Tunables.MaxAirStrafe;
+	FVector TargetLateralVelocity = InputVector.IsNearlyZero() ? LateralVelocity : FMath::Max(InputLateralTargetVelocity.Size(), LateralVelocity.Size()) * InputLateralTargetVelocity.GetSafeNormal2D();
+
+	const FVector TargetVelocity = TargetForwardVelocity + TargetLateralVelocity + (FVector::DownVector * Context.TerminalVelocity);
+	FVector Acceleration = TargetVelocity - Velocity;
+
+	FVector ForwardAcceleration = Acceleration.ProjectOnToNormal(ForwardVector);
+	const float ForwardAccelerationDot = ForwardAcceleration.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
+	if (ForwardAccelerationDot <= -.1f)
+	{
+		ForwardAcceleration = ForwardAcceleration.GetSafeNormal2D() * Tunables.AirBrakingDeceleration * -ForwardAccelerationDot;
+	}
+	else
+	{
+		// Increase acceleration if the player is providing lateral input in the direction they want to turn in the air.
+		// Start by checking how orthogonal the forward vector and velocity are. The more orthogonal, the more the player has to turn.
+		// Scale this value by the dot product between the initial jump vector and the input. This is to ensure the player is inputting the correct direction into the turn.
+		const float TurnAccelerationScalar = (ForwardVector ^ Velocity.GetSafeNormal2D()).Size() * FMath::Max(0.0f, State.InitialJumpVelocity.GetSafeNormal2D() | -LateralInputVector);
+		const float ForwardAirAcceleration = Tunables.AirAcceleration * FMath::Lerp(1.0f, 3.0f, TurnAccelerationScalar);
+		ForwardAcceleration = ForwardAcceleration.GetSafeNormal2D() * ForwardAirAcceleration;
+	}
+
+	FVector LateralAcceleration = Acceleration.ProjectOnToNormal(RightVector);
+	const float LateralAccelerationDot = LateralAcceleration.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
+	if (LateralAccelerationDot <= -.1f)
+	{
+		LateralAcceleration = LateralAcceleration.GetSafeNormal2D() * Tunables.AirBrakingDeceleration * -LateralAccelerationDot;
+	}
+	else
+	{
+		LateralAcceleration = LateralAcceleration.GetSafeNormal2D() * Tunables.AirAcceleration;
+	}
+
+	FVector VelocityDelta = LateralAcceleration + ForwardAcceleration;
+
+	// Subtract the deceleration vector from the velocity to allow the player to change directions.
+	// Scale by friction.
+	if (!Acceleration.GetSafeNormal2D().IsNearlyZero())
+	{
+		const FVector Velocity2D = FVector(Velocity.X, Velocity.Y, 0);
+		Velocity = Velocity - (Velocity2D - VelocityDelta.GetSafeNormal2D() * Velocity2D.Size()) * DeltaTime * Tunables.AirFrictionFactor;
+		Acceleration = TargetVelocity - Velocity;
+	}
+
+	if (VelocityDelta.Size2D() > Acceleration.Size2D())
+	{
+		VelocityDelta *= Acceleration.Size2D() / VelocityDelta.Size2D();
+	}
+
+	VelocityDelta.Z = Context.GravityZ;
+	VelocityDelta *= DeltaTime;
+
+	Velocity += VelocityDelta;
+	Velocity.Z = FMath::Max(Velocity.Z, -Context.TerminalVelocity);
+}
+
+void FPMovementCore::CalculateSlideVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FVector& FloorNormal, const FVector& InputVector, float DeltaTime, FVector& OutGravitationalAccelVec)
+{
+	FVector& Velocity = State.Velocity;
+	const FVector GravityAccelerationDirection = FVector::VectorPlaneProject(FVector::DownVector, FloorNormal).GetSafeNormal();
+	const float GravityAccelerationRatio = (1.0f - FloorNormal.Z) / (1.0f - Tunables.SlideFloorZ);
+	OutGravitationalAccelVec = GravityAccelerationDirection * Tunables.SlideGravityAcceleration * GravityAccelerationRatio;
+
+	FVector SlideFrictionAccelerationVector = FVector::ZeroVector;
+	const float VelocityGravityDot = GravityAccelerationDirection | Velocity.GetSafeNormal();
+	// If we are moving perpindicular to the gravity vector, apply slide friction.
+	if (FMath::Abs(VelocityGravityDot) <= .1f)
+	{
+		SlideFrictionAccelerationVector = -Velocity.GetSafeNormal2D() * Velocity.Size2D() * Tunables.SlideFrictionFactor * (1.0f - GravityAccelerationRatio);
+	}
+
+	// Consider slide input deceleration.
+	FVector InputAcceleration = FVector::ZeroVector;
+
+	const float InputVelocityDot = Velocity.GetSafeNormal2D() | InputVector.GetSafeNormal2D();
+	if (InputVelocityDot <= -.45f)
+	{
+		InputAcceleration += Velocity.GetSafeNormal() * InputVelocityDot * Tunables.SlideBrakingDeceleration;
+	}
+
+	const FVector FinalAcceleration = (OutGravitationalAccelVec + SlideFrictionAccelerationVector + InputAcceleration) * DeltaTime;
+
+	Velocity += FinalAcceleration;
+}
+
+void FPMovementCore::RunKernel(FFPMovementKernelJob& Job, const FFPMovementTunables& Tunables)
+{
+	Job.Result = Job.State;
+	switch (Job.Kernel)
+	{
+		case EFPMovementKernel::Ground:
+			CalculateGroundVelocity(Job.Result, Tunables, Job.InputVector, Job.DeltaTime);
+			break;
+		case EFPMovementKernel::Fall:
+			CalculateFallVelocity(Job.Result, Tunables, Job.FallContext, Job.InputVector, Job.DeltaTime);
+			break;
+		case EFPMovementKernel::Slide:
+			CalculateSlideVelocity(Job.Result, Tunables, Job.FloorNormal, Job.InputVector, Job.DeltaTime, Job.GravitationalAccel);
+			break;
+	}
+}
+
+bool FFPMovementKernelJob::HasSameInputs(const FFPMovementKernelJob& Other) const
+{
+	if (Kernel != Other.Kernel || DeltaTime != Other.DeltaTime || InputVector != Other.InputVector)
+	{
+		return false;
+	}
+
+	if (State.Velocity != Other.State.Velocity || State.InitialJumpVelocity != Other.State.InitialJumpVelocity
+		|| State.CrouchFrac != Other.State.CrouchFrac || State.bIsSprinting != Other.State.bIsSprinting)
+	{
+		return false;
+	}
+
+	switch (Kernel)
+	{
+		case EFPMovementKernel::Fall:
+			return FallContext.ForwardVector == Other.FallContext.ForwardVector && FallContext.RightVector == Other.FallContext.RightVector
+				&& FallContext.GravityZ == Other.FallContext.GravityZ && FallContext.TerminalVelocity == Other.FallContext.TerminalVelocity;
+		case EFPMovementKernel::Slide:
+			return FloorNormal == Other.FloorNormal;
+		default:
+			return true;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace FPMovementCoreBenchmark
+{
+	static const TCHAR* KernelName(EFPMovementKernel Kernel)
+	{
+		switch (Kernel)
+		{
+			case EFPMovementKernel::Ground:
+				return TEXT("Ground");
+			case EFPMovementKernel::Fall:
+				return TEXT("Fall");
+			default:
+				return TEXT("Slide");
+		}
+	}
+
+	static FFPMovementKernelJob MakeRandomJob(EFPMovementKernel Kernel, FRandomStream& RandomStream)
+	{
+		FFPMovementKernelJob Job;
+		Job.Kernel = Kernel;
+		Job.DeltaTime = RandomStream.FRandRange(1.0f / 120.0f, 1.0f / 30.0f);
+		Job.InputVector = RandomStream.FRand() < .25f ? FVector::ZeroVector : FVector(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f), 0.0f);
+		Job.State.Velocity = FVector(RandomStream.FRandRange(-900.0f, 900.0f), RandomStream.FRandRange(-900.0f, 900.0f), Kernel == EFPMovementKernel::Ground ? 0.0f : RandomStream.FRandRange(-600.0f, 400.0f));
+		Job.State.InitialJumpVelocity = FVector(RandomStream.FRandRange(-700.0f, 700.0f), RandomStream.FRandRange(-700.0f, 700.0f), 0.0f);
+		Job.State.CrouchFrac = RandomStream.FRand();
+		Job.State.bIsSprinting = RandomStream.FRand() < .5f;
+
+		const float Yaw = RandomStream.FRandRange(0.0f, 2.0f * UE_PI);
+		Job.FallContext.ForwardVector = FVector(FMath::Cos(Yaw), FMath::Sin(Yaw), 0.0f);
+		Job.FallContext.RightVector = FVector(-FMath::Sin(Yaw), FMath::Cos(Yaw), 0.0f);
+		Job.FloorNormal = FVector(RandomStream.FRandRange(-.8f, .8f), RandomStream.FRandRange(-.8f, .8f), 1.0f).GetSafeNormal();
+		return Job;
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 NumSteps = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000000;
+
+		// Run over a small pool of pre-generated inputs so the loop doesn't measure the random number generator.
+		constexpr int32 NumSamples = 1024;
+		FRandomStream RandomStream(0x4650);
+		TArray<FVector> Inputs;
+		TArray<FVector> Normals;
+		Inputs.SetNumUninitialized(NumSamples);
+		Normals.SetNumUninitialized(NumSamples);
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			Inputs[Index] = FVector(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f), 0.0f);
+			Normals[Index] = FVector(RandomStream.FRandRange(-.5f, .5f), RandomStream.FRandRange(-.5f, .5f), 1.0f).GetSafeNormal();
+		}
+
+		const FFPMovementTunables Tunables;
+		const FFPFallContext FallContext;
+		const float DeltaTime = 1.0f / 60.0f;
+
+		auto Report = [NumSteps](const TCHAR* KernelName, double StartTime, const FFPMovementState& State)
+		{
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			UE_LOG(LogFPMovementCore, Display, TEXT("%s: %d steps in %.3f ms, %.2f M steps/s, %.1f ns/step (final speed %.1f)"),
+				KernelName, NumSteps, Elapsed * 1000.0, (NumSteps / Elapsed) / 1000000.0, (Elapsed * 1000000000.0) / NumSteps, State.Velocity.Size());
+		};
+
+		{
+			FFPMovementState State;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				FPMovementCore::CalculateGroundVelocity(State, Tunables, Inputs[Step & (NumSamples - 1)], DeltaTime);
+			}
+			Report(TEXT("Ground"), StartTime, State);
+		}
+
+		{
+			FFPMovementState State;
+			State.InitialJumpVelocity = FVector(400.0f, 0.0f, 0.0f);
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				FPMovementCore::CalculateFallVelocity(State, Tunables, FallContext, Inputs[Step & (NumSamples - 1)], DeltaTime);
+			}
+			Report(TEXT("Fall"), StartTime, State);
+		}
+
+		{
+			FFPMovementState State;
+			FVector GravitationalAcceleration;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Step = 0; Step < NumSteps; ++Step)
+			{
+				const int32 SampleIndex = Step & (NumSamples - 1);
+				FPMovementCore::CalculateSlideVelocity(State, Tunables, Normals[SampleIndex], Inputs[SampleIndex], DeltaTime, GravitationalAcceleration);
+			}
+			Report(TEXT("Slide"), StartTime, State);
+		}
+
+		// Batched SIMD kernels, run over a pawn sized batch of random jobs.
+		FFPMovementTunables BatchTunables;
+		BatchTunables.MaxAirStrafe = 400.0f;
+		BatchTunables.AirAcceleration = 600.0f;
+		const int32 NumPasses = FMath::Max(1, NumSteps / NumSamples);
+		for (const EFPMovementKernel Kernel : { EFPMovementKernel::Ground, EFPMovementKernel::Fall, EFPMovementKernel::Slide })
+		{
+			FFPMovementKernelBatch Batch;
+			Batch.Reset(Kernel, NumSamples);
+			for (int32 Index = 0; Index < NumSamples; ++Index)
+			{
+				Batch.Gather(Index, MakeRandomJob(Kernel, RandomStream), BatchTunables);
+			}
+			Batch.FinalizeGather();
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+			{
+				FPMovementCore::RunKernelBatch(Batch);
+			}
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			const int32 NumBatchSteps = NumPasses * NumSamples;
+			UE_LOG(LogFPMovementCore, Display, TEXT("%s batch: %d steps in %.3f ms, %.2f M steps/s, %.1f ns/step"),
+				KernelName(Kernel), NumBatchSteps, Elapsed * 1000.0, (NumBatchSteps / Elapsed) / 1000000.0, (Elapsed * 1000000000.0) / NumBatchSteps);
+		}
+	}
+
+	static FAutoConsoleCommand BenchmarkCommand(
+		TEXT("FPMovementCore.Benchmark"),
+		TEXT("Runs the scalar and batched ground, fall and slide velocity kernels headless and logs their throughput. Usage: FPMovementCore.Benchmark [NumSteps]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&Run));
+}
+
+#endif // !UE_BUILD_SHIPPING
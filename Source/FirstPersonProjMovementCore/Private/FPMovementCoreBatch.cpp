@@ -0,0 +1,409 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementCoreBatch.h"
+#include "Math/VectorRegister.h"
+
+void FFPMovementKernelBatch::Reset(EFPMovementKernel InKernel, int32 InNumJobs)
+{
+	Kernel = InKernel;
+	NumJobs = InNumJobs;
+	PaddedNum = Align(InNumJobs, LaneWidth);
+	Data.SetNumUninitialized(PaddedNum * NumStreams, false);
+}
+
+void FFPMovementKernelBatch::Gather(int32 Index, const FFPMovementKernelJob& Job, const FFPMovementTunables& Tunables)
+{
+	check(Index >= 0 && Index < NumJobs);
+
+	auto Write = [this, Index](EStream Stream, double Value)
+	{
+		GetStream(Stream)[Index] = static_cast<float>(Value);
+	};
+
+	const FFPMovementState& State = Job.State;
+	Write(VelocityX, State.Velocity.X);
+	Write(VelocityY, State.Velocity.Y);
+	Write(VelocityZ, State.Velocity.Z);
+	Write(InputX, Job.InputVector.X);
+	Write(InputY, Job.InputVector.Y);
+	Write(InputZ, Job.InputVector.Z);
+	Write(DeltaTime, Job.DeltaTime);
+
+	switch (Kernel)
+	{
+		case EFPMovementKernel::Ground:
+			Write(MaxGroundSpeed, FMath::Lerp(State.bIsSprinting ? Tunables.MaxSprintSpeed : Tunables.MaxWalkSpeed, Tunables.MaxSpeedCrouched, State.CrouchFrac));
+			Write(WalkAcceleration, Tunables.WalkAcceleration);
+			Write(BrakingDeceleration, Tunables.BrakingDecelerationWalking);
+			break;
+		case EFPMovementKernel::Fall:
+			Write(ForwardX, Job.FallContext.ForwardVector.X);
+			Write(ForwardY, Job.FallContext.ForwardVector.Y);
+			Write(ForwardZ, Job.FallContext.ForwardVector.Z);
+			Write(RightX, Job.FallContext.RightVector.X);
+			Write(RightY, Job.FallContext.RightVector.Y);
+			Write(RightZ, Job.FallContext.RightVector.Z);
+			Write(InitialJumpX, State.InitialJumpVelocity.X);
+			Write(InitialJumpY, State.InitialJumpVelocity.Y);
+			Write(InitialJumpZ, State.InitialJumpVelocity.Z);
+			Write(MaxAirSpeed, Tunables.MaxAirSpeed);
+			Write(MaxAirStrafe, Tunables.MaxAirStrafe);
+			Write(AirAcceleration, Tunables.AirAcceleration);
+			Write(AirBrakingDeceleration, Tunables.AirBrakingDeceleration);
+			Write(AirFrictionFactor, Tunables.AirFrictionFactor);
+			Write(GravityZ, Job.FallContext.GravityZ);
+			Write(TerminalVelocity, Job.FallContext.TerminalVelocity);
+			break;
+		case EFPMovementKernel::Slide:
+			Write(FloorNormalX, Job.FloorNormal.X);
+			Write(FloorNormalY, Job.FloorNormal.Y);
+			Write(FloorNormalZ, Job.FloorNormal.Z);
+			Write(SlideFrictionFactor, Tunables.SlideFrictionFactor);
+			Write(SlideBrakingDeceleration, Tunables.SlideBrakingDeceleration);
+			Write(SlideGravityAcceleration, Tunables.SlideGravityAcceleration);
+			Write(SlideFloorZ, Tunables.SlideFloorZ);
+			break;
+	}
+}
+
+void FFPMovementKernelBatch::FinalizeGather()
+{
+	if (NumJobs == 0)
+	{
+		return;
+	}
+
+	// Replicate the last job into the padding lanes so they can't produce NaNs or denormals.
+	for (int32 Stream = 0; Stream < NumStreams; ++Stream)
+	{
+		float* StreamData = GetStream(static_cast<EStream>(Stream));
+		for (int32 Index = NumJobs; Index < PaddedNum; ++Index)
+		{
+			StreamData[Index] = StreamData[NumJobs - 1];
+		}
+	}
+}
+
+void FFPMovementKernelBatch::Scatter(int32 Index, FFPMovementKernelJob& Job) const
+{
+	check(Index >= 0 && Index < NumJobs);
+
+	Job.Result = Job.State;
+	Job.Result.Velocity = FVector(GetStream(VelocityX)[Index], GetStream(VelocityY)[Index], GetStream(VelocityZ)[Index]);
+	if (Kernel == EFPMovementKernel::Slide)
+	{
+		Job.GravitationalAccel = FVector(GetStream(GravAccelX)[Index], GetStream(GravAccelY)[Index], GetStream(GravAccelZ)[Index]);
+	}
+}
+
+namespace FPMovementCoreBatch
+{
+	typedef VectorRegister4Float FReg;
+
+	/** Three registers holding one vector component each for four lanes. */
+	struct FVec3x4
+	{
+		FReg X;
+		FReg Y;
+		FReg Z;
+	};
+
+	FORCEINLINE FReg Splat(float Value)
+	{
+		return VectorSetFloat1(Value);
+	}
+
+	FORCEINLINE FVec3x4 Load3(const FFPMovementKernelBatch& Batch, FFPMovementKernelBatch::EStream StreamX, int32 Lane)
+	{
+		return {
+			VectorLoadAligned(Batch.GetStream(StreamX) + Lane),
+			VectorLoadAligned(Batch.GetStream(static_cast<FFPMovementKernelBatch::EStream>(StreamX + 1)) + Lane),
+			VectorLoadAligned(Batch.GetStream(static_cast<FFPMovementKernelBatch::EStream>(StreamX + 2)) + Lane)
+		};
+	}
+
+	FORCEINLINE void Store3(FFPMovementKernelBatch& Batch, FFPMovementKernelBatch::EStream StreamX, int32 Lane, const FVec3x4& Value)
+	{
+		VectorStoreAligned(Value.X, Batch.GetStream(StreamX) + Lane);
+		VectorStoreAligned(Value.Y, Batch.GetStream(static_cast<FFPMovementKernelBatch::EStream>(StreamX + 1)) + Lane);
+		VectorStoreAligned(Value.Z, Batch.GetStream(static_cast<FFPMovementKernelBatch::EStream>(StreamX + 2)) + Lane);
+	}
+
+	FORCEINLINE FReg Load1(const FFPMovementKernelBatch& Batch, FFPMovementKernelBatch::EStream Stream, int32 Lane)
+	{
+		return VectorLoadAligned(Batch.GetStream(Stream) + Lane);
+	}
+
+	FORCEINLINE FVec3x4 Add(const FVec3x4& A, const FVec3x4& B)
+	{
+		return { VectorAdd(A.X, B.X), VectorAdd(A.Y, B.Y), VectorAdd(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVec3x4 Sub(const FVec3x4& A, const FVec3x4& B)
+	{
+		return { VectorSubtract(A.X, B.X), VectorSubtract(A.Y, B.Y), VectorSubtract(A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVec3x4 Scale(const FVec3x4& A, const FReg& S)
+	{
+		return { VectorMultiply(A.X, S), VectorMultiply(A.Y, S), VectorMultiply(A.Z, S) };
+	}
+
+	FORCEINLINE FVec3x4 Negate(const FVec3x4& A)
+	{
+		return { VectorNegate(A.X), VectorNegate(A.Y), VectorNegate(A.Z) };
+	}
+
+	FORCEINLINE FVec3x4 Select(const FReg& Mask, const FVec3x4& A, const FVec3x4& B)
+	{
+		return { VectorSelect(Mask, A.X, B.X), VectorSelect(Mask, A.Y, B.Y), VectorSelect(Mask, A.Z, B.Z) };
+	}
+
+	FORCEINLINE FVec3x4 Zero3()
+	{
+		const FReg Zero = VectorZeroFloat();
+		return { Zero, Zero, Zero };
+	}
+
+	FORCEINLINE FReg Dot3(const FVec3x4& A, const FVec3x4& B)
+	{
+		return VectorMultiplyAdd(A.Z, B.Z, VectorMultiplyAdd(A.Y, B.Y, VectorMultiply(A.X, B.X)));
+	}
+
+	FORCEINLINE FReg SizeSquared2D(const FVec3x4& A)
+	{
+		return VectorMultiplyAdd(A.Y, A.Y, VectorMultiply(A.X, A.X));
+	}
+
+	FORCEINLINE FReg Size2D(const FVec3x4& A)
+	{
+		return VectorSqrt(SizeSquared2D(A));
+	}
+
+	FORCEINLINE FReg Size(const FVec3x4& A)
+	{
+		return VectorSqrt(Dot3(A, A));
+	}
+
+	FORCEINLINE FVec3x4 Cross(const FVec3x4& A, const FVec3x4& B)
+	{
+		return {
+			VectorSubtract(VectorMultiply(A.Y, B.Z), VectorMultiply(A.Z, B.Y)),
+			VectorSubtract(VectorMultiply(A.Z, B.X), VectorMultiply(A.X, B.Z)),
+			VectorSubtract(VectorMultiply(A.X, B.Y), VectorMultiply(A.Y, B.X))
+		};
+	}
+
+	/** Matches FVector::GetSafeNormal2D: zero if the 2D size is below UE_SMALL_NUMBER. */
+	FORCEINLINE FVec3x4 SafeNormal2D(const FVec3x4& A)
+	{
+		const FReg SizeSq = SizeSquared2D(A);
+		const FReg InvSize = VectorDivide(Splat(1.0f), VectorSqrt(VectorMax(SizeSq, Splat(UE_SMALL_NUMBER))));
+		const FReg Valid = VectorCompareGE(SizeSq, Splat(UE_SMALL_NUMBER));
+		const FReg Zero = VectorZeroFloat();
+		return { VectorSelect(Valid, VectorMultiply(A.X, InvSize), Zero), VectorSelect(Valid, VectorMultiply(A.Y, InvSize), Zero), Zero };
+	}
+
+	/** Matches FVector::GetSafeNormal: zero if the size is below UE_SMALL_NUMBER. */
+	FORCEINLINE FVec3x4 SafeNormal(const FVec3x4& A)
+	{
+		const FReg SizeSq = Dot3(A, A);
+		const FReg InvSize = VectorDivide(Splat(1.0f), VectorSqrt(VectorMax(SizeSq, Splat(UE_SMALL_NUMBER))));
+		const FReg Valid = VectorCompareGE(SizeSq, Splat(UE_SMALL_NUMBER));
+		return Select(Valid, Scale(A, InvSize), Zero3());
+	}
+
+	/** Matches FVector::IsNearlyZero with the default tolerance. Returns a lane mask. */
+	FORCEINLINE FReg IsNearlyZero(const FVec3x4& A)
+	{
+		const FReg Tolerance = Splat(UE_KINDA_SMALL_NUMBER);
+		return VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareLE(VectorAbs(A.X), Tolerance), VectorCompareLE(VectorAbs(A.Y), Tolerance)), VectorCompareLE(VectorAbs(A.Z), Tolerance));
+	}
+
+	FORCEINLINE FVec3x4 ProjectOnToNormal(const FVec3x4& A, const FVec3x4& Normal)
+	{
+		return Scale(Normal, Dot3(A, Normal));
+	}
+
+	FORCEINLINE FVec3x4 ProjectOnTo(const FVec3x4& A, const FVec3x4& Target)
+	{
+		return Scale(Target, VectorDivide(Dot3(A, Target), Dot3(Target, Target)));
+	}
+
+	/** Scale A by Numerator / Denominator in the lanes where Mask is set. */
+	FORCEINLINE FVec3x4 ScaleWhere(const FReg& Mask, const FVec3x4& A, const FReg& Numerator, const FReg& Denominator)
+	{
+		const FReg SafeDenominator = VectorSelect(Mask, Denominator, Splat(1.0f));
+		return Select(Mask, Scale(A, VectorDivide(Numerator, SafeDenominator)), A);
+	}
+
+	static void GroundKernel(FFPMovementKernelBatch& Batch, int32 Lane)
+	{
+		typedef FFPMovementKernelBatch B;
+
+		const FVec3x4 Velocity = Load3(Batch, B::VelocityX, Lane);
+		const FVec3x4 Input = Load3(Batch, B::InputX, Lane);
+		const FReg DeltaTime = Load1(Batch, B::DeltaTime, Lane);
+
+		const FReg InputIsZero = IsNearlyZero(Input);
+		const FReg SkipNoMotion = VectorBitwiseAnd(InputIsZero, IsNearlyZero(Velocity));
+
+		const FReg PreviousVelocity2D = Size2D(Velocity);
+		const FVec3x4 TargetVelocity = Scale(SafeNormal2D(Input), Load1(Batch, B::MaxGroundSpeed, Lane));
+		const FVec3x4 AccelerationVec = Sub(TargetVelocity, Velocity);
+		const FReg bIsDecelerating = VectorBitwiseOr(InputIsZero, VectorCompareLT(SizeSquared2D(TargetVelocity), VectorMultiply(PreviousVelocity2D, PreviousVelocity2D)));
+		const FReg SkipNoAcceleration = IsNearlyZero(AccelerationVec);
+
+		// When accelerating, turn the current velocity towards the acceleration direction first.
+		const FVec3x4 TurnedVelocity = Sub(Velocity, Scale(Sub(Velocity, Scale(SafeNormal2D(AccelerationVec), PreviousVelocity2D)), DeltaTime));
+		const FVec3x4 NewVelocity = Select(bIsDecelerating, Velocity, TurnedVelocity);
+		const FVec3x4 NewAccelerationVec = Select(bIsDecelerating, AccelerationVec, Sub(TargetVelocity, TurnedVelocity));
+
+		const FReg AccelerationToUse = VectorMultiply(VectorSelect(bIsDecelerating, Load1(Batch, B::BrakingDeceleration, Lane), Load1(Batch, B::WalkAcceleration, Lane)), DeltaTime);
+
+		// Prevent new velocity from exceeding desired velocity.
+		FVec3x4 VelocityDelta = Scale(SafeNormal2D(NewAccelerationVec), AccelerationToUse);
+		const FReg ClampMask = VectorCompareGT(SizeSquared2D(VelocityDelta), SizeSquared2D(NewAccelerationVec));
+		VelocityDelta = ScaleWhere(ClampMask, VelocityDelta, Size2D(NewAccelerationVec), Size2D(VelocityDelta));
+
+		const FReg Skip = VectorBitwiseOr(SkipNoMotion, SkipNoAcceleration);
+		Store3(Batch, B::VelocityX, Lane, Select(Skip, Velocity, Add(NewVelocity, VelocityDelta)));
+	}
+
+	static void FallKernel(FFPMovementKernelBatch& Batch, int32 Lane)
+	{
+		typedef FFPMovementKernelBatch B;
+
+		FVec3x4 Velocity = Load3(Batch, B::VelocityX, Lane);
+		const FVec3x4 Input = Load3(Batch, B::InputX, Lane);
+		const FVec3x4 ForwardVector = Load3(Batch, B::ForwardX, Lane);
+		const FVec3x4 RightVector = Load3(Batch, B::RightX, Lane);
+		const FVec3x4 InitialJumpVelocity = Load3(Batch, B::InitialJumpX, Lane);
+		const FReg DeltaTime = Load1(Batch, B::DeltaTime, Lane);
+		const FReg MaxAirSpeed = Load1(Batch, B::MaxAirSpeed, Lane);
+		const FReg AirAcceleration = Load1(Batch, B::AirAcceleration, Lane);
+		const FReg AirBrakingDeceleration = Load1(Batch, B::AirBrakingDeceleration, Lane);
+		const FReg TerminalVelocity = Load1(Batch, B::TerminalVelocity, Lane);
+		const FReg BrakeThreshold = Splat(-.1f);
+
+		const FVec3x4 LateralInputVector = ProjectOnTo(Input, RightVector);
+		const FVec3x4 ForwardVelocity = ProjectOnToNormal(Velocity, ForwardVector);
+		const FVec3x4 LateralVelocity = ProjectOnToNormal(Velocity, RightVector);
+		const FReg InputIsZero = IsNearlyZero(Input);
+
+		const FReg MaxForwardAirVelocity = VectorMin(MaxAirSpeed, VectorMax(Size2D(InitialJumpVelocity), VectorMultiply(MaxAirSpeed, Splat(.20f))));
+		const FVec3x4 TargetForwardVelocity = Select(InputIsZero, ForwardVelocity, Scale(ProjectOnToNormal(Input, ForwardVector), MaxForwardAirVelocity));
+
+		const FVec3x4 InputLateralTargetVelocity = Scale(LateralInputVector, Load1(Batch, B::MaxAirStrafe, Lane));
+		const FReg TargetLateralSpeed = VectorMax(Size(InputLateralTargetVelocity), Size(LateralVelocity));
+		const FVec3x4 TargetLateralVelocity = Select(InputIsZero, LateralVelocity, Scale(SafeNormal2D(InputLateralTargetVelocity), TargetLateralSpeed));
+
+		FVec3x4 TargetVelocity = Add(TargetForwardVelocity, TargetLateralVelocity);
+		TargetVelocity.Z = VectorSubtract(TargetVelocity.Z, TerminalVelocity);
+		FVec3x4 Acceleration = Sub(TargetVelocity, Velocity);
+
+		const FVec3x4 InputNormal2D = SafeNormal2D(Input);
+
+		const FVec3x4 ForwardAccelerationNormal = SafeNormal2D(ProjectOnToNormal(Acceleration, ForwardVector));
+		const FReg ForwardAccelerationDot = Dot3(ForwardAccelerationNormal, InputNormal2D);
+		const FVec3x4 ForwardBraking = Scale(ForwardAccelerationNormal, VectorMultiply(AirBrakingDeceleration, VectorNegate(ForwardAccelerationDot)));
+		// Turning bonus, see FPMovementCore::CalculateFallVelocity.
+		const FReg TurnAccelerationScalar = VectorMultiply(Size(Cross(ForwardVector, SafeNormal2D(Velocity))), VectorMax(VectorZeroFloat(), Dot3(SafeNormal2D(InitialJumpVelocity), Negate(LateralInputVector))));
+		const FReg ForwardAirAcceleration = VectorMultiply(AirAcceleration, VectorMultiplyAdd(TurnAccelerationScalar, Splat(2.0f), Splat(1.0f)));
+		const FVec3x4 ForwardAcceleration = Select(VectorCompareLE(ForwardAccelerationDot, BrakeThreshold), ForwardBraking, Scale(ForwardAccelerationNormal, ForwardAirAcceleration));
+
+		const FVec3x4 LateralAccelerationNormal = SafeNormal2D(ProjectOnToNormal(Acceleration, RightVector));
+		const FReg LateralAccelerationDot = Dot3(LateralAccelerationNormal, InputNormal2D);
+		const FVec3x4 LateralBraking = Scale(LateralAccelerationNormal, VectorMultiply(AirBrakingDeceleration, VectorNegate(LateralAccelerationDot)));
+		const FVec3x4 LateralAcceleration = Select(VectorCompareLE(LateralAccelerationDot, BrakeThreshold), LateralBraking, Scale(LateralAccelerationNormal, AirAcceleration));
+
+		FVec3x4 VelocityDelta = Add(LateralAcceleration, ForwardAcceleration);
+
+		// Subtract the deceleration vector from the velocity to allow the player to change directions, scaled by friction.
+		const FReg NoAcceleration2D = IsNearlyZero(SafeNormal2D(Acceleration));
+		const FVec3x4 Velocity2D = { Velocity.X, Velocity.Y, VectorZeroFloat() };
+		const FReg FrictionScale = VectorMultiply(DeltaTime, Load1(Batch, B::AirFrictionFactor, Lane));
+		const FVec3x4 FrictionVelocity = Sub(Velocity, Scale(Sub(Velocity2D, Scale(SafeNormal2D(VelocityDelta), Size2D(Velocity2D))), FrictionScale));
+		Acceleration = Select(NoAcceleration2D, Acceleration, Sub(TargetVelocity, FrictionVelocity));
+		Velocity = Select(NoAcceleration2D, Velocity, FrictionVelocity);
+
+		const FReg ClampMask = VectorCompareGT(Size2D(VelocityDelta), Size2D(Acceleration));
+		VelocityDelta = ScaleWhere(ClampMask, VelocityDelta, Size2D(Acceleration), Size2D(VelocityDelta));
+
+		VelocityDelta.Z = Load1(Batch, B::GravityZ, Lane);
+		Velocity = Add(Velocity, Scale(VelocityDelta, DeltaTime));
+		Velocity.Z = VectorMax(Velocity.Z, VectorNegate(TerminalVelocity));
+
+		Store3(Batch, B::VelocityX, Lane, Velocity);
+	}
+
+	static void SlideKernel(FFPMovementKernelBatch& Batch, int32 Lane)
+	{
+		typedef FFPMovementKernelBatch B;
+
+		const FVec3x4 Velocity = Load3(Batch, B::VelocityX, Lane);
+		const FVec3x4 Input = Load3(Batch, B::InputX, Lane);
+		const FVec3x4 FloorNormal = Load3(Batch, B::FloorNormalX, Lane);
+		const FReg DeltaTime = Load1(Batch, B::DeltaTime, Lane);
+		const FReg One = Splat(1.0f);
+
+		// VectorPlaneProject(DownVector, FloorNormal) expanded, since DownVector only has a Z component.
+		const FVec3x4 DownOnFloor = {
+			VectorMultiply(FloorNormal.X, FloorNormal.Z),
+			VectorMultiply(FloorNormal.Y, FloorNormal.Z),
+			VectorMultiplyAdd(FloorNormal.Z, FloorNormal.Z, Splat(-1.0f))
+		};
+		const FVec3x4 GravityAccelerationDirection = SafeNormal(DownOnFloor);
+		const FReg GravityAccelerationRatio = VectorDivide(VectorSubtract(One, FloorNormal.Z), VectorSubtract(One, Load1(Batch, B::SlideFloorZ, Lane)));
+		const FVec3x4 GravitationalAccel = Scale(GravityAccelerationDirection, VectorMultiply(Load1(Batch, B::SlideGravityAcceleration, Lane), GravityAccelerationRatio));
+
+		// If we are moving perpindicular to the gravity vector, apply slide friction.
+		const FVec3x4 VelocityNormal = SafeNormal(Velocity);
+		const FVec3x4 VelocityNormal2D = SafeNormal2D(Velocity);
+		const FReg ApplyFriction = VectorCompareLE(VectorAbs(Dot3(GravityAccelerationDirection, VelocityNormal)), Splat(.1f));
+		const FReg FrictionScale = VectorMultiply(VectorMultiply(Size2D(Velocity), Load1(Batch, B::SlideFrictionFactor, Lane)), VectorSubtract(One, GravityAccelerationRatio));
+		const FVec3x4 SlideFriction = Select(ApplyFriction, Scale(Negate(VelocityNormal2D), FrictionScale), Zero3());
+
+		// Consider slide input deceleration.
+		const FReg InputVelocityDot = Dot3(VelocityNormal2D, SafeNormal2D(Input));
+		const FReg ApplyBraking = VectorCompareLE(InputVelocityDot, Splat(-.45f));
+		const FVec3x4 InputAcceleration = Select(ApplyBraking, Scale(VelocityNormal, VectorMultiply(InputVelocityDot, Load1(Batch, B::SlideBrakingDeceleration, Lane))), Zero3());
+
+		const FVec3x4 FinalAcceleration = Scale(Add(Add(GravitationalAccel, SlideFriction), InputAcceleration), DeltaTime);
+
+		Store3(Batch, B::VelocityX, Lane, Add(Velocity, FinalAcceleration));
+		Store3(Batch, B::GravAccelX, Lane, GravitationalAccel);
+	}
+}
+
+void FPMovementCore::RunKernelBatch(FFPMovementKernelBatch& Batch, int32 StartLane, int32 EndLane)
+{
+	check(StartLane % FFPMovementKernelBatch::LaneWidth == 0);
+	EndLane = FMath::Min(EndLane, Batch.NumPadded());
+
+	typedef void (*FKernelFunction)(FFPMovementKernelBatch&, int32);
+	FKernelFunction KernelFunction = nullptr;
+	switch (Batch.GetKernel())
+	{
+		case EFPMovementKernel::Ground:
+			KernelFunction = &FPMovementCoreBatch::GroundKernel;
+			break;
+		case EFPMovementKernel::Fall:
+			KernelFunction = &FPMovementCoreBatch::FallKernel;
+			break;
+		case EFPMovementKernel::Slide:
+			KernelFunction = &FPMovementCoreBatch::SlideKernel;
+			break;
+	}
+
+	for (int32 Lane = StartLane; Lane < EndLane; Lane += FFPMovementKernelBatch::LaneWidth)
+	{
+		KernelFunction(Batch, Lane);
+	}
+}
+
+void FPMovementCore::RunKernelBatch(FFPMovementKernelBatch& Batch)
+{
+	RunKernelBatch(Batch, 0, Batch.NumPadded());
+}
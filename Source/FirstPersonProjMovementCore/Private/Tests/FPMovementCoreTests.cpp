@@ -0,0 +1,281 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FPMovementCore.h"
+#include "FPMovementCoreBatch.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace FPMovementCoreTests
+{
+	constexpr EAutomationTestFlags::Type TestFlags = EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter;
+
+	constexpr float Tolerance = 0.01f;
+
+	/** Fraction of random batch lanes allowed outside BatchKernelTolerance, for lanes close enough to a branch threshold to take the other branch. */
+	constexpr double MaxBatchFailureFraction = 0.001;
+
+	static FFPMovementState MakeState(const FVector& Velocity)
+	{
+		FFPMovementState State;
+		State.Velocity = Velocity;
+		return State;
+	}
+
+	/** A job with state spread over the ranges a pawn sees in play, including zero input. */
+	static FFPMovementKernelJob MakeRandomJob(EFPMovementKernel Kernel, FRandomStream& RandomStream)
+	{
+		FFPMovementKernelJob Job;
+		Job.Kernel = Kernel;
+		Job.DeltaTime = RandomStream.FRandRange(1.0f / 120.0f, 1.0f / 30.0f);
+		Job.InputVector = RandomStream.FRand() < .25f ? FVector::ZeroVector : FVector(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f), 0.0f);
+		Job.State.Velocity = FVector(RandomStream.FRandRange(-900.0f, 900.0f), RandomStream.FRandRange(-900.0f, 900.0f), Kernel == EFPMovementKernel::Ground ? 0.0f : RandomStream.FRandRange(-600.0f, 400.0f));
+		Job.State.InitialJumpVelocity = FVector(RandomStream.FRandRange(-700.0f, 700.0f), RandomStream.FRandRange(-700.0f, 700.0f), 0.0f);
+		Job.State.CrouchFrac = RandomStream.FRand();
+		Job.State.bIsSprinting = RandomStream.FRand() < .5f;
+
+		const float Yaw = RandomStream.FRandRange(0.0f, 2.0f * UE_PI);
+		Job.FallContext.ForwardVector = FVector(FMath::Cos(Yaw), FMath::Sin(Yaw), 0.0f);
+		Job.FallContext.RightVector = FVector(-FMath::Sin(Yaw), FMath::Cos(Yaw), 0.0f);
+		Job.FloorNormal = FVector(RandomStream.FRandRange(-.8f, .8f), RandomStream.FRandRange(-.8f, .8f), 1.0f).GetSafeNormal();
+		return Job;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementCoreGroundKernelTest, "FirstPersonProj.MovementCore.Kernels.Ground", FPMovementCoreTests::TestFlags)
+
+bool FFPMovementCoreGroundKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementCoreTests;
+
+	const FFPMovementTunables Tunables;
+	const float DeltaTime = 0.1f;
+
+	{
+		FFPMovementState State;
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector::ZeroVector, DeltaTime);
+		TestEqual(TEXT("Standing still without input stays still"), State.Velocity, FVector::ZeroVector);
+	}
+
+	{
+		FFPMovementState State;
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector(2.0f, 0.0f, 0.0f), DeltaTime);
+		TestEqual(TEXT("Input accelerates at WalkAcceleration, ignoring input length"), State.Velocity, FVector(Tunables.WalkAcceleration * DeltaTime, 0.0f, 0.0f), Tolerance);
+	}
+
+	{
+		FFPMovementState State = MakeState(FVector(Tunables.MaxWalkSpeed - 10.0f, 0.0f, 0.0f));
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector::ForwardVector, DeltaTime);
+		TestEqual(TEXT("Acceleration stops at MaxWalkSpeed"), State.Velocity, FVector(Tunables.MaxWalkSpeed, 0.0f, 0.0f), Tolerance);
+	}
+
+	{
+		FFPMovementState State = MakeState(FVector(500.0f, 0.0f, 0.0f));
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector::ZeroVector, DeltaTime);
+		TestEqual(TEXT("No input brakes at BrakingDecelerationWalking"), State.Velocity, FVector(500.0f - Tunables.BrakingDecelerationWalking * DeltaTime, 0.0f, 0.0f), Tolerance);
+	}
+
+	{
+		FFPMovementState State = MakeState(FVector(0.0f, Tunables.MaxSprintSpeed - 10.0f, 0.0f));
+		State.bIsSprinting = true;
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector::RightVector, DeltaTime);
+		TestEqual(TEXT("Sprinting accelerates up to MaxSprintSpeed"), State.Velocity, FVector(0.0f, Tunables.MaxSprintSpeed, 0.0f), Tolerance);
+	}
+
+	{
+		FFPMovementState State = MakeState(FVector(Tunables.MaxSpeedCrouched + 50.0f, 0.0f, 0.0f));
+		State.CrouchFrac = 1.0f;
+		FPMovementCore::CalculateGroundVelocity(State, Tunables, FVector::ForwardVector, DeltaTime);
+		TestEqual(TEXT("Crouching brakes down to MaxSpeedCrouched"), State.Velocity, FVector(Tunables.MaxSpeedCrouched, 0.0f, 0.0f), Tolerance);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementCoreFallKernelTest, "FirstPersonProj.MovementCore.Kernels.Fall", FPMovementCoreTests::TestFlags)
+
+bool FFPMovementCoreFallKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementCoreTests;
+
+	const FFPFallContext Context;
+	const float DeltaTime = 0.1f;
+
+	{
+		const FFPMovementTunables Tunables;
+		FFPMovementState State;
+		FPMovementCore::CalculateFallVelocity(State, Tunables, Context, FVector::ZeroVector, DeltaTime);
+		TestEqual(TEXT("Gravity accelerates a pawn at rest"), State.Velocity, FVector(0.0f, 0.0f, Context.GravityZ * DeltaTime), Tolerance);
+	}
+
+	{
+		const FFPMovementTunables Tunables;
+		FFPMovementState State = MakeState(FVector(0.0f, 0.0f, 10.0f - Context.TerminalVelocity));
+		FPMovementCore::CalculateFallVelocity(State, Tunables, Context, FVector::ZeroVector, DeltaTime);
+		TestEqual(TEXT("Falling speed is clamped to TerminalVelocity"), State.Velocity, FVector(0.0f, 0.0f, -Context.TerminalVelocity), Tolerance);
+	}
+
+	{
+		// Jumped forward at 500 cm/s and pulling back: friction turns the velocity towards the input, then air acceleration applies.
+		FFPMovementTunables Tunables;
+		Tunables.AirAcceleration = 600.0f;
+		FFPMovementState State = MakeState(FVector(500.0f, 0.0f, 0.0f));
+		State.InitialJumpVelocity = State.Velocity;
+		FPMovementCore::CalculateFallVelocity(State, Tunables, Context, FVector::BackwardVector, DeltaTime);
+
+		const float FrictionVelocityX = 500.0f - 2.0f * 500.0f * DeltaTime * Tunables.AirFrictionFactor;
+		const FVector Expected(FrictionVelocityX - Tunables.AirAcceleration * DeltaTime, 0.0f, Context.GravityZ * DeltaTime);
+		TestEqual(TEXT("Air control pulls back towards the input"), State.Velocity, Expected, Tolerance);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementCoreSlideKernelTest, "FirstPersonProj.MovementCore.Kernels.Slide", FPMovementCoreTests::TestFlags)
+
+bool FFPMovementCoreSlideKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementCoreTests;
+
+	const FFPMovementTunables Tunables;
+	const float DeltaTime = 0.1f;
+
+	// A slope facing +X, which pulls the pawn down along (0.8, 0, -0.6).
+	const FVector FloorNormal(0.6f, 0.0f, 0.8f);
+	const FVector DownSlope(0.8f, 0.0f, -0.6f);
+	const FVector ExpectedGravitationalAccel = DownSlope * Tunables.SlideGravityAcceleration * ((1.0f - FloorNormal.Z) / (1.0f - Tunables.SlideFloorZ));
+
+	{
+		FFPMovementState State;
+		FVector GravitationalAccel;
+		FPMovementCore::CalculateSlideVelocity(State, Tunables, FloorNormal, FVector::ZeroVector, DeltaTime, GravitationalAccel);
+		TestEqual(TEXT("Slope gravity scales with steepness"), GravitationalAccel, ExpectedGravitationalAccel, Tolerance);
+		TestEqual(TEXT("A pawn at rest accelerates down the slope"), State.Velocity, ExpectedGravitationalAccel * DeltaTime, Tolerance);
+	}
+
+	{
+		const FVector StartVelocity = DownSlope * 500.0f;
+		FFPMovementState State = MakeState(StartVelocity);
+		FVector GravitationalAccel;
+		FPMovementCore::CalculateSlideVelocity(State, Tunables, FloorNormal, FVector::BackwardVector, DeltaTime, GravitationalAccel);
+
+		const FVector BrakingAccel = -DownSlope * Tunables.SlideBrakingDeceleration;
+		TestEqual(TEXT("Input against the slide brakes at SlideBrakingDeceleration"), State.Velocity, StartVelocity + (ExpectedGravitationalAccel + BrakingAccel) * DeltaTime, Tolerance);
+	}
+
+	{
+		const FVector StartVelocity(0.0f, 400.0f, 0.0f);
+		FFPMovementState State = MakeState(StartVelocity);
+		FVector GravitationalAccel;
+		FPMovementCore::CalculateSlideVelocity(State, Tunables, FloorNormal, FVector::ZeroVector, DeltaTime, GravitationalAccel);
+
+		const float GravityAccelerationRatio = (1.0f - FloorNormal.Z) / (1.0f - Tunables.SlideFloorZ);
+		const FVector FrictionAccel = -StartVelocity * Tunables.SlideFrictionFactor * (1.0f - GravityAccelerationRatio);
+		TestEqual(TEXT("Sliding across the slope applies slide friction"), State.Velocity, StartVelocity + (ExpectedGravitationalAccel + FrictionAccel) * DeltaTime, Tolerance);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementCoreRunKernelTest, "FirstPersonProj.MovementCore.Kernels.RunKernel", FPMovementCoreTests::TestFlags)
+
+bool FFPMovementCoreRunKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementCoreTests;
+
+	const FFPMovementTunables Tunables;
+
+	for (const EFPMovementKernel Kernel : { EFPMovementKernel::Ground, EFPMovementKernel::Fall, EFPMovementKernel::Slide })
+	{
+		FFPMovementKernelJob Job;
+		Job.Kernel = Kernel;
+		Job.DeltaTime = 1.0f / 60.0f;
+		Job.InputVector = FVector(1.0f, 1.0f, 0.0f);
+		Job.FloorNormal = FVector(0.6f, 0.0f, 0.8f);
+		Job.State = MakeState(FVector(200.0f, -100.0f, 0.0f));
+		Job.State.CrouchFrac = 0.5f;
+
+		FFPMovementState Expected = Job.State;
+		FVector ExpectedGravitationalAccel = FVector::ZeroVector;
+		switch (Kernel)
+		{
+			case EFPMovementKernel::Ground:
+				FPMovementCore::CalculateGroundVelocity(Expected, Tunables, Job.InputVector, Job.DeltaTime);
+				break;
+			case EFPMovementKernel::Fall:
+				FPMovementCore::CalculateFallVelocity(Expected, Tunables, Job.FallContext, Job.InputVector, Job.DeltaTime);
+				break;
+			case EFPMovementKernel::Slide:
+				FPMovementCore::CalculateSlideVelocity(Expected, Tunables, Job.FloorNormal, Job.InputVector, Job.DeltaTime, ExpectedGravitationalAccel);
+				break;
+		}
+
+		const FFPMovementState StartState = Job.State;
+		FPMovementCore::RunKernel(Job, Tunables);
+
+		TestEqual(TEXT("RunKernel matches the kernel it dispatches to"), Job.Result.Velocity, Expected.Velocity);
+		TestEqual(TEXT("RunKernel reports the slope acceleration"), Job.GravitationalAccel, ExpectedGravitationalAccel);
+		TestEqual(TEXT("RunKernel leaves the start state alone"), Job.State.Velocity, StartState.Velocity);
+		TestEqual(TEXT("RunKernel carries the rest of the state over"), Job.Result.CrouchFrac, StartState.CrouchFrac);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFPMovementCoreBatchKernelTest, "FirstPersonProj.MovementCore.Kernels.Batch", FPMovementCoreTests::TestFlags)
+
+bool FFPMovementCoreBatchKernelTest::RunTest(const FString& Parameters)
+{
+	using namespace FPMovementCoreTests;
+
+	// Not a multiple of the lane width, so the padding lanes are exercised too.
+	constexpr int32 NumJobs = 100001;
+
+	FFPMovementTunables Tunables;
+	Tunables.MaxAirStrafe = 400.0f;
+	Tunables.AirAcceleration = 600.0f;
+	FRandomStream RandomStream(0x4651);
+
+	for (const EFPMovementKernel Kernel : { EFPMovementKernel::Ground, EFPMovementKernel::Fall, EFPMovementKernel::Slide })
+	{
+		TArray<FFPMovementKernelJob> ScalarJobs;
+		ScalarJobs.SetNum(NumJobs);
+
+		FFPMovementKernelBatch Batch;
+		Batch.Reset(Kernel, NumJobs);
+		for (int32 Index = 0; Index < NumJobs; ++Index)
+		{
+			ScalarJobs[Index] = MakeRandomJob(Kernel, RandomStream);
+			Batch.Gather(Index, ScalarJobs[Index], Tunables);
+			FPMovementCore::RunKernel(ScalarJobs[Index], Tunables);
+		}
+		Batch.FinalizeGather();
+		FPMovementCore::RunKernelBatch(Batch);
+
+		double MaxError = 0.0;
+		int32 NumFailures = 0;
+		for (int32 Index = 0; Index < NumJobs; ++Index)
+		{
+			FFPMovementKernelJob BatchJob = ScalarJobs[Index];
+			Batch.Scatter(Index, BatchJob);
+
+			double Error = FVector::Dist(BatchJob.Result.Velocity, ScalarJobs[Index].Result.Velocity);
+			if (Kernel == EFPMovementKernel::Slide)
+			{
+				Error = FMath::Max(Error, FVector::Dist(BatchJob.GravitationalAccel, ScalarJobs[Index].GravitationalAccel));
+			}
+
+			MaxError = FMath::Max(MaxError, Error);
+			NumFailures += Error > FPMovementCore::BatchKernelTolerance ? 1 : 0;
+		}
+
+		const FString KernelName = Kernel == EFPMovementKernel::Ground ? TEXT("Ground") : Kernel == EFPMovementKernel::Fall ? TEXT("Fall") : TEXT("Slide");
+		AddInfo(FString::Printf(TEXT("%s batch vs scalar: %d jobs, max error %.5f cm/s, %d outside BatchKernelTolerance"), *KernelName, NumJobs, MaxError, NumFailures));
+		TestTrue(FString::Printf(TEXT("%s batch lanes outside BatchKernelTolerance are rare enough to be branch flips"), *KernelName), NumFailures <= NumJobs * MaxBatchFailureFraction);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPMovementCore, Log, All);
+
+/**
+ * Movement tunables used by the velocity kernels.
+ * Mirrors the editable settings on UFPMovementComponent so the kernels can run without a component.
+ */
+struct FIRSTPERSONPROJMOVEMENTCORE_API FFPMovementTunables
+{
+	// Walk/Ground movement
+	float MaxWalkSpeed = 600.0f;
+	float MaxSprintSpeed = 750.0f;
+	float MaxSpeedCrouched = 300.0f;
+	float WalkAcceleration = 1024.0f;
+	float BrakingDecelerationWalking = 1024.0f;
+
+	// Jumping / Falling
+	float MaxAirSpeed = 1200.0f;
+	float MaxAirStrafe = 0.0f;
+	float AirAcceleration = 0.0f;
+	float AirBrakingDeceleration = 800.0f;
+	float AirFrictionFactor = 1.0f;
+
+	// Sliding
+	float SlideFrictionFactor = .3f;
+	float SlideBrakingDeceleration = 1500.0f;
+	float SlideGravityAcceleration = 1000.0f;
+	float SlideFloorZ = .31f;
+};
+
+/** Per pawn state read and written by the velocity kernels. */
+struct FIRSTPERSONPROJMOVEMENTCORE_API FFPMovementState
+{
+	FVector Velocity = FVector::ZeroVector;
+
+	/** Lateral velocity at the moment the pawn started falling. */
+	FVector InitialJumpVelocity = FVector::ZeroVector;
+
+	float CrouchFrac = 0.0f;
+
+	bool bIsSprinting = false;
+};
+
+/** World and orientation inputs needed to integrate falling velocity. */
+struct FIRSTPERSONPROJMOVEMENTCORE_API FFPFallContext
+{
+	FVector ForwardVector = FVector::ForwardVector;
+	FVector RightVector = FVector::RightVector;
+	float GravityZ = -980.0f;
+	float TerminalVelocity = 4000.0f;
+};
+
+/** Which velocity kernel a job runs. */
+enum class EFPMovementKernel : uint8
+{
+	Ground,
+	Fall,
+	Slide,
+};
+
+/**
+ * One kernel invocation captured as plain data so it can be computed away from the component,
+ * e.g. in a parallel batch, and consumed later if the component still has the same inputs.
+ */
+struct FIRSTPERSONPROJMOVEMENTCORE_API FFPMovementKernelJob
+{
+	EFPMovementKernel Kernel = EFPMovementKernel::Ground;
+
+	float DeltaTime = 0.0f;
+
+	FVector InputVector = FVector::ZeroVector;
+
+	/** Used by the fall kernel only. */
+	FFPFallContext FallContext;
+
+	/** Used by the slide kernel only. */
+	FVector FloorNormal = FVector::UpVector;
+
+	/** State before the kernel runs. */
+	FFPMovementState State;
+
+	/** State after the kernel runs. */
+	FFPMovementState Result;
+
+	/** Slope acceleration reported by the slide kernel. */
+	FVector GravitationalAccel = FVector::ZeroVector;
+
+	/** Returns true if Other would produce exactly the same result as this job. */
+	bool HasSameInputs(const FFPMovementKernelJob& Other) const;
+};
+
+/**
+ * Stateless velocity kernels for first person movement.
+ * These contain no world queries, so they can be benchmarked and tuned in isolation.
+ */
+namespace FPMovementCore
+{
+	/** Accelerate or brake the 2D velocity towards the input direction at the current max ground speed. */
+	FIRSTPERSONPROJMOVEMENTCORE_API void CalculateGroundVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FVector& InputVector, float DeltaTime);
+
+	/** Apply air control, air braking and gravity to the velocity. */
+	FIRSTPERSONPROJMOVEMENTCORE_API void CalculateFallVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FFPFallContext& Context, const FVector& InputVector, float DeltaTime);
+
+	/**
+	 * Apply slope gravity, slide friction and braking to the velocity.
+	 *
+	 * @param FloorNormal				Normal of the surface being slid on.
+	 * @param OutGravitationalAccelVec	[Out] Acceleration applied by the slope this step.
+	 */
+	FIRSTPERSONPROJMOVEMENTCORE_API void CalculateSlideVelocity(FFPMovementState& State, const FFPMovementTunables& Tunables, const FVector& FloorNormal, const FVector& InputVector, float DeltaTime, FVector& OutGravitationalAccelVec);
+
+	/** Run the kernel selected by the job, filling in Job.Result and Job.GravitationalAccel. */
+	FIRSTPERSONPROJMOVEMENTCORE_API void RunKernel(FFPMovementKernelJob& Job, const FFPMovementTunables& Tunables);
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FPMovementCore.h"
+
+/**
+ * Structure-of-arrays batch of kernel jobs that all run the same velocity kernel.
+ * Every stream is padded to a multiple of four lanes so the SIMD kernels can load whole registers.
+ */
+struct FIRSTPERSONPROJMOVEMENTCORE_API FFPMovementKernelBatch
+{
+	enum EStream : int32
+	{
+		VelocityX, VelocityY, VelocityZ,
+		InputX, InputY, InputZ,
+		ForwardX, ForwardY, ForwardZ,
+		RightX, RightY, RightZ,
+		InitialJumpX, InitialJumpY, InitialJumpZ,
+		FloorNormalX, FloorNormalY, FloorNormalZ,
+		GravAccelX, GravAccelY, GravAccelZ,
+		DeltaTime,
+		MaxGroundSpeed,
+		WalkAcceleration,
+		BrakingDeceleration,
+		MaxAirSpeed,
+		MaxAirStrafe,
+		AirAcceleration,
+		AirBrakingDeceleration,
+		AirFrictionFactor,
+		GravityZ,
+		TerminalVelocity,
+		SlideFrictionFactor,
+		SlideBrakingDeceleration,
+		SlideGravityAcceleration,
+		SlideFloorZ,
+		NumStreams
+	};
+
+	static constexpr int32 LaneWidth = 4;
+
+	/** Clear the batch and size it for NumJobs jobs of the given kernel. */
+	void Reset(EFPMovementKernel InKernel, int32 NumJobs);
+
+	/** Write a job into lane Index. Index must be less than the NumJobs passed to Reset. */
+	void Gather(int32 Index, const FFPMovementKernelJob& Job, const FFPMovementTunables& Tunables);
+
+	/** Fill the padding lanes. Call once after all jobs are gathered. */
+	void FinalizeGather();
+
+	/** Read the results of lane Index back into the job. */
+	void Scatter(int32 Index, FFPMovementKernelJob& Job) const;
+
+	EFPMovementKernel GetKernel() const { return Kernel; }
+
+	int32 Num() const { return NumJobs; }
+
+	int32 NumPadded() const { return PaddedNum; }
+
+	float* GetStream(EStream Stream) { return Data.GetData() + Stream * PaddedNum; }
+
+	const float* GetStream(EStream Stream) const { return Data.GetData() + Stream * PaddedNum; }
+
+private:
+
+	EFPMovementKernel Kernel = EFPMovementKernel::Ground;
+
+	int32 NumJobs = 0;
+
+	int32 PaddedNum = 0;
+
+	TArray<float, TAlignedHeapAllocator<16>> Data;
+};
+
+namespace FPMovementCore
+{
+	/**
+	 * Maximum per component velocity difference, in cm/s, between the batch kernels and the scalar kernels.
+	 * The batch kernels integrate in single precision, while FVector is double precision, so results differ by rounding.
+	 * Lanes sitting exactly on a branch threshold (e.g. IsNearlyZero) can still take the other branch.
+	 */
+	constexpr float BatchKernelTolerance = 0.05f;
+
+	/** Run the batch kernel on lanes [StartLane, EndLane). StartLane must be a multiple of the lane width, EndLane is clamped to the padded size. */
+	FIRSTPERSONPROJMOVEMENTCORE_API void RunKernelBatch(FFPMovementKernelBatch& Batch, int32 StartLane, int32 EndLane);
+
+	/** Run the batch kernel on every lane. */
+	FIRSTPERSONPROJMOVEMENTCORE_API void RunKernelBatch(FFPMovementKernelBatch& Batch);
+}